@@ -0,0 +1,462 @@
+/*
+  ==============================================================================
+
+    Golden.cpp
+    Golden-response sweep: kernel, MonoChain and curve against references.
+
+  ==============================================================================
+*/
+
+#include "Harness.h"
+#include "../../Source/ResponseExport.h"
+#include <complex>
+
+namespace
+{
+    //==============================================================================
+    // explicit tolerances, every check below fails the run when exceeded
+
+    // errors in the time domain are relative to the larger of the response and the unit
+    // impulse that went in, so responses buried in the stop band aren't judged on noise
+
+    // FilterKernel against MonoChain, max abs difference. both run the same float TDF-II
+    // recursion, so anything above rounding noise is a bug
+    constexpr double kernelTolerance = 1.0e-6;
+
+    // the curve ResponseCurveComponent draws against the kernel's sections evaluated in double
+    constexpr double curveToleranceDB = 1.0e-3;
+
+    // only gated where every band is at or above conditionRatio * sampleRate. lower down the
+    // float biquad formulas lose most of their precision (1 + a1 + a2 nears float epsilon)
+    // and the recursion's rounding noise grows with it. that's reported, but it's a limit of
+    // the float designs rather than a regression
+    constexpr double conditionRatio = 1.0e-3;
+
+    // the other cut families have poles of far higher Q than the Butterworth (up to ~57 for
+    // the 16th order elliptic), so their float designs hold the tolerance from higher up
+    constexpr double steepConditionRatio = 4.0e-3;
+
+    double getConditionRatio(CutType type)
+    {
+        return type == CutType_Butterworth ? conditionRatio : steepConditionRatio;
+    }
+
+    // MonoChain against its own coefficients run in double, rms error
+    constexpr double arithmeticToleranceDB = -40.0;
+
+    // float designs against double designs, per band, where the band is above -30 dB
+    constexpr double designToleranceDB = 0.25;
+    constexpr double designFloorDB = -30.0;
+
+    constexpr int impulseLength = 4096;
+    constexpr int numGridPoints = 512;
+
+    //==============================================================================
+    struct Case
+    {
+        ChainSettings settings;
+        double sampleRate;
+    };
+
+    juce::String describe(const Case& c)
+    {
+        const auto& s = c.settings;
+        return juce::String(c.sampleRate / 1000.0, 1) + " kHz"
+            + ", low cut " + juce::String(s.lowCutFreq) + " Hz " + juce::String(12 * (s.lowCutSlope + 1)) + " dB/oct " + getCutTypeName(s.lowCutType)
+            + ", high cut " + juce::String(s.highCutFreq) + " Hz " + juce::String(12 * (s.highCutSlope + 1)) + " dB/oct " + getCutTypeName(s.highCutType)
+            + ", peak " + juce::String(s.peakFreq) + " Hz " + juce::String(s.peakGainDB) + " dB Q " + juce::String(s.peakQ);
+    }
+
+    std::vector<Case> makeCases()
+    {
+        std::vector<Case> cases;
+
+        auto add = [&cases](double sampleRate, int lowSlope, int highSlope,
+                            float lowCut, float highCut, float peakFreq, float gain, float q, CutType type = CutType_Butterworth)
+            {
+                ChainSettings s;
+                s.lowCutFreq = lowCut;
+                s.lowCutSlope = Slope(lowSlope);
+                s.lowCutType = type;
+                s.highCutFreq = highCut;
+                s.highCutSlope = Slope(highSlope);
+                s.highCutType = type;
+                s.peakFreq = peakFreq;
+                s.peakGainDB = gain;
+                s.peakQ = q;
+                cases.push_back({ s, sampleRate });
+            };
+
+        // every slope pair at every rate, at the corners of the parameter ranges plus a typical setting
+        for (auto sampleRate : { 44100.0, 48000.0, 88200.0, 96000.0, 192000.0, 384000.0 })
+            for (int lowSlope = Slope_12; lowSlope <= Slope_96; ++lowSlope)
+                for (int highSlope = Slope_12; highSlope <= Slope_96; ++highSlope)
+                {
+                    add(sampleRate, lowSlope, highSlope, 80.f, 12000.f, 1000.f, 6.f, 1.f);
+
+                    for (auto lowCut : { 20.f, 200.f, 20000.f })
+                        for (auto highCut : { 20.f, 2000.f, 20000.f })
+                            for (auto peakFreq : { 20.f, 1000.f, 20000.f })
+                                for (auto gain : { -24.f, 24.f })
+                                    for (auto q : { 0.1f, 10.f })
+                                        add(sampleRate, lowSlope, highSlope, lowCut, highCut, peakFreq, gain, q);
+                }
+
+        // the other families at every slope, both cuts of the same type, a typical setting and the cut corners
+        for (auto sampleRate : { 44100.0, 48000.0, 88200.0, 96000.0, 192000.0, 384000.0 })
+            for (int type = CutType_LinkwitzRiley; type < NumCutTypes; ++type)
+                for (int slope = Slope_12; slope <= Slope_96; ++slope)
+                {
+                    add(sampleRate, slope, slope, 80.f, 12000.f, 1000.f, 6.f, 1.f, CutType(type));
+
+                    for (auto lowCut : { 20.f, 200.f, 20000.f })
+                        for (auto highCut : { 20.f, 2000.f, 20000.f })
+                            add(sampleRate, slope, slope, lowCut, highCut, 1000.f, 0.f, 1.f, CutType(type));
+                }
+
+        return cases;
+    }
+
+    //==============================================================================
+    struct DoubleSection
+    {
+        double b0 = 1, b1 = 0, b2 = 0, a1 = 0, a2 = 0;
+
+        std::complex<double> getResponse(std::complex<double> z1) const
+        {
+            const auto z2 = z1 * z1;
+            return (b0 + b1 * z1 + b2 * z2) / (1.0 + a1 * z1 + a2 * z2);
+        }
+    };
+
+    template<typename NumericType>
+    DoubleSection toDouble(const juce::dsp::IIR::Coefficients<NumericType>& coefficients)
+    {
+        const auto* c = coefficients.coefficients.begin();
+        if (coefficients.coefficients.size() == 5)
+            return { double(c[0]), double(c[1]), double(c[2]), double(c[3]), double(c[4]) };
+
+        return { double(c[0]), double(c[1]), 0.0, double(c[2]), 0.0 };  // first order
+    }
+
+    DoubleSection toDouble(const BiquadCoefficients& c)
+    {
+        return { c.b0, c.b1, c.b2, c.a1, c.a2 };
+    }
+
+    double getMagnitude(const std::vector<DoubleSection>& sections, double frequency, double sampleRate)
+    {
+        const auto z1 = std::polar(1.0, -juce::MathConstants<double>::twoPi * frequency / sampleRate);
+
+        std::complex<double> response(1.0);
+        for (const auto& section : sections)
+            response *= section.getResponse(z1);
+
+        return std::abs(response);
+    }
+
+    // the high precision reference: every band designed and evaluated in double
+    struct ReferenceBands
+    {
+        std::vector<DoubleSection> lowCut, peak, highCut;
+    };
+
+    ReferenceBands designReference(const Case& c)
+    {
+        using Design = juce::dsp::FilterDesign<double>;
+        const auto& s = c.settings;
+
+        ReferenceBands bands;
+        if (s.lowCutType == CutType_Butterworth)
+        {
+            for (auto& coefficients : Design::designIIRHighpassHighOrderButterworthMethod(s.lowCutFreq, c.sampleRate, (s.lowCutSlope + 1) * 2))
+                bands.lowCut.push_back(toDouble(*coefficients));
+        }
+        else
+        {
+            // FilterDesign has no other families, these are the same prototypes transformed in double
+            bands.lowCut.resize((size_t)s.lowCutSlope + 1);
+            designCut(bands.lowCut.data(), s.lowCutSlope + 1, s.lowCutType, true, double(s.lowCutFreq), c.sampleRate);
+        }
+
+        if (s.highCutType == CutType_Butterworth)
+        {
+            for (auto& coefficients : Design::designIIRLowpassHighOrderButterworthMethod(s.highCutFreq, c.sampleRate, (s.highCutSlope + 1) * 2))
+                bands.highCut.push_back(toDouble(*coefficients));
+        }
+        else
+        {
+            bands.highCut.resize((size_t)s.highCutSlope + 1);
+            designCut(bands.highCut.data(), s.highCutSlope + 1, s.highCutType, false, double(s.highCutFreq), c.sampleRate);
+        }
+
+        bands.peak.push_back(toDouble(*juce::dsp::IIR::Coefficients<double>::makePeakFilter(
+            c.sampleRate, s.peakFreq, s.peakQ, juce::Decibels::decibelsToGain(double(s.peakGainDB)))));
+
+        return bands;
+    }
+
+    // the float designs the plugin runs, band by band
+    ReferenceBands getDesignedBands(const ChainCoefficients& chainCoefficients)
+    {
+        const auto& s = chainCoefficients.settings;
+        ReferenceBands bands;
+        for (int i = 0; i <= s.lowCutSlope; ++i)
+            bands.lowCut.push_back(toDouble(*chainCoefficients.lowCut[i]));
+
+        bands.peak.push_back(toDouble(*chainCoefficients.peak));
+
+        for (int i = 0; i <= s.highCutSlope; ++i)
+            bands.highCut.push_back(toDouble(*chainCoefficients.highCut[i]));
+
+        return bands;
+    }
+
+    //==============================================================================
+    struct Worst
+    {
+        double value = -std::numeric_limits<double>::infinity();
+        int caseIndex = -1;
+
+        void update(double newValue, int index)
+        {
+            if (newValue > value)
+            {
+                value = newValue;
+                caseIndex = index;
+            }
+        }
+
+        void merge(const Worst& other) { update(other.value, other.caseIndex); }
+    };
+
+    struct Results
+    {
+        Worst kernel, curve, gatedArithmetic, ungatedArithmetic, gatedDesign, ungatedDesign;
+        std::vector<std::pair<int, juce::String>> failures;
+        int numGatedCases = 0, numGatedBands = 0;
+
+        void merge(const Results& other)
+        {
+            kernel.merge(other.kernel);
+            curve.merge(other.curve);
+            gatedArithmetic.merge(other.gatedArithmetic);
+            ungatedArithmetic.merge(other.ungatedArithmetic);
+            gatedDesign.merge(other.gatedDesign);
+            ungatedDesign.merge(other.ungatedDesign);
+            failures.insert(failures.end(), other.failures.begin(), other.failures.end());
+            numGatedCases += other.numGatedCases;
+            numGatedBands += other.numGatedBands;
+        }
+    };
+
+    void verifyCase(const Case& c, int caseIndex, Results& results)
+    {
+        const auto chainCoefficients = makeChainCoefficients(c.settings, c.sampleRate);
+        const auto maxFrequency = juce::jmin(20000.0, c.sampleRate * 0.5 * 0.999);
+
+        auto fail = [&](const juce::String& check, double value)
+            {
+                results.failures.push_back({ caseIndex, check + " " + juce::String(value, 6) });
+            };
+
+        // -- impulse responses: MonoChain, FilterKernel, and the kernel's sections in double --
+        const auto chainImpulse = renderImpulseResponse(c.settings, c.sampleRate, impulseLength);
+
+        DSPArena arena;
+        arena.reset(FilterKernel::getRequiredBytes(1));
+        FilterKernel kernel;
+        kernel.prepare(arena, 1);
+        kernel.setCoefficients(chainCoefficients);
+        kernel.reset();
+
+        // same block size as renderImpulseResponse, both flush denormals at block ends
+        std::vector<float> kernelImpulse((size_t)impulseLength, 0.f);
+        kernelImpulse[0] = 1.f;
+        kernel.process(kernelImpulse.data(), impulseLength, 0);
+
+        KernelCoefficients kernelCoefficients;
+        makeKernelCoefficients(kernelCoefficients, chainCoefficients);
+
+        std::vector<DoubleSection> kernelSections;
+        for (int section = 0; section < KernelCoefficients::maxSections; ++section)
+            if (kernelCoefficients.isActive(section))
+                kernelSections.push_back(toDouble(kernelCoefficients.sections[(size_t)section]));
+
+        std::vector<double> exactImpulse((size_t)impulseLength, 0.0);
+        exactImpulse[0] = 1.0;
+        for (const auto& section : kernelSections)
+        {
+            double s1 = 0, s2 = 0;
+            for (auto& x : exactImpulse)
+            {
+                const auto y = section.b0 * x + s1;
+                s1 = section.b1 * x - section.a1 * y + s2;
+                s2 = section.b2 * x - section.a2 * y;
+                x = y;
+            }
+        }
+
+        double peak = 0, maxDifference = 0, errorEnergy = 0, exactEnergy = 0;
+        const auto* chain = chainImpulse.getReadPointer(0);
+        for (size_t i = 0; i < (size_t)impulseLength; ++i)
+        {
+            peak = juce::jmax(peak, std::abs(double(chain[i])));
+            maxDifference = juce::jmax(maxDifference, std::abs(double(kernelImpulse[i]) - double(chain[i])));
+
+            const auto error = double(chain[i]) - exactImpulse[i];
+            errorEnergy += error * error;
+            exactEnergy += exactImpulse[i] * exactImpulse[i];
+        }
+
+        const auto kernelError = maxDifference / juce::jmax(peak, 1.0);
+        results.kernel.update(kernelError, caseIndex);
+        if (!(kernelError <= kernelTolerance))
+            fail("kernel vs MonoChain", kernelError);
+
+        const auto& s = c.settings;
+        const auto wellConditioned = s.lowCutFreq >= getConditionRatio(s.lowCutType) * c.sampleRate
+                                  && s.highCutFreq >= getConditionRatio(s.highCutType) * c.sampleRate
+                                  && s.peakFreq >= conditionRatio * c.sampleRate;
+
+        const auto arithmeticError = 10.0 * std::log10(juce::jmax(errorEnergy, 1.0e-300) / juce::jmax(exactEnergy, 1.0));
+        if (wellConditioned)
+        {
+            ++results.numGatedCases;
+            results.gatedArithmetic.update(arithmeticError, caseIndex);
+            if (!(arithmeticError <= arithmeticToleranceDB))
+                fail("MonoChain vs double (dB)", arithmeticError);
+        }
+        else
+        {
+            results.ungatedArithmetic.update(arithmeticError, caseIndex);
+        }
+
+        // -- magnitudes: what ResponseCurveComponent draws, against the kernel and the reference --
+        const auto designed = getDesignedBands(chainCoefficients);
+        const auto reference = designReference(c);
+
+        struct BandCheck
+        {
+            const std::vector<DoubleSection>& designed;
+            const std::vector<DoubleSection>& reference;
+            double frequency;
+            double conditionRatio;
+            double worst;
+        };
+
+        std::array<BandCheck, 3> bands
+        { {
+            { designed.lowCut, reference.lowCut, double(s.lowCutFreq), getConditionRatio(s.lowCutType), 0.0 },
+            { designed.peak, reference.peak, double(s.peakFreq), conditionRatio, 0.0 },
+            { designed.highCut, reference.highCut, double(s.highCutFreq), getConditionRatio(s.highCutType), 0.0 },
+        } };
+
+        double worstCurve = 0;
+        for (int i = 0; i < numGridPoints; ++i)
+        {
+            const auto frequency = juce::mapToLog10(double(i) / double(numGridPoints - 1), 20.0, maxFrequency);
+
+            // the same call ResponseCurveComponent makes per pixel, through the float coefficients
+            const auto drawn = getMagnitudeForFrequency(chainCoefficients, frequency);
+            const auto actual = getMagnitude(kernelSections, frequency, c.sampleRate);
+            const auto drawnDB = juce::Decibels::gainToDecibels(drawn, -300.0);
+            if (drawnDB > -120.0)
+                worstCurve = juce::jmax(worstCurve, std::abs(drawnDB - juce::Decibels::gainToDecibels(actual, -300.0)));
+
+            for (auto& band : bands)
+            {
+                const auto referenceDB = juce::Decibels::gainToDecibels(getMagnitude(band.reference, frequency, c.sampleRate), -300.0);
+                if (referenceDB < designFloorDB)
+                    continue;
+
+                const auto designedDB = juce::Decibels::gainToDecibels(getMagnitude(band.designed, frequency, c.sampleRate), -300.0);
+                band.worst = juce::jmax(band.worst, std::abs(designedDB - referenceDB));
+            }
+        }
+
+        results.curve.update(worstCurve, caseIndex);
+        if (!(worstCurve <= curveToleranceDB))
+            fail("curve vs kernel (dB)", worstCurve);
+
+        for (auto& band : bands)
+        {
+            if (band.frequency >= band.conditionRatio * c.sampleRate)
+            {
+                ++results.numGatedBands;
+                results.gatedDesign.update(band.worst, caseIndex);
+                if (!(band.worst <= designToleranceDB))
+                    fail("design vs double (dB) at " + juce::String(band.frequency) + " Hz", band.worst);
+            }
+            else
+            {
+                results.ungatedDesign.update(band.worst, caseIndex);
+            }
+        }
+    }
+}
+
+//==============================================================================
+void runGolden(const HarnessOptions&, PhaseTimer& timer)
+{
+    timer.begin("build cases");
+    const auto cases = makeCases();
+    const auto numCases = (int)cases.size();
+
+    // cases are independent, every core pulls the next one until they're gone
+    const auto numThreads = juce::jmax(1, juce::SystemStats::getNumCpus());
+    std::vector<Results> threadResults((size_t)numThreads);
+    std::atomic<int> nextCase{ 0 }, remaining{ numThreads };
+    juce::WaitableEvent finished;
+
+    timer.begin("verify", numCases, "case");
+    {
+        juce::ThreadPool pool(numThreads);
+        for (int t = 0; t < numThreads; ++t)
+        {
+            pool.addJob([&, t]
+                {
+                    for (int i = nextCase++; i < numCases; i = nextCase++)
+                        verifyCase(cases[(size_t)i], i, threadResults[(size_t)t]);
+
+                    if (--remaining == 0)
+                        finished.signal();
+                });
+        }
+
+        finished.wait();
+    }
+    timer.end();
+
+    Results results;
+    for (const auto& r : threadResults)
+        results.merge(r);
+
+    auto worstLine = [&cases](const juce::String& label, const Worst& worst, int decimals)
+        {
+            if (worst.caseIndex < 0)
+                return label + "n/a";
+
+            return label + juce::String(worst.value, decimals) + "  (" + describe(cases[(size_t)worst.caseIndex]) + ")";
+        };
+
+    timer.addNote(juce::String(numCases) + " cases on " + juce::String(numThreads) + " threads");
+    const auto belowCondition = " (below " + juce::String(conditionRatio) + " fs, " + juce::String(steepConditionRatio)
+                              + " fs for the steeper families, not gated)";
+
+    timer.addNote(juce::String(results.numGatedCases) + " cases and " + juce::String(results.numGatedBands) + " bands well conditioned");
+    timer.addNote(worstLine("kernel vs MonoChain, max:       ", results.kernel, 9));
+    timer.addNote(worstLine("curve vs kernel, max dB:        ", results.curve, 6));
+    timer.addNote(worstLine("MonoChain vs double, rms dB:    ", results.gatedArithmetic, 1));
+    timer.addNote(worstLine("design vs double, max dB:       ", results.gatedDesign, 3));
+    timer.addNote(worstLine("MonoChain vs double, rms dB:    ", results.ungatedArithmetic, 1) + belowCondition);
+    timer.addNote(worstLine("design vs double, max dB:       ", results.ungatedDesign, 3) + belowCondition);
+
+    std::sort(results.failures.begin(), results.failures.end());
+    constexpr size_t maxListed = 10;
+    for (size_t i = 0; i < juce::jmin(maxListed, results.failures.size()); ++i)
+        timer.addFailure(results.failures[i].second + "  (" + describe(cases[(size_t)results.failures[i].first]) + ")");
+
+    if (results.failures.size() > maxListed)
+        timer.addFailure(juce::String((int)(results.failures.size() - maxListed)) + " more");
+}
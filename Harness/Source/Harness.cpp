@@ -0,0 +1,170 @@
+/*
+  ==============================================================================
+
+    Harness.cpp
+    Headless driver for EQtutAudioProcessor: scenarios, timing and test signals.
+
+  ==============================================================================
+*/
+
+#include "Harness.h"
+
+//==============================================================================
+PhaseTimer::PhaseTimer(const juce::String& name) :
+    scenarioName(name)
+{
+}
+
+void PhaseTimer::begin(const juce::String& phase, juce::int64 numIterations, const juce::String& unit)
+{
+    end();
+
+    current = { phase, 0, numIterations, unit };
+    running = true;
+    startTime = juce::Time::getMillisecondCounterHiRes();
+}
+
+void PhaseTimer::end()
+{
+    if (!running)
+        return;
+
+    current.milliseconds = juce::Time::getMillisecondCounterHiRes() - startTime;
+    phases.add(current);
+    running = false;
+}
+
+void PhaseTimer::addNote(const juce::String& note)
+{
+    notes.add(note);
+}
+
+void PhaseTimer::addFailure(const juce::String& failure)
+{
+    notes.add("FAIL " + failure);
+    failed = true;
+}
+
+void PhaseTimer::print() const
+{
+    std::cout << scenarioName << std::endl;
+
+    for (const auto& phase : phases)
+    {
+        juce::String line;
+        line << "  " << phase.name.paddedRight(' ', 24)
+             << juce::String(phase.milliseconds, 2).paddedLeft(' ', 10) << " ms";
+
+        if (phase.numIterations > 0)
+        {
+            const auto micros = phase.milliseconds * 1000.0 / double(phase.numIterations);
+            line << juce::String(micros, 3).paddedLeft(' ', 12) << " us/" << phase.unit;
+        }
+
+        std::cout << line << std::endl;
+    }
+
+    for (const auto& note : notes)
+        std::cout << "  " << note << std::endl;
+
+    std::cout << std::endl;
+}
+
+//==============================================================================
+SignalGenerator::SignalGenerator(juce::int64 seed, double rate) :
+    random(seed),
+    sampleRate(rate)
+{
+}
+
+void SignalGenerator::fill(juce::AudioBuffer<float>& buffer)
+{
+    constexpr double sweepSeconds = 10.0;
+    constexpr float level = 0.125f;
+
+    for (int i = 0; i < buffer.getNumSamples(); ++i)
+    {
+        // three-pole approximation of a -3 dB/oct slope
+        const auto white = random.nextFloat() * 2.f - 1.f;
+        pinkState[0] = 0.99765f * pinkState[0] + white * 0.0990460f;
+        pinkState[1] = 0.96300f * pinkState[1] + white * 0.2965164f;
+        pinkState[2] = 0.57000f * pinkState[2] + white * 1.0526913f;
+        const auto pink = (pinkState[0] + pinkState[1] + pinkState[2] + white * 0.1848f) * 0.25f;
+
+        // 20 Hz to 20 kHz and back to 20 Hz every sweepSeconds
+        const auto t = std::fmod(double(position) / sampleRate, sweepSeconds) / sweepSeconds;
+        const auto frequency = juce::mapToLog10(t < 0.5 ? t * 2.0 : 2.0 - t * 2.0, 20.0, 20000.0);
+        sweepPhase = std::fmod(sweepPhase + juce::MathConstants<double>::twoPi * frequency / sampleRate,
+                               juce::MathConstants<double>::twoPi);
+
+        const auto sample = level * (pink + 0.5f * float(std::sin(sweepPhase)));
+        for (int ch = 0; ch < buffer.getNumChannels(); ++ch)
+            buffer.setSample(ch, i, sample);
+
+        ++position;
+    }
+}
+
+//==============================================================================
+void Checksum::add(const juce::AudioBuffer<float>& buffer)
+{
+    for (int ch = 0; ch < buffer.getNumChannels(); ++ch)
+    {
+        auto* samples = buffer.getReadPointer(ch);
+        for (int i = 0; i < buffer.getNumSamples(); ++i)
+        {
+            juce::uint32 bits;
+            std::memcpy(&bits, samples + i, sizeof(bits));
+
+            hash ^= bits;
+            hash *= 1099511628211ull;
+        }
+    }
+}
+
+//==============================================================================
+std::unique_ptr<EQtutAudioProcessor> createPreparedProcessor(double sampleRate, int blockSize)
+{
+    auto processor = std::make_unique<EQtutAudioProcessor>();
+    processor->setRateAndBufferSizeDetails(sampleRate, blockSize);
+    processor->prepareToPlay(sampleRate, blockSize);
+    return processor;
+}
+
+void automate(EQtutAudioProcessor& processor, Param param, float normalisedValue)
+{
+    auto& parameter = processor.parameters.getParameter(param);
+    parameter.setValueNotifyingHost(juce::jlimit(0.f, 1.f, normalisedValue));
+}
+
+//==============================================================================
+namespace
+{
+    thread_local juce::int64 numAllocations = 0;
+}
+
+juce::int64 getNumAllocations()
+{
+    return numAllocations;
+}
+
+// every plain new in the harness goes through here, so a scenario can tell a path that allocates
+void* operator new(std::size_t size)
+{
+    ++numAllocations;
+
+    if (auto* memory = std::malloc(size > 0 ? size : 1))
+        return memory;
+
+    throw std::bad_alloc();
+}
+
+void operator delete(void* memory) noexcept
+{
+    std::free(memory);
+}
+
+void operator delete(void* memory, std::size_t) noexcept
+{
+    std::free(memory);
+}
@@ -0,0 +1,117 @@
+/*
+  ==============================================================================
+
+    Harness.h
+    Headless driver for EQtutAudioProcessor: scenarios, timing and test signals.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include "../../Source/PluginProcessor.h"
+#include "../../Source/PluginEditor.h"
+#include "../../Source/Trace.h"
+
+struct HarnessOptions
+{
+    double sampleRate = 48000;
+    int blockSize = 512;
+    int numBlocks = 2000;
+    int numInstances = 200;
+    int numPresets = 100000;
+    juce::int64 seed = 1;
+    bool withEditor = false;
+    juce::File inputFile;
+    juce::File traceFile;
+};
+
+/**
+ wall-clock time of a scenario's phases. a phase runs from begin() to the next
+ begin() or end(), and can be divided by an iteration count for a per-unit figure.
+ */
+class PhaseTimer
+{
+public:
+    explicit PhaseTimer(const juce::String& scenarioName);
+
+    void begin(const juce::String& phase, juce::int64 numIterations = 0, const juce::String& unit = {});
+    void end();
+
+    // extra lines for the report, e.g. checksums or counters
+    void addNote(const juce::String& note);
+
+    // a note that also fails the run, the harness exits with an error
+    void addFailure(const juce::String& failure);
+    bool hasFailed() const { return failed; }
+
+    void print() const;
+
+private:
+    struct Phase
+    {
+        juce::String name;
+        double milliseconds;
+        juce::int64 numIterations;
+        juce::String unit;
+    };
+
+    juce::String scenarioName;
+    juce::Array<Phase> phases;
+    juce::StringArray notes;
+
+    bool running = false;
+    bool failed = false;
+    double startTime = 0;
+    Phase current;
+};
+
+/**
+ deterministic test signal: white noise shaped towards pink plus a slow log sine sweep,
+ at around -18 dBFS. the same seed always gives the same samples.
+ */
+class SignalGenerator
+{
+public:
+    SignalGenerator(juce::int64 seed, double sampleRate);
+
+    void fill(juce::AudioBuffer<float>& buffer);
+
+private:
+    juce::Random random;
+    double sampleRate;
+    double sweepPhase = 0;
+    juce::int64 position = 0;
+    std::array<float, 3> pinkState{};
+};
+
+// FNV-1a over the bit patterns of every output sample, tells identical runs from different ones
+struct Checksum
+{
+    void add(const juce::AudioBuffer<float>& buffer);
+    juce::String toString() const { return juce::String::toHexString((juce::int64)hash); }
+
+    juce::uint64 hash = 14695981039346656037ull;
+};
+
+// what a host does before the first block: rate and block size, then prepareToPlay
+std::unique_ptr<EQtutAudioProcessor> createPreparedProcessor(double sampleRate, int blockSize);
+
+// sets a parameter from the normalised range, like host automation
+void automate(EQtutAudioProcessor& processor, Param param, float normalisedValue);
+
+// operator new calls made so far on the calling thread, the difference around a call counts its allocations
+juce::int64 getNumAllocations();
+
+struct Scenario
+{
+    const char* name;
+    const char* description;
+    std::function<void(const HarnessOptions&, PhaseTimer&)> run;
+};
+
+const std::vector<Scenario>& getScenarios();
+
+// kernel, MonoChain and response curve against double precision references, in Golden.cpp
+void runGolden(const HarnessOptions& options, PhaseTimer& timer);
@@ -0,0 +1,123 @@
+/*
+  ==============================================================================
+
+    Main.cpp
+    Command line entry point of the headless harness.
+
+  ==============================================================================
+*/
+
+#include "Harness.h"
+
+namespace
+{
+    void printUsage()
+    {
+        std::cout << "usage: EQtutHarness [scenario...] [options]" << std::endl
+                  << std::endl
+                  << "  --rate <Hz>          sample rate (48000)" << std::endl
+                  << "  --block-size <n>     samples per block (512)" << std::endl
+                  << "  --blocks <n>         blocks per phase (2000)" << std::endl
+                  << "  --instances <n>      instances in the session scenario (200)" << std::endl
+                  << "  --presets <n>        presets in the presets scenario's generated bank (100000)" << std::endl
+                  << "  --seed <n>           seed for signals and settings (1)" << std::endl
+                  << "  --editor             open editors in the session scenario" << std::endl
+                  << "  --input <file>       audio file for the file scenario" << std::endl
+                  << "  --trace <file>       write a Chrome trace of the last events when done" << std::endl
+                  << "  --list               list the scenarios" << std::endl
+                  << std::endl
+                  << "runs every scenario when none are named, exits with 2 if a check failed" << std::endl;
+    }
+}
+
+int main(int argc, char* argv[])
+{
+    // editors, timers and the analyzer service all need a message manager
+    juce::ScopedJuceInitialiser_GUI juceInitialiser;
+
+    juce::ArgumentList args(argc, argv);
+    HarnessOptions options;
+    juce::StringArray names;
+
+    for (int i = 0; i < args.size(); ++i)
+    {
+        const auto arg = args[i].text;
+        auto next = [&]() { return ++i < args.size() ? args[i].text : juce::String(); };
+
+        if (arg == "--rate")                options.sampleRate = next().getDoubleValue();
+        else if (arg == "--block-size")     options.blockSize = next().getIntValue();
+        else if (arg == "--blocks")         options.numBlocks = next().getIntValue();
+        else if (arg == "--instances")      options.numInstances = next().getIntValue();
+        else if (arg == "--presets")        options.numPresets = next().getIntValue();
+        else if (arg == "--seed")           options.seed = next().getLargeIntValue();
+        else if (arg == "--editor")         options.withEditor = true;
+        else if (arg == "--input")          options.inputFile = juce::File::getCurrentWorkingDirectory().getChildFile(next());
+        else if (arg == "--trace")          options.traceFile = juce::File::getCurrentWorkingDirectory().getChildFile(next());
+        else if (arg == "--help" || arg == "-h")
+        {
+            printUsage();
+            return 0;
+        }
+        else if (arg == "--list")
+        {
+            for (const auto& scenario : getScenarios())
+                std::cout << juce::String(scenario.name).paddedRight(' ', 16) << scenario.description << std::endl;
+            return 0;
+        }
+        else if (arg.startsWith("-"))
+        {
+            std::cerr << "unknown option " << arg << std::endl;
+            printUsage();
+            return 1;
+        }
+        else
+        {
+            names.add(arg);
+        }
+    }
+
+    if (options.sampleRate <= 0 || options.blockSize <= 0 || options.numBlocks <= 0 || options.numInstances <= 0 || options.numPresets <= 0)
+    {
+        std::cerr << "rate, block size, blocks, instances and presets must be positive" << std::endl;
+        return 1;
+    }
+
+    const auto& scenarios = getScenarios();
+    for (const auto& name : names)
+    {
+        if (std::none_of(scenarios.begin(), scenarios.end(), [&name](const Scenario& s) { return name == s.name; }))
+        {
+            std::cerr << "unknown scenario " << name << ", see --list" << std::endl;
+            return 1;
+        }
+    }
+
+    std::cout << "EQtutHarness: " << options.sampleRate << " Hz, " << options.blockSize << " samples, "
+              << options.numBlocks << " blocks, seed " << options.seed << std::endl << std::endl;
+
+    bool failed = false;
+    for (const auto& scenario : scenarios)
+    {
+        if (!names.isEmpty() && !names.contains(scenario.name))
+            continue;
+
+        PhaseTimer timer(scenario.name);
+        scenario.run(options, timer);
+        timer.print();
+
+        failed = failed || timer.hasFailed();
+    }
+
+    if (options.traceFile != juce::File())
+    {
+        if (!TraceLog::getInstance().writeChromeTrace(options.traceFile))
+        {
+            std::cerr << "couldn't write " << options.traceFile.getFullPathName() << std::endl;
+            return 1;
+        }
+
+        std::cout << "trace written to " << options.traceFile.getFullPathName() << std::endl;
+    }
+
+    return failed ? 2 : 0;
+}
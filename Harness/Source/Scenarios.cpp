@@ -0,0 +1,1593 @@
+/*
+  ==============================================================================
+
+    Scenarios.cpp
+    The harness's deterministic load scenarios.
+
+  ==============================================================================
+*/
+
+#include "Harness.h"
+#include <complex>
+#include <thread>
+
+namespace
+{
+    const std::array<Param, 7> bandParams
+    {
+        Param::LowCutFreq, Param::HighCutFreq, Param::PeakFreq, Param::PeakGain,
+        Param::PeakQ, Param::LowCutSlope, Param::HighCutSlope
+    };
+
+    // a different slow LFO per parameter, so every band moves every block
+    float getSweepValue(int blockIndex, int parameterIndex)
+    {
+        const auto rate = 0.003 * double(parameterIndex + 1);
+        return float(0.5 + 0.5 * std::sin(rate * double(blockIndex) + double(parameterIndex)));
+    }
+
+    void randomiseBands(EQtutAudioProcessor& processor, juce::Random& random)
+    {
+        for (auto param : bandParams)
+            automate(processor, param, random.nextFloat());
+    }
+
+    //==============================================================================
+    void runSession(const HarnessOptions& options, PhaseTimer& timer)
+    {
+        std::vector<std::unique_ptr<EQtutAudioProcessor>> instances;
+        instances.reserve((size_t)options.numInstances);
+
+        timer.begin("construct", options.numInstances, "instance");
+        for (int i = 0; i < options.numInstances; ++i)
+            instances.push_back(std::make_unique<EQtutAudioProcessor>());
+
+        timer.begin("prepare", options.numInstances, "instance");
+        for (auto& instance : instances)
+        {
+            instance->setRateAndBufferSizeDetails(options.sampleRate, options.blockSize);
+            instance->prepareToPlay(options.sampleRate, options.blockSize);
+        }
+
+        // every instance gets its own settings, as on a real console
+        juce::Random random(options.seed);
+        for (auto& instance : instances)
+            randomiseBands(*instance, random);
+
+        std::vector<std::unique_ptr<juce::AudioProcessorEditor>> editors;
+        if (options.withEditor)
+        {
+            timer.begin("open editors", options.numInstances, "editor");
+            for (auto& instance : instances)
+                editors.emplace_back(instance->createEditor());
+        }
+
+        SignalGenerator signal(options.seed, options.sampleRate);
+        juce::AudioBuffer<float> input(2, options.blockSize), buffer(2, options.blockSize);
+        juce::MidiBuffer midi;
+        Checksum checksum;
+
+        // the host round-robins every instance once per block
+        timer.begin("process", (juce::int64)options.numBlocks * options.numInstances, "block");
+        for (int block = 0; block < options.numBlocks; ++block)
+        {
+            signal.fill(input);
+            for (auto& instance : instances)
+            {
+                buffer.makeCopyOf(input, true);
+                instance->processBlock(buffer, midi);
+            }
+            checksum.add(buffer);
+        }
+
+        if (options.withEditor)
+        {
+            timer.begin("close editors", options.numInstances, "editor");
+            editors.clear();
+        }
+
+        timer.begin("release", options.numInstances, "instance");
+        for (auto& instance : instances)
+            instance->releaseResources();
+
+        const auto memoryReport = instances.front()->getMemoryReport();
+        timer.addNote("memory per instance: " + memoryReport[memoryReport.size() - 1].fromFirstOccurrenceOf(" ", false, false).trim());
+
+        timer.begin("destroy", options.numInstances, "instance");
+        instances.clear();
+        timer.end();
+
+        timer.addNote("checksum " + checksum.toString());
+    }
+
+    //==============================================================================
+    void runAutomation(const HarnessOptions& options, PhaseTimer& timer)
+    {
+        auto processor = createPreparedProcessor(options.sampleRate, options.blockSize);
+
+        SignalGenerator signal(options.seed, options.sampleRate);
+        juce::AudioBuffer<float> buffer(2, options.blockSize);
+        juce::MidiBuffer midi;
+        Checksum checksum;
+
+        timer.begin("static", options.numBlocks, "block");
+        for (int block = 0; block < options.numBlocks; ++block)
+        {
+            signal.fill(buffer);
+            processor->processBlock(buffer, midi);
+            checksum.add(buffer);
+        }
+
+        // every band parameter changes every block, so every block redesigns
+        timer.begin("band sweep", options.numBlocks, "block");
+        for (int block = 0; block < options.numBlocks; ++block)
+        {
+            for (size_t i = 0; i < bandParams.size(); ++i)
+                automate(*processor, bandParams[i], getSweepValue(block, (int)i));
+
+            signal.fill(buffer);
+            processor->processBlock(buffer, midi);
+            checksum.add(buffer);
+        }
+
+        // morph between two snapshots, designs come from the cached table
+        juce::Random random(options.seed);
+        randomiseBands(*processor, random);
+        processor->storeMorphSnapshot(MorphA);
+        randomiseBands(*processor, random);
+        processor->storeMorphSnapshot(MorphB);
+        automate(*processor, Param::MorphEnabled, 1.f);
+
+        timer.begin("morph sweep", options.numBlocks, "block");
+        for (int block = 0; block < options.numBlocks; ++block)
+        {
+            automate(*processor, Param::Morph, getSweepValue(block, 0));
+
+            signal.fill(buffer);
+            processor->processBlock(buffer, midi);
+            checksum.add(buffer);
+        }
+        timer.end();
+
+        timer.addNote("checksum " + checksum.toString());
+    }
+
+    //==============================================================================
+    void runOffline(const HarnessOptions& options, PhaseTimer& timer)
+    {
+        // the band sweep from the automation scenario, bounced at every quality tier
+        std::vector<float> realtimeOutput;
+
+        for (auto quality : { OfflineQuality::Realtime, OfflineQuality::High, OfflineQuality::Maximum })
+        {
+            auto processor = createPreparedProcessor(options.sampleRate, options.blockSize);
+            processor->setOfflineQuality(quality);
+            processor->setNonRealtime(true);
+
+            SignalGenerator signal(options.seed, options.sampleRate);
+            juce::AudioBuffer<float> buffer(2, options.blockSize);
+            juce::MidiBuffer midi;
+            Checksum checksum;
+
+            std::vector<float> output;
+            output.reserve((size_t)options.numBlocks * (size_t)options.blockSize);
+            double maxDeviation = 0;
+
+            timer.begin("bounce, " + getOfflineQualityName(quality), options.numBlocks, "block");
+            for (int block = 0; block < options.numBlocks; ++block)
+            {
+                for (size_t i = 0; i < bandParams.size(); ++i)
+                    automate(*processor, bandParams[i], getSweepValue(block, (int)i));
+
+                signal.fill(buffer);
+                processor->processBlock(buffer, midi);
+                checksum.add(buffer);
+
+                for (int i = 0; i < buffer.getNumSamples(); ++i)
+                    output.push_back(buffer.getSample(0, i));
+            }
+            timer.end();
+
+            if (quality == OfflineQuality::Realtime)
+            {
+                realtimeOutput = std::move(output);
+            }
+            else
+            {
+                for (size_t i = 0; i < output.size(); ++i)
+                    maxDeviation = juce::jmax(maxDeviation, std::abs(double(output[i]) - double(realtimeOutput[i])));
+
+                timer.addNote(getOfflineQualityName(quality) + ": max deviation from realtime "
+                              + juce::String(juce::Decibels::gainToDecibels(maxDeviation, -200.0), 1) + " dBFS");
+            }
+
+            timer.addNote(getOfflineQualityName(quality) + ": checksum " + checksum.toString());
+        }
+    }
+
+    //==============================================================================
+    // copies the bank's records round-robin until it holds numPresets, each under a new name
+    bool fillPresetBank(const juce::File& file, int numPresets, juce::Random& random)
+    {
+        juce::MemoryBlock bank;
+        if (!file.loadFileAsData(bank) || bank.getSize() < 16)
+            return false;
+
+        auto* data = static_cast<const char*>(bank.getData());
+        const auto numStoredParameters = (int)juce::ByteOrder::littleEndianInt(data + 8);
+        const auto recordSize = (int)juce::ByteOrder::littleEndianInt(data + 12);
+        const auto dataOffset = 16 + (size_t)numStoredParameters * PresetBank::parameterIDLength;
+        const auto numSaved = recordSize > 0 ? (int)((bank.getSize() - dataOffset) / (size_t)recordSize) : 0;
+
+        if (numSaved == 0)
+            return false;
+
+        juce::FileOutputStream out(file);
+        if (out.failedToOpen())
+            return false;
+
+        out.setPosition((juce::int64)(dataOffset + (size_t)numSaved * (size_t)recordSize));
+        std::vector<char> record((size_t)recordSize);
+        for (int i = numSaved; i < numPresets; ++i)
+        {
+            std::memcpy(record.data(), data + dataOffset + (size_t)(i % numSaved) * (size_t)recordSize, record.size());
+            std::fill(record.begin(), record.begin() + PresetBank::nameLength, '\0');
+
+            const auto name = "Generated " + juce::String(i) + " " + juce::String::toHexString(random.nextInt());
+            name.copyToUTF8(record.data(), PresetBank::nameLength);
+            out.write(record.data(), record.size());
+        }
+
+        out.flush();
+        return out.getStatus().wasOk();
+    }
+
+    void runPresets(const HarnessOptions& options, PhaseTimer& timer)
+    {
+        // outlives the processor, which maps it
+        juce::TemporaryFile bankFile(".eqbank");
+        auto processor = createPreparedProcessor(options.sampleRate, options.blockSize);
+
+        constexpr int numStates = 64;
+        std::vector<juce::MemoryBlock> states((size_t)numStates);
+        juce::Random random(options.seed);
+
+        timer.begin("capture states", numStates, "state");
+        for (auto& state : states)
+        {
+            randomiseBands(*processor, random);
+            processor->getStateInformation(state);
+        }
+
+        SignalGenerator signal(options.seed, options.sampleRate);
+        juce::AudioBuffer<float> buffer(2, options.blockSize);
+        juce::MidiBuffer midi;
+        Checksum checksum;
+
+        // a new state before every block, the worst a host's preset browser can do
+        timer.begin("state storm", options.numBlocks, "block");
+        for (int block = 0; block < options.numBlocks; ++block)
+        {
+            const auto& state = states[(size_t)(block % numStates)];
+            processor->setStateInformation(state.getData(), (int)state.getSize());
+
+            signal.fill(buffer);
+            processor->processBlock(buffer, midi);
+            checksum.add(buffer);
+        }
+
+        timer.end();
+        timer.addNote("checksum " + checksum.toString() + " (state storm)");
+
+        // programs come from a generated bank, never the user's: a few real presets copied out to numPresets records
+        processor->setPresetBankFile(bankFile.getFile());
+
+        constexpr int numSavedPresets = 64;
+        const auto numPresets = juce::jmax(numSavedPresets, options.numPresets);
+
+        timer.begin("generate bank", numPresets, "preset");
+        for (int i = 0; i < numSavedPresets; ++i)
+        {
+            randomiseBands(*processor, random);
+            processor->savePreset("Saved " + juce::String(i));
+        }
+
+        // unmapped while the file grows, the next preset call maps it again
+        processor->setPresetBankFile(bankFile.getFile());
+        if (!fillPresetBank(bankFile.getFile(), numPresets, random))
+        {
+            timer.addFailure("couldn't generate the preset bank");
+            return;
+        }
+
+        auto& bank = processor->getPresetBank();
+        timer.end();
+
+        if (bank.getNumPresets() != numPresets)
+        {
+            timer.addFailure("the generated bank holds " + juce::String(bank.getNumPresets()) + " presets, not " + juce::String(numPresets));
+            return;
+        }
+
+        // recall is a pointer offset, the position in the bank mustn't matter
+        constexpr int numRecalls = 10000;
+        timer.begin("recall, spread over the bank", numRecalls, "recall");
+        for (int i = 0; i < numRecalls; ++i)
+            bank.recall((int)(((juce::int64)i * 7919) % numPresets));
+
+        timer.begin("program storm", options.numBlocks, "block");
+        for (int block = 0; block < options.numBlocks; ++block)
+        {
+            processor->setCurrentProgram((int)(((juce::int64)block * 7919) % numPresets));
+
+            signal.fill(buffer);
+            processor->processBlock(buffer, midi);
+        }
+
+        // the first search sorts the name index, later ones are binary searches over it
+        timer.begin("first search", 1, "search");
+        auto found = bank.search("Generated 1", 50);
+
+        constexpr int numSearches = 1000;
+        timer.begin("search", numSearches, "search");
+        for (int i = 0; i < numSearches; ++i)
+            found = bank.search("Generated " + juce::String(random.nextInt(numPresets)), 50);
+        timer.end();
+
+        timer.addNote("programs in bank: " + juce::String(numPresets) + ", last search found " + juce::String(found.size()));
+        if (bank.search("Saved 1", 50).isEmpty())
+            timer.addFailure("search doesn't find a saved preset");
+
+        // a preset recalls the bands only, never the host bypass or the crossover, in a bank of its own
+        {
+            juce::TemporaryFile bypassBankFile(".eqbank");
+            PresetBank bypassBank(processor->apvts, bypassBankFile.getFile(), getPresetParameterIDs());
+
+            automate(*processor, Param::Bypass, 1.f);
+            automate(*processor, Param::CrossoverBands, 1.f);
+            const auto saved = bypassBank.save("bypassed");
+
+            automate(*processor, Param::Bypass, 0.f);
+            automate(*processor, Param::CrossoverBands, 0.f);
+            const auto recalled = saved >= 0 && bypassBank.recall(saved);
+
+            const auto& parameters = processor->parameters;
+            if (!recalled)
+                timer.addFailure("couldn't save and recall a preset in a temporary bank");
+            else if (parameters.load(Param::Bypass) > 0.5f || parameters.load(Param::CrossoverBands) > 0.f)
+                timer.addFailure("recalling a preset changed the bypass or the crossover");
+        }
+    }
+
+    //==============================================================================
+    void runFile(const HarnessOptions& options, PhaseTimer& timer)
+    {
+        if (!options.inputFile.existsAsFile())
+        {
+            timer.addNote("skipped, pass --input <audio file>");
+            return;
+        }
+
+        juce::AudioFormatManager formats;
+        formats.registerBasicFormats();
+
+        timer.begin("read");
+        std::unique_ptr<juce::AudioFormatReader> reader(formats.createReaderFor(options.inputFile));
+        if (reader == nullptr)
+        {
+            timer.end();
+            timer.addNote("couldn't read " + options.inputFile.getFullPathName());
+            return;
+        }
+
+        const auto numSamples = (int)reader->lengthInSamples;
+        juce::AudioBuffer<float> audio(2, numSamples);
+        reader->read(&audio, 0, numSamples, 0, true, true);
+
+        auto processor = createPreparedProcessor(reader->sampleRate, options.blockSize);
+        juce::AudioBuffer<float> buffer(2, options.blockSize);
+        juce::MidiBuffer midi;
+        Checksum checksum;
+
+        const auto numBlocks = (numSamples + options.blockSize - 1) / options.blockSize;
+        timer.begin("process", numBlocks, "block");
+        const auto processStart = juce::Time::getMillisecondCounterHiRes();
+        for (int start = 0; start < numSamples; start += options.blockSize)
+        {
+            const auto length = juce::jmin(options.blockSize, numSamples - start);
+            buffer.setSize(2, length, false, false, true);
+            for (int ch = 0; ch < 2; ++ch)
+                buffer.copyFrom(ch, 0, audio, ch, start, length);
+
+            processor->processBlock(buffer, midi);
+            checksum.add(buffer);
+        }
+        const auto processSeconds = (juce::Time::getMillisecondCounterHiRes() - processStart) / 1000.0;
+        timer.end();
+
+        const auto seconds = double(numSamples) / reader->sampleRate;
+        timer.addNote(juce::String(seconds, 1) + " s of audio, " + juce::String(seconds / juce::jmax(processSeconds, 1.0e-9), 1) + "x realtime");
+        timer.addNote("checksum " + checksum.toString());
+    }
+
+    //==============================================================================
+    void runTrace(const HarnessOptions& options, PhaseTimer& timer)
+    {
+        auto& log = TraceLog::getInstance();
+        const auto wasEnabled = log.isEnabled();
+        constexpr int numScopes = 1000000;
+
+        // the raw cost of a marker, with and without recording
+        log.setEnabled(false);
+        timer.begin("empty scope, off", numScopes, "scope");
+        for (int i = 0; i < numScopes; ++i)
+        {
+            EQTUT_TRACE_SCOPE("harness");
+        }
+
+        log.setEnabled(true);
+        timer.begin("empty scope, on", numScopes, "scope");
+        for (int i = 0; i < numScopes; ++i)
+        {
+            EQTUT_TRACE_SCOPE("harness");
+        }
+        timer.end();
+
+        // and what the markers in processBlock add to a real block
+        auto processor = createPreparedProcessor(options.sampleRate, options.blockSize);
+        SignalGenerator signal(options.seed, options.sampleRate);
+        juce::AudioBuffer<float> buffer(2, options.blockSize);
+        juce::MidiBuffer midi;
+
+        double milliseconds[2] = {};
+        for (auto enabled : { false, true })
+        {
+            log.setEnabled(enabled);
+            timer.begin(enabled ? "process, tracing on" : "process, tracing off", options.numBlocks, "block");
+
+            const auto start = juce::Time::getMillisecondCounterHiRes();
+            for (int block = 0; block < options.numBlocks; ++block)
+            {
+                signal.fill(buffer);
+                processor->processBlock(buffer, midi);
+            }
+            milliseconds[enabled ? 1 : 0] = juce::Time::getMillisecondCounterHiRes() - start;
+        }
+        timer.end();
+
+        // a new thread's first marker claims a preallocated ring, it must not allocate
+        juce::int64 firstMarkerAllocations = -1;
+        std::thread newThread([&firstMarkerAllocations]
+            {
+                const auto allocationsBefore = getNumAllocations();
+                {
+                    EQTUT_TRACE_SCOPE("harness, new thread");
+                }
+                firstMarkerAllocations = getNumAllocations() - allocationsBefore;
+            });
+        newThread.join();
+
+        log.setEnabled(wasEnabled);
+
+        timer.addNote(juce::String(firstMarkerAllocations) + " allocations for a new thread's first marker");
+        if (firstMarkerAllocations != 0)
+            timer.addFailure("a thread's first trace marker allocates");
+
+        const auto overhead = (milliseconds[1] - milliseconds[0]) / juce::jmax(milliseconds[0], 1.0e-6) * 100.0;
+        timer.addNote("tracing overhead in processBlock: " + juce::String(overhead, 2) + " %");
+        timer.addNote("threads recorded: " + juce::String(log.getNumThreads())
+            + ", untraced: " + juce::String(log.getNumUntracedThreads()));
+    }
+
+    //==============================================================================
+    void runRegistry(const HarnessOptions& options, PhaseTimer& timer)
+    {
+        auto processor = createPreparedProcessor(options.sampleRate, options.blockSize);
+        auto& apvts = processor->apvts;
+        const auto& registry = processor->parameters;
+        const auto numReads = juce::jmax(100000, options.numBlocks * 100);
+
+        // the sum keeps the reads from being optimised away
+        double sum = 0;
+
+        // what getChainSettings did per block before the registry: seven lookups by ID
+        juce::StringArray ids;
+        for (auto param : bandParams)
+            ids.add(getParameterID(param));
+
+        timer.begin("7 lookups by ID", numReads, "block");
+        for (int read = 0; read < numReads; ++read)
+            for (const auto& id : ids)
+                sum += apvts.getRawParameterValue(id)->load();
+
+        timer.begin("7 registry loads", numReads, "block");
+        for (int read = 0; read < numReads; ++read)
+            for (auto param : bandParams)
+                sum += registry.load(param);
+
+        timer.begin("registry snapshot, every parameter", numReads, "block");
+        for (int read = 0; read < numReads; ++read)
+            sum += registry.load()[Param::PeakGain];
+        timer.end();
+
+        timer.addNote("sum " + juce::String(sum, 3));
+    }
+
+    //==============================================================================
+    void runDesign(const HarnessOptions& options, PhaseTimer& timer)
+    {
+        using Design = juce::dsp::FilterDesign<float>;
+        constexpr int numFrequencies = 2000;
+        const auto maxFrequency = (float)juce::jmin(20000.0, options.sampleRate * 0.45);
+
+        std::vector<float> frequencies;
+        for (int i = 0; i < numFrequencies; ++i)
+            frequencies.push_back(juce::mapToLog10(float(i) / float(numFrequencies - 1), 20.f, maxFrequency));
+
+        // every cut the eight slopes can ask for, high and low pass
+        const auto numDesigns = (juce::int64)numFrequencies * ButterworthPrototype::maxSections * 2;
+        std::vector<BiquadCoefficients> reference, table;
+        reference.reserve((size_t)numDesigns * ButterworthPrototype::maxSections);
+        table.resize((size_t)numDesigns * ButterworthPrototype::maxSections);
+
+        timer.begin("FilterDesign<float>", numDesigns, "design");
+        for (int numSections = 1; numSections <= ButterworthPrototype::maxSections; ++numSections)
+        {
+            for (auto highPass : { true, false })
+            {
+                for (auto frequency : frequencies)
+                {
+                    auto designed = highPass ? Design::designIIRHighpassHighOrderButterworthMethod(frequency, options.sampleRate, numSections * 2)
+                                             : Design::designIIRLowpassHighOrderButterworthMethod(frequency, options.sampleRate, numSections * 2);
+
+                    for (auto* coefficients : designed)
+                    {
+                        const auto* c = coefficients->coefficients.begin();
+                        reference.push_back({ c[0], c[1], c[2], c[3], c[4] });
+                    }
+                }
+            }
+        }
+
+        timer.begin("prototype table", numDesigns, "design");
+        auto* out = table.data();
+        for (int numSections = 1; numSections <= ButterworthPrototype::maxSections; ++numSections)
+        {
+            for (auto highPass : { true, false })
+            {
+                for (auto frequency : frequencies)
+                {
+                    designButterworthCut(out, numSections, highPass, frequency, options.sampleRate);
+                    out += numSections;
+                }
+            }
+        }
+        timer.end();
+
+        table.resize((size_t)(out - table.data()));
+
+        int numDifferent = 0;
+        double maxDifference = 0;
+        for (size_t i = 0; i < table.size(); ++i)
+        {
+            const auto& a = table[i];
+            const auto& b = reference[i];
+            const float difference[] = { a.b0 - b.b0, a.b1 - b.b1, a.b2 - b.b2, a.a1 - b.a1, a.a2 - b.a2 };
+
+            for (auto d : difference)
+            {
+                numDifferent += d != 0.f ? 1 : 0;
+                maxDifference = juce::jmax(maxDifference, (double)std::abs(d));
+            }
+        }
+
+        timer.addNote(juce::String(numDifferent) + " of " + juce::String((int)table.size() * 5) + " cut coefficients differ from FilterDesign, max by "
+                      + juce::String(maxDifference, 9));
+
+        if (table.size() != reference.size() || maxDifference > 1.0e-6)
+            timer.addFailure("prototype table designs don't match FilterDesign");
+
+        // and the whole chain, as the processor designs it
+        juce::Random random(options.seed);
+        std::vector<ChainSettings> settings((size_t)numFrequencies);
+        for (auto& s : settings)
+        {
+            s.lowCutFreq = juce::mapToLog10(random.nextFloat(), 20.f, maxFrequency);
+            s.highCutFreq = juce::mapToLog10(random.nextFloat(), 20.f, maxFrequency);
+            s.peakFreq = juce::mapToLog10(random.nextFloat(), 20.f, maxFrequency);
+            s.peakGainDB = juce::jmap(random.nextFloat(), -24.f, 24.f);
+            s.peakQ = juce::mapToLog10(random.nextFloat(), 0.1f, 10.f);
+            s.lowCutSlope = static_cast<Slope>(random.nextInt(numSlopes));
+            s.highCutSlope = static_cast<Slope>(random.nextInt(numSlopes));
+            s.lowCutType = static_cast<CutType>(random.nextInt(NumCutTypes));
+            s.highCutType = static_cast<CutType>(random.nextInt(NumCutTypes));
+        }
+
+        std::vector<KernelCoefficients> allocated(settings.size()), designed(settings.size());
+
+        timer.begin("makeChainCoefficients", (juce::int64)settings.size(), "chain");
+        for (size_t i = 0; i < settings.size(); ++i)
+            makeKernelCoefficients(allocated[i], makeChainCoefficients(settings[i], options.sampleRate));
+
+        timer.begin("designKernelCoefficients", (juce::int64)settings.size(), "chain");
+        for (size_t i = 0; i < settings.size(); ++i)
+            designKernelCoefficients(designed[i], settings[i], options.sampleRate);
+        timer.end();
+
+        double maxChainDifference = 0;
+        for (size_t i = 0; i < settings.size(); ++i)
+        {
+            if (allocated[i].activeMask != designed[i].activeMask)
+                maxChainDifference = 1;
+
+            for (int section = 0; section < KernelCoefficients::maxSections; ++section)
+            {
+                if (!allocated[i].isActive(section))
+                    continue;
+
+                const auto& a = allocated[i].sections[(size_t)section];
+                const auto& b = designed[i].sections[(size_t)section];
+                for (auto d : { a.b0 - b.b0, a.b1 - b.b1, a.b2 - b.b2, a.a1 - b.a1, a.a2 - b.a2 })
+                    maxChainDifference = juce::jmax(maxChainDifference, (double)std::abs(d));
+            }
+        }
+
+        timer.addNote("designKernelCoefficients against makeChainCoefficients: max difference " + juce::String(maxChainDifference, 9));
+        if (maxChainDifference > 1.0e-6)
+            timer.addFailure("designKernelCoefficients doesn't match makeChainCoefficients");
+    }
+
+    //==============================================================================
+    void runCuts(const HarnessOptions& options, PhaseTimer& timer)
+    {
+        constexpr int numFrequencies = 2000;
+        const auto maxFrequency = juce::jmin(20000.0, options.sampleRate * 0.45);
+
+        std::vector<double> frequencies;
+        for (int i = 0; i < numFrequencies; ++i)
+            frequencies.push_back(juce::mapToLog10(double(i) / double(numFrequencies - 1), 20.0, maxFrequency));
+
+        // design time of every family, every slope high and low pass, nothing allocates
+        const auto numDesigns = (juce::int64)numFrequencies * numSlopes * 2;
+        std::vector<BiquadCoefficients> sections((size_t)numFrequencies * CutPrototype::maxSections);
+
+        for (int type = 0; type < NumCutTypes; ++type)
+        {
+            timer.begin(getCutTypeName(CutType(type)), numDesigns, "design");
+            for (int numSections = 1; numSections <= CutPrototype::maxSections; ++numSections)
+                for (auto highPass : { true, false })
+                    for (size_t i = 0; i < frequencies.size(); ++i)
+                        designCut(sections.data() + i * CutPrototype::maxSections, numSections, CutType(type), highPass,
+                                  float(frequencies[i]), options.sampleRate);
+        }
+        timer.end();
+
+        // every family and slope: the level at the cutoff in double, and how far the float design strays
+        struct DoubleSection
+        {
+            double b0, b1, b2, a1, a2;
+        };
+
+        auto getLevel = [&options](const auto* cut, int numSections, double frequency)
+            {
+                const auto z1 = std::polar(1.0, -juce::MathConstants<double>::twoPi * frequency / options.sampleRate);
+                const auto z2 = z1 * z1;
+
+                std::complex<double> response(1.0);
+                for (int i = 0; i < numSections; ++i)
+                    response *= (double(cut[i].b0) + double(cut[i].b1) * z1 + double(cut[i].b2) * z2)
+                              / (1.0 + double(cut[i].a1) * z1 + double(cut[i].a2) * z2);
+
+                return juce::Decibels::gainToDecibels(std::abs(response), -300.0);
+            };
+
+        constexpr int numGridPoints = 256;
+        constexpr double floorDB = -30.0;
+        const std::array<double, 3> cutoffs{ 200.0, 1000.0, juce::jmin(10000.0, options.sampleRate * 0.2) };
+
+        for (int type = 0; type < NumCutTypes; ++type)
+        {
+            const auto expectedDB = type == CutType_LinkwitzRiley ? -6.0206 : -3.0103;
+            double worstCutoffDB = 0, worstFloatDB = 0;
+
+            for (int numSections = 1; numSections <= CutPrototype::maxSections; ++numSections)
+            {
+                for (auto highPass : { true, false })
+                {
+                    for (auto cutoff : cutoffs)
+                    {
+                        std::array<BiquadCoefficients, CutPrototype::maxSections> floatCut;
+                        std::array<DoubleSection, CutPrototype::maxSections> doubleCut;
+                        designCut(floatCut.data(), numSections, CutType(type), highPass, float(cutoff), options.sampleRate);
+                        designCut(doubleCut.data(), numSections, CutType(type), highPass, cutoff, options.sampleRate);
+
+                        worstCutoffDB = juce::jmax(worstCutoffDB, std::abs(getLevel(doubleCut.data(), numSections, cutoff) - expectedDB));
+
+                        for (int point = 0; point < numGridPoints; ++point)
+                        {
+                            const auto frequency = juce::mapToLog10(double(point) / double(numGridPoints - 1), 20.0, maxFrequency);
+                            const auto referenceDB = getLevel(doubleCut.data(), numSections, frequency);
+                            if (referenceDB >= floorDB)
+                                worstFloatDB = juce::jmax(worstFloatDB, std::abs(getLevel(floatCut.data(), numSections, frequency) - referenceDB));
+                        }
+                    }
+                }
+            }
+
+            timer.addNote(juce::String(getCutTypeName(CutType(type))) + ": cutoff off " + juce::String(expectedDB, 2) + " dB by at most "
+                          + juce::String(worstCutoffDB, 6) + ", float design within " + juce::String(worstFloatDB, 4) + " dB of double");
+
+            if (worstCutoffDB > 1.0e-3)
+                timer.addFailure(juce::String(getCutTypeName(CutType(type))) + " cut isn't at its level at the cutoff");
+        }
+
+        // the kernel runs one flat loop per section, so its cost has to grow linearly with the section count
+        DSPArena arena;
+        arena.reset(FilterKernel::getRequiredBytes(2));
+        FilterKernel kernel;
+        kernel.prepare(arena, 2);
+
+        SignalGenerator signal(options.seed, options.sampleRate);
+        juce::AudioBuffer<float> buffer(2, options.blockSize);
+        const auto ticksPerNanosecond = double(juce::Time::getHighResolutionTicksPerSecond()) / 1.0e9;
+        const auto numSamples = double(options.numBlocks) * options.blockSize * 2;
+
+        std::array<double, numSlopes> nanosecondsPerSample{};
+        for (int slope = Slope_12; slope <= Slope_96; ++slope)
+        {
+            ChainSettings settings;
+            settings.lowCutFreq = 100.f;
+            settings.lowCutSlope = Slope(slope);
+            settings.highCutFreq = 10000.f;
+            settings.highCutSlope = Slope(slope);
+            settings.peakEnabled = false;
+
+            KernelCoefficients coefficients;
+            designKernelCoefficients(coefficients, settings, options.sampleRate);
+            kernel.setCoefficients(coefficients);
+            kernel.reset();
+
+            const auto numSections = juce::countNumberOfBits(coefficients.getProcessedMask());
+            timer.begin("kernel, " + juce::String(numSections) + " sections", options.numBlocks, "block");
+
+            juce::int64 ticks = 0;
+            for (int block = 0; block < options.numBlocks; ++block)
+            {
+                signal.fill(buffer);
+                const auto start = juce::Time::getHighResolutionTicks();
+                for (int ch = 0; ch < 2; ++ch)
+                    kernel.process(buffer.getWritePointer(ch), options.blockSize, ch);
+                ticks += juce::Time::getHighResolutionTicks() - start;
+            }
+
+            nanosecondsPerSample[(size_t)slope] = double(ticks) / ticksPerNanosecond / numSamples;
+        }
+        timer.end();
+
+        juce::String line;
+        for (int slope = Slope_12; slope <= Slope_96; ++slope)
+            line << juce::String(nanosecondsPerSample[(size_t)slope] / double(2 * (slope + 1)), 3) << (slope < Slope_96 ? ", " : "");
+
+        timer.addNote("kernel ns per sample and section, 2 to 16 sections: " + line);
+    }
+
+    //==============================================================================
+    void runSlopes(const HarnessOptions& options, PhaseTimer& timer)
+    {
+        auto processor = createPreparedProcessor(options.sampleRate, options.blockSize);
+
+        // cuts close enough to a 440 Hz sine that every slope changes its level
+        automate(*processor, Param::LowCutFreq, processor->parameters.getParameter(Param::LowCutFreq).convertTo0to1(300.f));
+        automate(*processor, Param::HighCutFreq, processor->parameters.getParameter(Param::HighCutFreq).convertTo0to1(700.f));
+
+        auto& slopeParameter = processor->parameters.getParameter(Param::LowCutSlope);
+        const auto steepSlope = slopeParameter.convertTo0to1(float(Slope_48));
+        const auto ellipticType = processor->parameters.getParameter(Param::LowCutType).convertTo0to1(float(CutType_Elliptic));
+
+        juce::AudioBuffer<float> buffer(2, options.blockSize);
+        juce::MidiBuffer midi;
+        double phase = 0;
+        const auto phaseStep = juce::MathConstants<double>::twoPi * 440.0 / options.sampleRate;
+
+        auto fillSine = [&]
+            {
+                for (int i = 0; i < buffer.getNumSamples(); ++i)
+                {
+                    const auto sample = float(0.25 * std::sin(phase));
+                    phase += phaseStep;
+                    for (int ch = 0; ch < buffer.getNumChannels(); ++ch)
+                        buffer.setSample(ch, i, sample);
+                }
+            };
+
+        // the largest sample to sample step, a click shows up as a jump well above the sine's own
+        float lastSample = 0;
+        auto getLargestStep = [&]
+            {
+                float largest = 0;
+                for (int i = 0; i < buffer.getNumSamples(); ++i)
+                {
+                    largest = juce::jmax(largest, std::abs(buffer.getSample(0, i) - lastSample));
+                    lastSample = buffer.getSample(0, i);
+                }
+                return largest;
+            };
+
+        const auto fadeBlocks = juce::jmax(1, (juce::roundToInt(options.sampleRate * 0.02) + options.blockSize - 1) / options.blockSize);
+        const auto ticksPerMicrosecond = double(juce::Time::getHighResolutionTicksPerSecond()) / 1.0e6;
+        constexpr float maxStepDB = 6.f;
+
+        // settle the filters before anything is measured
+        for (int block = 0; block < 64; ++block)
+        {
+            fillSine();
+            processor->processBlock(buffer, midi);
+            getLargestStep();
+        }
+
+        // a burst of changesPerBurst changes, one a block, every blocksBetweenChanges blocks. a change that arrives
+        // during a fade waits for it, so the blocks count as fading until every change in the burst can have faded
+        auto measureChanges = [&](const juce::String& name, int blocksBetweenChanges, int changesPerBurst, const std::function<void(int)>& change)
+            {
+                const auto blocksFading = changesPerBurst * (fadeBlocks + 1);
+                int changeIndex = 0;
+
+                float steadyStep = 0, fadingStep = 0;
+                juce::int64 steadyTicks = 0, fadingTicks = 0;
+                int numSteadyBlocks = 0, numFadingBlocks = 0;
+
+                timer.begin(name, options.numBlocks, "block");
+                for (int block = 0; block < options.numBlocks; ++block)
+                {
+                    const auto sinceChange = block % blocksBetweenChanges;
+                    if (sinceChange < changesPerBurst)
+                        change(changeIndex++);
+
+                    fillSine();
+                    const auto start = juce::Time::getHighResolutionTicks();
+                    processor->processBlock(buffer, midi);
+                    const auto ticks = juce::Time::getHighResolutionTicks() - start;
+                    const auto step = getLargestStep();
+
+                    if (sinceChange < blocksFading)
+                    {
+                        fadingTicks += ticks;
+                        fadingStep = juce::jmax(fadingStep, step);
+                        ++numFadingBlocks;
+                    }
+                    else
+                    {
+                        steadyTicks += ticks;
+                        steadyStep = juce::jmax(steadyStep, step);
+                        ++numSteadyBlocks;
+                    }
+                }
+
+                const auto stepDB = juce::Decibels::gainToDecibels(fadingStep / juce::jmax(steadyStep, 1.0e-9f));
+
+                timer.addNote(name + ": blocks while fading " + juce::String(double(fadingTicks) / ticksPerMicrosecond / juce::jmax(1, numFadingBlocks), 2)
+                              + " us/block, otherwise " + juce::String(double(steadyTicks) / ticksPerMicrosecond / juce::jmax(1, numSteadyBlocks), 2) + " us/block");
+                timer.addNote(name + ": largest step while fading " + juce::String(stepDB, 2) + " dB against the steady sine's");
+
+                if (stepDB > maxStepDB)
+                    timer.addFailure(name + ": a change clicks");
+            };
+
+        // 12 <-> 48 dB/oct, three sections in or out on each side
+        auto changeSlopes = [&](int index)
+            {
+                const auto steep = index % 2 == 0;
+                automate(*processor, Param::LowCutSlope, steep ? steepSlope : 0.f);
+                automate(*processor, Param::HighCutSlope, steep ? steepSlope : 0.f);
+            };
+
+        // long enough for some steady blocks between the fades at any block size
+        const auto blocksBetweenChanges = juce::jmax(16, 4 * (fadeBlocks + 1));
+        measureChanges("slope change every " + juce::String(blocksBetweenChanges) + " blocks", blocksBetweenChanges, 1, changeSlopes);
+
+        // changes a block apart land in the middle of the fade before them, at blocks shorter than the fade
+        measureChanges("3 slope changes a block apart", 2 * blocksBetweenChanges, 3, changeSlopes);
+
+        // Butterworth <-> elliptic at 48 dB/oct: the same sections run, with Qs up to about 57 on the elliptic side
+        automate(*processor, Param::LowCutSlope, steepSlope);
+        automate(*processor, Param::HighCutSlope, steepSlope);
+        measureChanges("family change every " + juce::String(blocksBetweenChanges) + " blocks", blocksBetweenChanges, 1, [&](int index)
+            {
+                const auto elliptic = index % 2 == 0;
+                automate(*processor, Param::LowCutType, elliptic ? ellipticType : 0.f);
+                automate(*processor, Param::HighCutType, elliptic ? ellipticType : 0.f);
+            });
+
+        automate(*processor, Param::LowCutType, 0.f);
+        automate(*processor, Param::HighCutType, 0.f);
+
+        // a bounce runs the double kernel, which has to hand the same changes over the same way
+        processor->setNonRealtime(true);
+        measureChanges("bounced, slope change every " + juce::String(blocksBetweenChanges) + " blocks", blocksBetweenChanges, 1, changeSlopes);
+        measureChanges("bounced, 3 slope changes a block apart", 2 * blocksBetweenChanges, 3, changeSlopes);
+        processor->setNonRealtime(false);
+    }
+
+    //==============================================================================
+    void runBypass(const HarnessOptions& options, PhaseTimer& timer)
+    {
+        auto processor = createPreparedProcessor(options.sampleRate, options.blockSize);
+        juce::Random random(options.seed);
+        randomiseBands(*processor, random);
+        const auto slope48 = processor->parameters.getParameter(Param::LowCutSlope).convertTo0to1(float(Slope_48));
+        automate(*processor, Param::LowCutSlope, slope48);
+        automate(*processor, Param::HighCutSlope, slope48);
+
+        SignalGenerator signal(options.seed, options.sampleRate);
+        juce::AudioBuffer<float> input(2, options.blockSize), buffer(2, options.blockSize);
+        juce::MidiBuffer midi;
+
+        auto runBlocks = [&](const juce::String& phase, bool hostBypass)
+            {
+                timer.begin(phase, options.numBlocks, "block");
+                for (int block = 0; block < options.numBlocks; ++block)
+                {
+                    signal.fill(buffer);
+                    if (hostBypass)
+                        processor->processBlockBypassed(buffer, midi);
+                    else
+                        processor->processBlock(buffer, midi);
+                }
+            };
+
+        runBlocks("all bands, 48 dB/oct", false);
+
+        for (auto param : { Param::LowCutEnabled, Param::PeakEnabled, Param::HighCutEnabled })
+            automate(*processor, param, 0.f);
+        runBlocks("every band disabled", false);
+
+        for (auto param : { Param::LowCutEnabled, Param::PeakEnabled, Param::HighCutEnabled })
+            automate(*processor, param, 1.f);
+        automate(*processor, Param::Bypass, 1.f);
+        runBlocks("Bypass parameter", false);
+
+        automate(*processor, Param::Bypass, 0.f);
+        runBlocks("processBlockBypassed", true);
+        timer.end();
+
+        // once the fade is over a bypassed block must be the input, bit for bit
+        automate(*processor, Param::Bypass, 1.f);
+        bool untouched = true;
+        for (int block = 0; block < 64; ++block)
+        {
+            signal.fill(input);
+            buffer.makeCopyOf(input, true);
+            processor->processBlock(buffer, midi);
+
+            if (block >= 32)
+                for (int ch = 0; ch < 2; ++ch)
+                    untouched = untouched && std::equal(input.getReadPointer(ch), input.getReadPointer(ch) + options.blockSize, buffer.getReadPointer(ch));
+        }
+
+        if (!untouched)
+            timer.addFailure("bypassed blocks aren't the input");
+    }
+
+    //==============================================================================
+    void runTransparent(const HarnessOptions& options, PhaseTimer& timer)
+    {
+        // the default state: every band enabled, the peak at 0 dB
+        ChainSettings defaults;
+        defaults.lowCutFreq = 20.f;
+        defaults.highCutFreq = 20000.f;
+        defaults.peakFreq = 750.f;
+
+        KernelCoefficients kernel;
+        designKernelCoefficients(kernel, defaults, options.sampleRate);
+        timer.addNote("default state runs " + juce::String(juce::countNumberOfBits(kernel.getProcessedMask())) + " of "
+                      + juce::String(juce::countNumberOfBits(kernel.activeMask)) + " active sections");
+
+        auto processor = createPreparedProcessor(options.sampleRate, options.blockSize);
+        SignalGenerator signal(options.seed, options.sampleRate);
+        juce::AudioBuffer<float> buffer(2, options.blockSize);
+        juce::MidiBuffer midi;
+
+        auto& peakGain = processor->parameters.getParameter(Param::PeakGain);
+        for (auto gain : { 0.f, 0.5f })
+        {
+            automate(*processor, Param::PeakGain, peakGain.convertTo0to1(gain));
+
+            timer.begin("peak at " + juce::String(gain, 1) + " dB", options.numBlocks, "block");
+            for (int block = 0; block < options.numBlocks; ++block)
+            {
+                signal.fill(buffer);
+                processor->processBlock(buffer, midi);
+            }
+        }
+        timer.end();
+
+        // every section isTransparent() lets through has to be flat, on a dense grid right up to nyquist
+        juce::Random random(options.seed);
+        constexpr int numSections = 20000;
+        constexpr int numGridPoints = 2048;
+        int numTransparent = 0;
+        double worstDB = 0;
+
+        for (int i = 0; i < numSections; ++i)
+        {
+            ChainSettings s;
+            s.peakFreq = juce::mapToLog10(random.nextFloat(), 20.f, 20000.f);
+            s.peakQ = juce::mapToLog10(random.nextFloat(), 0.1f, 10.f);
+            s.peakGainDB = juce::jmap(random.nextFloat(), -0.02f, 0.02f);
+
+            designKernelCoefficients(kernel, s, options.sampleRate);
+            if (!kernel.isActive(KernelCoefficients::peakSection) || kernel.isProcessed(KernelCoefficients::peakSection))
+                continue;
+
+            ++numTransparent;
+            const auto& c = kernel.sections[(size_t)KernelCoefficients::peakSection];
+            for (int point = 0; point <= numGridPoints; ++point)
+            {
+                const auto z1 = std::polar(1.0, -juce::MathConstants<double>::pi * double(point) / double(numGridPoints));
+                const auto z2 = z1 * z1;
+                const auto response = (double(c.b0) + double(c.b1) * z1 + double(c.b2) * z2) / (1.0 + double(c.a1) * z1 + double(c.a2) * z2);
+                worstDB = juce::jmax(worstDB, std::abs(juce::Decibels::gainToDecibels(std::abs(response))));
+            }
+        }
+
+        timer.addNote(juce::String(numTransparent) + " of " + juce::String(numSections) + " peaks within +-0.02 dB skipped, worst "
+                      + juce::String(worstDB, 5) + " dB off flat");
+
+        if (worstDB > KernelCoefficients::transparentToleranceDB)
+            timer.addFailure("a section marked transparent isn't flat within tolerance");
+    }
+
+    //==============================================================================
+    // magnitude of a crossover's summed impulse response, worst deviation from 0 dB
+    double measureCrossoverSum(const CrossoverSettings& settings, double sampleRate)
+    {
+        constexpr int order = 14;
+        constexpr int size = 1 << order;
+
+        DSPArena arena;
+        arena.reset(Crossover::getRequiredBytes(1));
+        Crossover crossover;
+        crossover.prepare(arena, 1, sampleRate);
+        crossover.setSettings(settings);
+
+        juce::AudioBuffer<float> impulse(1, size);
+        impulse.clear();
+        impulse.setSample(0, 0, 1.f);
+        crossover.process(impulse);
+
+        std::vector<float> spectrum((size_t)size * 2, 0.f);
+        std::copy(impulse.getReadPointer(0), impulse.getReadPointer(0) + size, spectrum.begin());
+        juce::dsp::FFT(order).performFrequencyOnlyForwardTransform(spectrum.data());
+
+        double maxDeviation = 0;
+        for (int bin = 1; bin < size / 2; ++bin)
+            maxDeviation = juce::jmax(maxDeviation, std::abs(double(juce::Decibels::gainToDecibels(spectrum[(size_t)bin], -200.f))));
+
+        return maxDeviation;
+    }
+
+    void runCrossover(const HarnessOptions& options, PhaseTimer& timer)
+    {
+        auto processor = createPreparedProcessor(options.sampleRate, options.blockSize);
+
+        SignalGenerator signal(options.seed, options.sampleRate);
+        juce::AudioBuffer<float> buffer(2, options.blockSize);
+        juce::MidiBuffer midi;
+        Checksum checksum;
+
+        // "Off", then 2 - 5 bands, every band at a different level
+        auto& bandsParameter = processor->parameters.getParameter(Param::CrossoverBands);
+        for (int band = 0; band < CrossoverSettings::maxBands; ++band)
+            automate(*processor, getParam(Param::BandGain1, band), 0.3f + 0.1f * float(band));
+
+        for (int choice = 0; choice < CrossoverSettings::maxBands; ++choice)
+        {
+            automate(*processor, Param::CrossoverBands, bandsParameter.convertTo0to1(float(choice)));
+
+            timer.begin(choice == 0 ? juce::String("crossover off") : juce::String(choice + 1) + " bands", options.numBlocks, "block");
+            for (int block = 0; block < options.numBlocks; ++block)
+            {
+                signal.fill(buffer);
+                processor->processBlock(buffer, midi);
+                checksum.add(buffer);
+            }
+        }
+        timer.end();
+
+        // at unity gains the bands must sum back to an all-pass
+        for (int numBands = 2; numBands <= CrossoverSettings::maxBands; ++numBands)
+        {
+            CrossoverSettings settings;
+            settings.numBands = numBands;
+            settings.frequencies = { 120.f, 600.f, 2500.f, 8000.f };
+
+            const auto deviation = measureCrossoverSum(settings, options.sampleRate);
+            timer.addNote(juce::String(numBands) + " bands: summed magnitude within " + juce::String(deviation, 4) + " dB of flat");
+
+            if (deviation > 0.01)
+                timer.addFailure(juce::String(numBands) + " band crossover doesn't sum flat");
+        }
+
+        // moving a split point redesigns its sections on the audio thread, which must not allocate
+        {
+            DSPArena arena;
+            arena.reset(Crossover::getRequiredBytes(2));
+            Crossover crossover;
+            crossover.prepare(arena, 2, options.sampleRate);
+
+            CrossoverSettings settings;
+            settings.numBands = CrossoverSettings::maxBands;
+            settings.frequencies = { 120.f, 600.f, 2500.f, 8000.f };
+            crossover.setSettings(settings);
+
+            constexpr int numMoves = 1000;
+            const auto allocationsBefore = getNumAllocations();
+            for (int move = 0; move < numMoves; ++move)
+            {
+                settings.frequencies[(size_t)(move % 4)] *= move % 2 == 0 ? 1.01f : 0.995f;
+                crossover.setSettings(settings);
+            }
+            const auto allocations = getNumAllocations() - allocationsBefore;
+
+            timer.addNote(juce::String(allocations) + " allocations over " + juce::String(numMoves) + " split point moves");
+            if (allocations != 0)
+                timer.addFailure("moving a crossover split point allocates");
+        }
+
+        // switching between 2 and 5 bands and moving the points at unity gains: the sum stays an all-pass,
+        // so the crossfade must leave no step larger than a steady sine's
+        {
+            for (int band = 0; band < CrossoverSettings::maxBands; ++band)
+            {
+                const auto gainParam = getParam(Param::BandGain1, band);
+                automate(*processor, gainParam, processor->parameters.getParameter(gainParam).convertTo0to1(0.f));
+            }
+
+            auto& firstPoint = processor->parameters.getParameter(Param::CrossoverFreq1);
+            constexpr int blocksBetweenChanges = 16;
+            const auto fadeBlocks = juce::jmax(1, (juce::roundToInt(options.sampleRate * 0.02) + options.blockSize - 1) / options.blockSize);
+
+            double phase = 0;
+            const auto phaseStep = juce::MathConstants<double>::twoPi * 180.0 / options.sampleRate;
+            float lastSample = 0, steadyStep = 0, changingStep = 0;
+
+            for (int block = 0; block < juce::jmax(options.numBlocks, 8 * blocksBetweenChanges); ++block)
+            {
+                const auto sinceChange = block % blocksBetweenChanges;
+                if (sinceChange == 0)
+                {
+                    const auto change = block / blocksBetweenChanges;
+                    automate(*processor, Param::CrossoverBands, bandsParameter.convertTo0to1(change % 2 == 0 ? 1.f : 4.f));
+                    automate(*processor, Param::CrossoverFreq1, firstPoint.convertTo0to1(change % 3 == 0 ? 150.f : 220.f));
+                }
+
+                for (int i = 0; i < buffer.getNumSamples(); ++i, phase += phaseStep)
+                    for (int ch = 0; ch < buffer.getNumChannels(); ++ch)
+                        buffer.setSample(ch, i, 0.5f * (float)std::sin(phase));
+
+                processor->processBlock(buffer, midi);
+
+                float step = 0;
+                for (int i = 0; i < buffer.getNumSamples(); ++i)
+                {
+                    step = juce::jmax(step, std::abs(buffer.getSample(0, i) - lastSample));
+                    lastSample = buffer.getSample(0, i);
+                }
+
+                // the first blocks settle the filters
+                if (block < blocksBetweenChanges)
+                    continue;
+
+                if (sinceChange <= fadeBlocks)
+                    changingStep = juce::jmax(changingStep, step);
+                else
+                    steadyStep = juce::jmax(steadyStep, step);
+            }
+
+            const auto stepDB = juce::Decibels::gainToDecibels(changingStep / juce::jmax(steadyStep, 1.0e-9f));
+            timer.addNote("band count and point changes: largest step " + juce::String(stepDB, 2) + " dB against the steady sine's");
+            if (stepDB > 6.f)
+                timer.addFailure("changing the crossover bands clicks");
+        }
+
+        timer.addNote("checksum " + checksum.toString());
+    }
+
+    //==============================================================================
+    void runMultirate(const HarnessOptions& options, PhaseTimer& timer)
+    {
+        struct DoubleSection
+        {
+            double b0, b1, b2, a1, a2;
+            double s1 = 0, s2 = 0;
+
+            double process(double x)
+            {
+                const auto y = b0 * x + s1;
+                s1 = b1 * x - a1 * y + s2;
+                s2 = b2 * x - a2 * y;
+                return y;
+            }
+        };
+
+        constexpr float cutoff = 20.f;
+        const auto ticksPerNanosecond = double(juce::Time::getHighResolutionTicksPerSecond()) / 1.0e9;
+        const auto numSamples = options.numBlocks * options.blockSize;
+
+        // the same 20 Hz cut three ways: double at the full rate, the float kernel, and the decimated path
+        for (auto sampleRate : { 96000.0, 192000.0, 384000.0 })
+        {
+            const auto rateName = juce::String(sampleRate / 1000.0, 0) + " kHz";
+
+            DSPArena arena;
+            arena.reset(FilterKernel::getRequiredBytes(1) + MultirateLowCut::getRequiredBytes(1));
+            FilterKernel kernel;
+            kernel.prepare(arena, 1);
+            MultirateLowCut multirate;
+            multirate.prepare(arena, 1, sampleRate, options.blockSize);
+            multirate.setEnabled(true);
+
+            const auto latency = multirate.getLatencySamples();
+            if (latency != MultirateLowCut::getLatencySamples(sampleRate))
+                timer.addFailure(rateName + ": prepared latency isn't the reported one");
+
+            // with no cut engaged the option is a plain delay, an impulse has to come out at the latency
+            {
+                juce::AudioBuffer<float> impulse(1, latency + options.blockSize);
+                impulse.clear();
+                impulse.setSample(0, 0, 1.f);
+                multirate.setCut(0, CutType_Butterworth, cutoff, false);
+
+                for (int start = 0; start < impulse.getNumSamples(); start += options.blockSize)
+                {
+                    juce::AudioBuffer<float> block(impulse.getArrayOfWritePointers(), 1, start,
+                                                   juce::jmin(options.blockSize, impulse.getNumSamples() - start));
+                    multirate.process(block);
+                    multirate.subtractLowBand(block);
+                }
+
+                const auto* samples = impulse.getReadPointer(0);
+                const auto peak = int(std::max_element(samples, samples + impulse.getNumSamples(),
+                                                       [](float a, float b) { return std::abs(a) < std::abs(b); }) - samples);
+                if (peak != latency || samples[peak] != 1.f)
+                    timer.addFailure(rateName + ": impulse comes out at " + juce::String(peak) + " instead of " + juce::String(latency));
+            }
+
+            for (auto slope : { Slope_48, Slope_96 })
+            {
+                const auto numSections = int(slope) + 1;
+                const auto name = rateName + ", " + juce::String(12 * numSections) + " dB/oct";
+
+                ChainSettings settings;
+                settings.lowCutFreq = cutoff;
+                settings.lowCutSlope = slope;
+                settings.peakEnabled = false;
+                settings.highCutEnabled = false;
+
+                KernelCoefficients coefficients;
+                designKernelCoefficients(coefficients, settings, sampleRate);
+                kernel.setCoefficients(coefficients);
+                kernel.reset();
+
+                std::array<DoubleSection, CutPrototype::maxSections> reference;
+                designCut(reference.data(), numSections, CutType_Butterworth, true, double(cutoff), sampleRate);
+
+                multirate.reset();
+                const auto engaged = multirate.setCut(numSections, CutType_Butterworth, cutoff, false);
+
+                SignalGenerator signal(options.seed, sampleRate);
+                juce::AudioBuffer<float> input(1, options.blockSize), kernelBuffer(1, options.blockSize), multirateBuffer(1, options.blockSize);
+                std::vector<double> expected((size_t)(numSamples + latency), 0.0);
+                double referenceEnergy = 0, kernelError = 0, multirateError = 0;
+                juce::int64 kernelTicks = 0, multirateTicks = 0;
+
+                timer.begin(name, options.numBlocks, "block");
+                for (int block = 0; block < options.numBlocks; ++block)
+                {
+                    signal.fill(input);
+                    kernelBuffer.makeCopyOf(input, true);
+                    multirateBuffer.makeCopyOf(input, true);
+
+                    auto start = juce::Time::getHighResolutionTicks();
+                    kernel.process(kernelBuffer.getWritePointer(0), options.blockSize, 0);
+                    kernelTicks += juce::Time::getHighResolutionTicks() - start;
+
+                    start = juce::Time::getHighResolutionTicks();
+                    multirate.process(multirateBuffer);
+                    multirate.subtractLowBand(multirateBuffer);
+                    multirateTicks += juce::Time::getHighResolutionTicks() - start;
+
+                    for (int i = 0; i < options.blockSize; ++i)
+                    {
+                        const auto index = block * options.blockSize + i;
+                        auto y = double(input.getSample(0, i));
+                        for (int section = 0; section < numSections; ++section)
+                            y = reference[(size_t)section].process(y);
+
+                        expected[(size_t)index] = y;
+                        referenceEnergy += y * y;
+                        kernelError += juce::square(double(kernelBuffer.getSample(0, i)) - y);
+
+                        // the decimated path's output is the reference from latency samples ago
+                        if (index >= latency)
+                            multirateError += juce::square(double(multirateBuffer.getSample(0, i)) - expected[(size_t)(index - latency)]);
+                    }
+                }
+
+                auto toDB = [referenceEnergy](double error) { return juce::Decibels::gainToDecibels(std::sqrt(error / referenceEnergy), -300.0); };
+                const auto kernelDB = toDB(kernelError);
+                const auto perSample = [&](juce::int64 ticks) { return juce::String(double(ticks) / ticksPerNanosecond / numSamples, 2); };
+
+                timer.addNote(name + ": " + (engaged ? "decimated" : "left in the kernel")
+                              + ", rms error vs double: kernel " + juce::String(kernelDB, 1) + " dB in " + perSample(kernelTicks) + " ns/sample"
+                              + (engaged ? ", decimated " + juce::String(toDB(multirateError), 1) + " dB in " + perSample(multirateTicks) + " ns/sample"
+                                         : juce::String()));
+
+                if (engaged && !(multirateError <= kernelError))
+                    timer.addFailure(name + ": the decimated cut is further from the double design than the kernel");
+            }
+        }
+        timer.end();
+    }
+
+    //==============================================================================
+    // the AbstractFifo-backed Fifo the analyzer used before the swapping ring, kept as the baseline
+    template<typename T>
+    struct CopyingFifo
+    {
+        void prepare(int numChannels, int numSamples)
+        {
+            for (auto& buffer : buffers)
+            {
+                buffer.setSize(numChannels, numSamples, false, true, true);
+                buffer.clear();
+            }
+        }
+
+        void prepare(size_t numElements)
+        {
+            for (auto& buffer : buffers)
+            {
+                buffer.clear();
+                buffer.resize(numElements, 0);
+            }
+        }
+
+        bool push(const T& t, juce::int64 ticks = 0)
+        {
+            auto write = fifo.write(1);
+            if (write.blockSize1 > 0)
+            {
+                buffers[write.startIndex1] = t;
+                timestamps[write.startIndex1] = ticks;
+                return true;
+            }
+
+            return false;
+        }
+
+        bool pull(T& t, juce::int64& ticks)
+        {
+            auto read = fifo.read(1);
+            if (read.blockSize1 > 0)
+            {
+                t = buffers[read.startIndex1];
+                ticks = timestamps[read.startIndex1];
+                return true;
+            }
+
+            return false;
+        }
+
+        static constexpr int Capacity = 30;
+        std::array<T, Capacity> buffers;
+        std::array<juce::int64, Capacity> timestamps{};
+        juce::AbstractFifo fifo{ Capacity };
+    };
+
+    // one push and one pull per iteration, as the analyzer does once it keeps up
+    template<typename FifoType, typename T>
+    void measureRoundTrips(PhaseTimer& timer, const juce::String& name, FifoType& fifo, T& in, T& out, int numRoundTrips)
+    {
+        juce::int64 ticks = 0;
+        int numLost = 0;
+        const auto allocationsBefore = getNumAllocations();
+
+        timer.begin(name, numRoundTrips, "push + pull");
+        for (int i = 0; i < numRoundTrips; ++i)
+        {
+            if (!fifo.push(in, i) || !fifo.pull(out, ticks) || ticks != i)
+                ++numLost;
+        }
+        timer.end();
+
+        const auto allocations = getNumAllocations() - allocationsBefore;
+        timer.addNote(name + ": " + juce::String(allocations) + " allocations");
+
+        if (numLost > 0)
+            timer.addFailure(name + ": " + juce::String(numLost) + " round trips lost their element");
+    }
+
+    // pushes more than fit without pulling, then drains: which elements survive?
+    template<typename FifoType>
+    juce::String describeOverflow(FifoType& fifo, int numPushes)
+    {
+        std::vector<float> element(16, 0.f);
+        int numAccepted = 0;
+        for (int i = 0; i < numPushes; ++i)
+            numAccepted += fifo.push(element, i) ? 1 : 0;
+
+        juce::int64 ticks = -1, first = -1, last = -1;
+        int numPulled = 0;
+        while (fifo.pull(element, ticks))
+        {
+            if (numPulled++ == 0)
+                first = ticks;
+            last = ticks;
+        }
+
+        return juce::String(numAccepted) + " of " + juce::String(numPushes) + " pushes accepted, "
+            + juce::String(numPulled) + " pulled"
+            + (numPulled > 0 ? " (" + juce::String(first) + " - " + juce::String(last) + ")" : juce::String());
+    }
+
+    void runFifo(const HarnessOptions& options, PhaseTimer& timer)
+    {
+        const auto numRoundTrips = juce::jmax(1000, options.numBlocks * 100);
+
+        // analyzer blocks, one channel per element
+        {
+            CopyingFifo<juce::AudioBuffer<float>> copying;
+            Fifo<juce::AudioBuffer<float>, 30> swapping;
+            copying.prepare(1, options.blockSize);
+            swapping.prepare(1, options.blockSize);
+
+            juce::AudioBuffer<float> in(1, options.blockSize), out(1, options.blockSize);
+            in.clear();
+            out.clear();
+
+            measureRoundTrips(timer, "blocks, copying", copying, in, out, numRoundTrips);
+            measureRoundTrips(timer, "blocks, swapping", swapping, in, out, numRoundTrips);
+        }
+
+        // FFT frames
+        {
+            constexpr size_t frameSize = 2048 * 2;
+            CopyingFifo<std::vector<float>> copying;
+            Fifo<std::vector<float>, 30> swapping;
+            copying.prepare(frameSize);
+            swapping.prepare(frameSize);
+
+            std::vector<float> in(frameSize, 0.f), out(frameSize, 0.f);
+
+            measureRoundTrips(timer, "fft frames, copying", copying, in, out, numRoundTrips);
+            measureRoundTrips(timer, "fft frames, swapping", swapping, in, out, numRoundTrips);
+        }
+
+        // a stalled consumer: 40 pushes into 30 slots
+        {
+            constexpr int numPushes = 40;
+
+            CopyingFifo<std::vector<float>> copying;
+            copying.prepare(16);
+            timer.addNote("overflow, copying: " + describeOverflow(copying, numPushes));
+
+            Fifo<std::vector<float>, 30, FifoPolicy::DropNewest> dropNewest;
+            dropNewest.prepare(16);
+            timer.addNote("overflow, drop newest: " + describeOverflow(dropNewest, numPushes)
+                + ", " + juce::String(dropNewest.getNumOverflows()) + " overflows counted");
+
+            Fifo<std::vector<float>, 30, FifoPolicy::OverwriteOldest> overwriteOldest;
+            overwriteOldest.prepare(16);
+            const auto overwritten = describeOverflow(overwriteOldest, numPushes);
+            timer.addNote("overflow, overwrite oldest: " + overwritten
+                + ", " + juce::String(overwriteOldest.getNumOverflows()) + " overflows counted");
+
+            Fifo<std::vector<float>, 30, FifoPolicy::LatestOnly> latestOnly;
+            latestOnly.prepare(16);
+            const auto latest = describeOverflow(latestOnly, numPushes);
+            timer.addNote("overflow, latest only: " + latest
+                + ", " + juce::String(latestOnly.getNumOverflows()) + " overflows counted");
+
+            // the policies promise the newest element survives, and every lost one is counted
+            if (!overwritten.endsWith("(10 - 39)") || overwriteOldest.getNumOverflows() != numPushes - 30)
+                timer.addFailure("OverwriteOldest didn't keep the newest 30 elements");
+            if (!latest.endsWith("(39 - 39)") || latestOnly.getNumOverflows() != numPushes - 1)
+                timer.addFailure("LatestOnly didn't skip straight to the newest element");
+            if (dropNewest.getNumOverflows() != numPushes - 30)
+                timer.addFailure("DropNewest didn't count every rejected push");
+        }
+    }
+
+    //==============================================================================
+    ResponseCurveComponent* findResponseCurve(juce::Component& parent)
+    {
+        for (auto* child : parent.getChildren())
+            if (auto* responseCurve = dynamic_cast<ResponseCurveComponent*>(child))
+                return responseCurve;
+
+        return nullptr;
+    }
+
+    void runEditor(const HarnessOptions& options, PhaseTimer& timer)
+    {
+        auto processor = createPreparedProcessor(options.sampleRate, options.blockSize);
+
+        timer.begin("open editor");
+        std::unique_ptr<juce::AudioProcessorEditor> editor(processor->createEditor());
+        auto* responseCurve = findResponseCurve(*editor);
+        timer.end();
+
+        if (responseCurve == nullptr)
+        {
+            timer.addNote("no ResponseCurveComponent in the editor");
+            return;
+        }
+
+        responseCurve->setRenderingOffscreen(true);
+        juce::Image image(juce::Image::ARGB, responseCurve->getWidth(), responseCurve->getHeight(), true);
+
+        SignalGenerator signal(options.seed, options.sampleRate);
+        juce::AudioBuffer<float> buffer(2, options.blockSize);
+        juce::MidiBuffer midi;
+
+        // audio for one display frame between paints, as at 60 Hz in a host
+        const auto blocksPerFrame = juce::jmax(1, juce::roundToInt(options.sampleRate / options.blockSize / 60.0));
+        const auto numFrames = juce::jmax(1, options.numBlocks / blocksPerFrame);
+
+        double paintMilliseconds = 0;
+
+        timer.begin("frames", numFrames, "frame");
+        for (int frame = 0; frame < numFrames; ++frame)
+        {
+            for (int block = 0; block < blocksPerFrame; ++block)
+            {
+                signal.fill(buffer);
+                processor->processBlock(buffer, midi);
+            }
+
+            // the worker runs on its own, give it the rest of the frame like a host would
+            juce::Thread::sleep(1);
+            responseCurve->refreshAnalyzer();
+
+            const auto start = juce::Time::getMillisecondCounterHiRes();
+            juce::Graphics g(image);
+            responseCurve->paint(g);
+            paintMilliseconds += juce::Time::getMillisecondCounterHiRes() - start;
+        }
+
+        timer.begin("close editor");
+        editor.reset();
+        timer.end();
+
+        timer.addNote("paint " + juce::String(paintMilliseconds * 1000.0 / numFrames, 1) + " us/frame");
+        for (const auto& line : processor->analyzerStats.createReport())
+            timer.addNote(line);
+    }
+}
+
+const std::vector<Scenario>& getScenarios()
+{
+    static const std::vector<Scenario> scenarios
+    {
+        { "session",    "many instances round-robined like a console (--instances)", runSession },
+        { "automation", "static, every-band sweep and morph sweep on one instance",    runAutomation },
+        { "offline",    "the band sweep bounced non-realtime at every quality tier",   runOffline },
+        { "bypass",     "all bands, no bands, and both bypass paths once faded",      runBypass },
+        { "transparent", "skipped flat sections: cost and a check of the flatness bound", runTransparent },
+        { "registry",   "seven parameter lookups by ID vs the registry, per block",   runRegistry },
+        { "design",     "cut designs from the prototype tables against FilterDesign",  runDesign },
+        { "cuts",       "every cut family: design time, level at the cutoff, cost per section", runCuts },
+        { "slopes",     "slope automation: crossfade cost and the largest step it leaves", runSlopes },
+        { "crossover",  "2 - 5 band split timings and the flatness of the summed bands", runCrossover },
+        { "fifo",       "old copying Fifo vs the swapping ring: push/pull cost, overflow", runFifo },
+        { "multirate",  "a 20 Hz cut decimated at 96 - 384 kHz: latency, error vs double, cost", runMultirate },
+        { "presets",    "state storm, then recall, search and programs in a generated bank (--presets)", runPresets },
+        { "file",       "an audio file through one instance (--input)",                runFile },
+        { "editor",     "editor rendered offscreen, times ResponseCurveComponent::paint", runEditor },
+        { "trace",      "cost of trace markers, alone and in processBlock",           runTrace },
+        { "golden",     "kernel, MonoChain and curve against double precision references", runGolden },
+    };
+
+    return scenarios;
+}
@@ -0,0 +1,69 @@
+/*
+  ==============================================================================
+
+    AnalyzerService.cpp
+    One analyzer worker, FFT plans and display timer shared by every instance.
+
+  ==============================================================================
+*/
+
+#include "AnalyzerService.h"
+#include "Trace.h"
+
+AnalyzerService::Plan::Plan(int order) :
+    fft(order),
+    window((size_t)(1 << order), juce::dsp::WindowingFunction<float>::blackmanHarris)
+{
+}
+
+AnalyzerService::AnalyzerService()
+{
+}
+
+AnalyzerService::~AnalyzerService()
+{
+    jassert(clients.isEmpty());
+    stopTimer();
+}
+
+void AnalyzerService::addClient(Client& client)
+{
+    JUCE_ASSERT_MESSAGE_THREAD
+
+    clients.addIfNotAlreadyThere(&client);
+    worker.addTimeSliceClient(&client);
+
+    if (!isTimerRunning())
+        startTimerHz(framesPerSecond);
+}
+
+void AnalyzerService::removeClient(Client& client)
+{
+    JUCE_ASSERT_MESSAGE_THREAD
+
+    worker.removeTimeSliceClient(&client);
+    clients.removeFirstMatchingValue(&client);
+
+    if (clients.isEmpty())
+        stopTimer();
+}
+
+const AnalyzerService::Plan& AnalyzerService::getPlan(int order)
+{
+    const juce::ScopedLock lock(planLock);
+
+    auto& plan = plans[order];
+    if (plan == nullptr)
+        plan = std::make_unique<Plan>(order);
+
+    return *plan;
+}
+
+void AnalyzerService::timerCallback()
+{
+    EQTUT_TRACE_SCOPE("analyzer timerCallback");
+
+    // clients are only added and removed on this thread
+    for (auto* client : clients)
+        client->refreshAnalyzer();
+}
@@ -0,0 +1,74 @@
+/*
+  ==============================================================================
+
+    AnalyzerService.h
+    One analyzer worker, FFT plans and display timer shared by every instance.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include <map>
+
+/**
+ editors register as clients. the worker thread runs every client's transforms in turn
+ with FFT plans and window tables shared per size, and one 60 Hz timer on the message
+ thread hands each client its render-ready data. with many editors open that's still
+ one thread and one timer, and clients that aren't showing skip the transforms.
+
+ use it through juce::SharedResourcePointer, it lives while any editor holds one.
+ */
+class AnalyzerService : private juce::Timer
+{
+public:
+    static constexpr int framesPerSecond = 60;
+
+    struct Client : juce::TimeSliceClient
+    {
+        // message thread, once per display frame: pick up what the worker produced
+        virtual void refreshAnalyzer() = 0;
+    };
+
+    struct Plan
+    {
+        explicit Plan(int order);
+
+        int getSize() const { return fft.getSize(); }
+
+        const juce::dsp::FFT fft;
+        const juce::dsp::WindowingFunction<float> window;
+    };
+
+    AnalyzerService();
+    ~AnalyzerService() override;
+
+    // message thread only
+    void addClient(Client& client);
+
+    // message thread only, blocks until the worker is out of the client's useTimeSlice()
+    void removeClient(Client& client);
+
+    // created on first use, then shared by every client for the life of the service
+    const Plan& getPlan(int order);
+
+private:
+    struct Worker : juce::TimeSliceThread
+    {
+        Worker() : juce::TimeSliceThread("Analyzer") { startThread(); }
+        ~Worker() override { stopThread(1000); }
+    };
+
+    juce::Array<Client*> clients;
+
+    juce::CriticalSection planLock;
+    std::map<int, std::unique_ptr<Plan>> plans;
+
+    // declared last so it stops before the plans go
+    Worker worker;
+
+    void timerCallback() override;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(AnalyzerService)
+};
@@ -0,0 +1,75 @@
+/*
+  ==============================================================================
+
+    AnalyzerStats.cpp
+    Latency, jitter and drop counters for the audio-to-pixels analyzer path.
+
+  ==============================================================================
+*/
+
+#include "AnalyzerStats.h"
+
+AnalyzerStats::StageSummary AnalyzerStats::getSummary(Stage stage) const
+{
+    const auto& s = stages[stage];
+    const auto count = s.count.load(std::memory_order_relaxed);
+    if (count == 0)
+        return { 0, 0, 0, 0 };
+
+    const auto mean = double(s.sum.load(std::memory_order_relaxed)) / double(count);
+    const auto meanSquare = double(s.sumOfSquares.load(std::memory_order_relaxed)) / double(count);
+    const auto variance = juce::jmax(0.0, meanSquare - mean * mean);
+
+    return { count, mean / 1000.0, std::sqrt(variance) / 1000.0, double(s.max.load(std::memory_order_relaxed)) / 1000.0 };
+}
+
+AnalyzerStats::QueueSummary AnalyzerStats::getSummary(Queue queue) const
+{
+    return { queues[queue].pushed.load(std::memory_order_relaxed), queues[queue].dropped.load(std::memory_order_relaxed) };
+}
+
+juce::StringArray AnalyzerStats::createReport() const
+{
+    static constexpr const char* stageNames[] = { "audio interval", "fft", "path", "paint" };
+    static constexpr const char* queueNames[] = { "sample fifo", "fft fifo", "path fifo" };
+    static_assert(std::size(stageNames) == NumStages && std::size(queueNames) == NumQueues);
+
+    juce::StringArray lines;
+
+    for (int i = 0; i < NumStages; ++i)
+    {
+        auto s = getSummary(Stage(i));
+        lines.add(juce::String(stageNames[i]).paddedRight(' ', 15)
+                  + "n " + juce::String(s.count)
+                  + "  mean " + juce::String(s.meanMs, 2)
+                  + "  jitter " + juce::String(s.jitterMs, 2)
+                  + "  max " + juce::String(s.maxMs, 2) + " ms");
+    }
+
+    for (int i = 0; i < NumQueues; ++i)
+    {
+        auto q = getSummary(Queue(i));
+        lines.add(juce::String(queueNames[i]).paddedRight(' ', 15)
+                  + "pushed " + juce::String(q.pushed)
+                  + "  dropped " + juce::String(q.dropped));
+    }
+
+    return lines;
+}
+
+void AnalyzerStats::reset()
+{
+    for (auto& s : stages)
+    {
+        s.count.store(0);
+        s.sum.store(0);
+        s.sumOfSquares.store(0);
+        s.max.store(0);
+    }
+
+    for (auto& q : queues)
+    {
+        q.pushed.store(0);
+        q.dropped.store(0);
+    }
+}
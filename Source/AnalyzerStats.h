@@ -0,0 +1,101 @@
+/*
+  ==============================================================================
+
+    AnalyzerStats.h
+    Latency, jitter and drop counters for the audio-to-pixels analyzer path.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include <atomic>
+
+/**
+ every analyzer frame carries the high resolution tick count of the audio block that
+ completed it. each later stage records how old that frame is when it gets there, and
+ every fifo push that fails is counted. all of it is plain atomics, so the audio thread
+ can record without locking and the UI can read while both sides are running.
+ */
+struct AnalyzerStats
+{
+    enum Stage
+    {
+        AudioBlock,     // interval between completed analyzer buffers
+        FFTComplete,    // audio block -> FFT data ready
+        PathComplete,   // audio block -> path ready
+        Paint,          // audio block -> first time the path is painted
+        NumStages
+    };
+
+    enum Queue
+    {
+        SampleQueue,
+        FFTQueue,
+        PathQueue,
+        NumQueues
+    };
+
+    struct StageSummary
+    {
+        juce::int64 count;
+        double meanMs;
+        double jitterMs;    // standard deviation
+        double maxMs;
+    };
+
+    struct QueueSummary
+    {
+        juce::int64 pushed;
+        juce::int64 dropped;
+    };
+
+    static juce::int64 now() { return juce::Time::getHighResolutionTicks(); }
+
+    void record(Stage stage, juce::int64 sourceTicks, juce::int64 ticks = now())
+    {
+        if (sourceTicks == 0)
+            return;
+
+        auto& s = stages[stage];
+        const auto micros = juce::jmax<juce::int64>(0, juce::int64(juce::Time::highResolutionTicksToSeconds(ticks - sourceTicks) * 1.0e6));
+
+        s.count.fetch_add(1, std::memory_order_relaxed);
+        s.sum.fetch_add(micros, std::memory_order_relaxed);
+        s.sumOfSquares.fetch_add(micros * micros, std::memory_order_relaxed);
+
+        auto max = s.max.load(std::memory_order_relaxed);
+        while (micros > max && !s.max.compare_exchange_weak(max, micros, std::memory_order_relaxed)) {}
+    }
+
+    void recordPush(Queue queue, bool succeeded)
+    {
+        queues[queue].pushed.fetch_add(1, std::memory_order_relaxed);
+        if (!succeeded)
+            queues[queue].dropped.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    StageSummary getSummary(Stage stage) const;
+    QueueSummary getSummary(Queue queue) const;
+
+    // one line per stage and queue, for the debug overlay and benchmark runs
+    juce::StringArray createReport() const;
+
+    // not atomic as a whole, counters recorded during the reset may survive it
+    void reset();
+
+private:
+    struct StageCounters
+    {
+        std::atomic<juce::int64> count{ 0 }, sum{ 0 }, sumOfSquares{ 0 }, max{ 0 };
+    };
+
+    struct QueueCounters
+    {
+        std::atomic<juce::int64> pushed{ 0 }, dropped{ 0 };
+    };
+
+    std::array<StageCounters, NumStages> stages;
+    std::array<QueueCounters, NumQueues> queues;
+};
@@ -0,0 +1,110 @@
+/*
+  ==============================================================================
+
+    ButterworthDesign.h
+    Compile-time Butterworth prototypes and a cut designer into fixed storage.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+
+/**
+ the analog prototype of an even order Butterworth, as second order sections in the
+ order FilterDesign::designIIR*HighOrderButterworthMethod returns them. the cut filters
+ only ever use the even orders 2 to 16, so every prototype is worked out by the compiler
+ and a design is left with one tan() for the cutoff's prewarp.
+ */
+struct ButterworthPrototype
+{
+    static constexpr int maxSections = 8;   // order 16, 96 dB/oct
+
+    int numSections = 0;
+    std::array<double, maxSections> q{};
+
+    // 1 / Q as IIR::Coefficients computes it from the float Q FilterDesign passes in
+    std::array<float, maxSections> floatInvQ{};
+    std::array<double, maxSections> invQ{};
+
+    template<typename FloatType>
+    constexpr FloatType getInvQ(int section) const
+    {
+        if constexpr (std::is_same_v<FloatType, float>)
+            return floatInvQ[(size_t)section];
+        else
+            return FloatType(invQ[(size_t)section]);
+    }
+
+    // Taylor series, only ever evaluated on (0, pi/2) at compile time
+    static constexpr double cosine(double x)
+    {
+        double term = 1, sum = 1;
+        for (int i = 1; i < 30; ++i)
+        {
+            term *= -x * x / double((2 * i - 1) * (2 * i));
+            sum += term;
+        }
+        return sum;
+    }
+
+    static constexpr ButterworthPrototype make(int numSections)
+    {
+        ButterworthPrototype prototype;
+        prototype.numSections = numSections;
+
+        const auto order = numSections * 2;
+        for (int i = 0; i < numSections; ++i)
+        {
+            const auto q = 1.0 / (2.0 * cosine((2.0 * i + 1.0) * juce::MathConstants<double>::pi / (order * 2.0)));
+            prototype.q[(size_t)i] = q;
+            prototype.floatInvQ[(size_t)i] = 1.f / float(q);
+            prototype.invQ[(size_t)i] = 1.0 / q;
+        }
+        return prototype;
+    }
+};
+
+inline constexpr std::array<ButterworthPrototype, ButterworthPrototype::maxSections> butterworthPrototypes
+{
+    ButterworthPrototype::make(1), ButterworthPrototype::make(2), ButterworthPrototype::make(3), ButterworthPrototype::make(4),
+    ButterworthPrototype::make(5), ButterworthPrototype::make(6), ButterworthPrototype::make(7), ButterworthPrototype::make(8)
+};
+
+static_assert(butterworthPrototypes[0].q[0] > 0.70710678 && butterworthPrototypes[0].q[0] < 0.70710679, "second order Butterworth Q is 1/sqrt(2)");
+
+constexpr const ButterworthPrototype& getButterworthPrototype(int numSections)
+{
+    return butterworthPrototypes[(size_t)(numSections < 1 ? 0 : numSections > ButterworthPrototype::maxSections ? ButterworthPrototype::maxSections - 1 : numSections - 1)];
+}
+
+/**
+ writes numSections normalised sections (b0, b1, b2, a1, a2) of a Butterworth high pass
+ or low pass into sections, with IIR::Coefficients::makeHighPass / makeLowPass's
+ arithmetic in the sections' own precision. for float that's the same coefficients,
+ bit for bit, FilterDesign<float> would allocate.
+ */
+template<typename Section>
+void designButterworthCut(Section* sections, int numSections, bool highPass, decltype(Section::b0) frequency, double sampleRate)
+{
+    using FloatType = decltype(Section::b0);
+    const auto& prototype = getButterworthPrototype(numSections);
+
+    // the only thing that depends on the cutoff
+    const auto t = std::tan(juce::MathConstants<FloatType>::pi * frequency / static_cast<FloatType>(sampleRate));
+    const auto n = highPass ? t : FloatType(1) / t;
+    const auto nSquared = n * n;
+
+    for (int i = 0; i < prototype.numSections; ++i)
+    {
+        const auto invQ = prototype.template getInvQ<FloatType>(i);
+        const auto c1 = FloatType(1) / (FloatType(1) + invQ * n + nSquared);
+
+        sections[i] = { c1,
+                        c1 * (highPass ? FloatType(-2) : FloatType(2)),
+                        c1,
+                        c1 * FloatType(2) * (highPass ? nSquared - FloatType(1) : FloatType(1) - nSquared),
+                        c1 * (FloatType(1) - invQ * n + nSquared) };
+    }
+}
@@ -0,0 +1,297 @@
+/*
+  ==============================================================================
+
+    Crossover.cpp
+    Linkwitz-Riley band split with per-band gain, mute and solo.
+
+  ==============================================================================
+*/
+
+#include "Crossover.h"
+#include "ButterworthDesign.h"
+
+namespace
+{
+    struct Section
+    {
+        float b0 = 1, b1 = 0, b2 = 0, a1 = 0, a2 = 0;
+    };
+
+    // the second order Butterworth section the cuts use at 12 dB/oct, designed without allocating
+    Section getButterworthSection(bool highPass, float frequency, double sampleRate)
+    {
+        Section section;
+        designButterworthCut(&section, 1, highPass, frequency, sampleRate);
+        return section;
+    }
+
+    // low pass + high pass of a fourth order Linkwitz-Riley pair: the section's denominator, mirrored on top
+    Section getAllPass(const Section& butterworth)
+    {
+        return { butterworth.a2, butterworth.a1, 1.f, butterworth.a1, butterworth.a2 };
+    }
+}
+
+float CrossoverSettings::getBandGain(int band) const
+{
+    if (!juce::isPositiveAndBelow(band, numBands))
+        return 0.f;
+
+    const auto anySolo = std::any_of(solo.begin(), solo.begin() + numBands, [](bool s) { return s; });
+    if (mute[(size_t)band] || (anySolo && !solo[(size_t)band]))
+        return 0.f;
+
+    return juce::Decibels::decibelsToGain(gainsDB[(size_t)band]);
+}
+
+size_t Crossover::getRequiredBytes(int numChannels)
+{
+    return (DSPArena::getAlignedSize(sizeof(Design))
+          + DSPArena::getAlignedSize(sizeof(ChannelState) * (size_t)numChannels)) * 2;
+}
+
+void Crossover::prepare(DSPArena& arena, int newNumChannels, double newSampleRate)
+{
+    numChannels = newNumChannels;
+    sampleRate = newSampleRate;
+    design = arena.allocate<Design>();
+    fadingDesign = arena.allocate<Design>();
+    states = arena.allocate<ChannelState>((size_t)numChannels);
+    fadingStates = arena.allocate<ChannelState>((size_t)numChannels);
+
+    numBands = 0;
+    numSections = 0;
+    fadingNumSections = 0;
+    current = {};
+
+    // switched off: no sections and lane 0 passing the input through, what a first fade starts from
+    alignas(sizeof(Lanes)) std::array<float, lanesPerRegister> passThrough{ 1.f };
+    design->gains[0] = design->targetGains[0] = Lanes::fromRawArray(passThrough.data());
+
+    fadeLength = juce::jmax(1, juce::roundToInt(sampleRate * 0.02));
+    fadeSamplesRemaining = 0;
+    switchPending = false;
+}
+
+void Crossover::reset()
+{
+    for (int ch = 0; ch < numChannels; ++ch)
+        states[ch] = {};
+
+    // a change that was waiting on the fade goes in straight away, there's nothing to fade from
+    fadeSamplesRemaining = 0;
+    if (switchPending)
+    {
+        switchPending = false;
+        switchTo(pendingSettings, false);
+    }
+}
+
+void Crossover::setSettings(const CrossoverSettings& settings)
+{
+    if (design == nullptr)
+        return;
+
+    if (switchPending)
+    {
+        pendingSettings = settings;
+        return;
+    }
+
+    if (settings != current)
+        switchTo(settings, true);
+}
+
+void Crossover::switchTo(const CrossoverSettings& settings, bool canFade)
+{
+    const auto wasActive = isActive();
+    const auto pointsMoved = settings.numBands != current.numBands
+        || !std::equal(settings.frequencies.begin(), settings.frequencies.begin() + juce::jmax(0, settings.numBands - 1),
+                       current.frequencies.begin());
+
+    const auto fade = canFade && pointsMoved && (wasActive || settings.numBands > 1);
+    if (fade && fadeSamplesRemaining > 0)
+    {
+        // the running fade finishes first, or the half-faded split would jump
+        switchPending = true;
+        pendingSettings = settings;
+        return;
+    }
+
+    if (fade)
+    {
+        *fadingDesign = *design;
+        fadingDesign->targetGains = fadingDesign->gains;
+        std::copy(states, states + numChannels, fadingStates);
+        fadingNumSections = numSections;
+        fadeSamplesRemaining = fadeLength;
+    }
+
+    if (pointsMoved)
+        designSections(settings);
+
+    // fromRawArray wants register-aligned memory. switched off, lane 0 passes the input through,
+    // so a fade into or out of the split has a design on both sides
+    alignas(sizeof(Lanes)) std::array<float, numRegisters * lanesPerRegister> gains{};
+    for (int band = 0; band < settings.numBands; ++band)
+        gains[(size_t)band] = settings.getBandGain(band);
+    if (settings.numBands < 2)
+        gains[0] = 1.f;
+
+    for (int r = 0; r < numRegisters; ++r)
+        design->targetGains[(size_t)r] = Lanes::fromRawArray(gains.data() + r * lanesPerRegister);
+
+    // a new split starts from silence in every band's filters and at its target gains, the fade covers the rest
+    if (pointsMoved || (!wasActive && isActive()))
+    {
+        for (int ch = 0; ch < numChannels; ++ch)
+            states[ch] = {};
+
+        design->gains = design->targetGains;
+    }
+
+    current = settings;
+}
+
+void Crossover::designSections(const CrossoverSettings& settings)
+{
+    numBands = settings.numBands >= 2 ? juce::jmin(settings.numBands, CrossoverSettings::maxBands) : 0;
+    numSections = numBands > 1 ? 2 * (numBands - 1) : 0;
+
+    // ascending and below nyquist, so the bands can't overlap
+    std::array<float, CrossoverSettings::maxBands - 1> points{};
+    for (int i = 0; i < numBands - 1; ++i)
+        points[(size_t)i] = juce::jlimit(10.f, float(sampleRate * 0.45), settings.frequencies[(size_t)i]);
+    std::sort(points.begin(), points.begin() + juce::jmax(0, numBands - 1));
+
+    // lane by lane: band k sees high passes below it, its low pass, then all-passes above it
+    std::array<std::array<Section, numRegisters * lanesPerRegister>, maxSections> laneSections{};
+
+    for (int point = 0; point < numBands - 1; ++point)
+    {
+        const auto lowPass = getButterworthSection(false, points[(size_t)point], sampleRate);
+        const auto highPass = getButterworthSection(true, points[(size_t)point], sampleRate);
+        const auto allPass = getAllPass(lowPass);
+
+        for (int band = 0; band < numBands; ++band)
+        {
+            auto& first = laneSections[(size_t)(2 * point)][(size_t)band];
+            auto& second = laneSections[(size_t)(2 * point + 1)][(size_t)band];
+
+            if (band > point)
+                first = second = highPass;
+            else if (band == point)
+                first = second = lowPass;
+            else
+                first = allPass;    // second stays a pass-through section
+        }
+    }
+
+    for (int section = 0; section < maxSections; ++section)
+    {
+        for (int r = 0; r < numRegisters; ++r)
+        {
+            alignas(sizeof(Lanes)) std::array<float, lanesPerRegister> b0, b1, b2, a1, a2;
+            for (int lane = 0; lane < lanesPerRegister; ++lane)
+            {
+                const auto& s = laneSections[(size_t)section][(size_t)(r * lanesPerRegister + lane)];
+                b0[(size_t)lane] = s.b0;
+                b1[(size_t)lane] = s.b1;
+                b2[(size_t)lane] = s.b2;
+                a1[(size_t)lane] = s.a1;
+                a2[(size_t)lane] = s.a2;
+            }
+
+            auto& lanes = design->sections[(size_t)section][(size_t)r];
+            lanes.b0 = Lanes::fromRawArray(b0.data());
+            lanes.b1 = Lanes::fromRawArray(b1.data());
+            lanes.b2 = Lanes::fromRawArray(b2.data());
+            lanes.a1 = Lanes::fromRawArray(a1.data());
+            lanes.a2 = Lanes::fromRawArray(a2.data());
+        }
+    }
+}
+
+Crossover::Lanes Crossover::processSample(const Design& design, ChannelState& state, int numSections,
+                                          std::array<Lanes, numRegisters>& gains, const std::array<Lanes, numRegisters>& gainSteps, float input)
+{
+    const auto in = Lanes::expand(input);
+    auto output = Lanes::expand(0.f);
+
+    for (int r = 0; r < numRegisters; ++r)
+    {
+        auto x = in;
+
+        // transposed direct form II, all bands of this register at once
+        for (int section = 0; section < numSections; ++section)
+        {
+            const auto& c = design.sections[(size_t)section][(size_t)r];
+            auto& s1 = state.s1[(size_t)section][(size_t)r];
+            auto& s2 = state.s2[(size_t)section][(size_t)r];
+
+            const auto y = c.b0 * x + s1;
+            s1 = c.b1 * x - c.a1 * y + s2;
+            s2 = c.b2 * x - c.a2 * y;
+            x = y;
+        }
+
+        gains[(size_t)r] += gainSteps[(size_t)r];
+        output += x * gains[(size_t)r];
+    }
+
+    return output;
+}
+
+void Crossover::process(juce::AudioBuffer<float>& buffer)
+{
+    if (!isActive() && fadeSamplesRemaining == 0)
+        return;
+
+    const auto numSamples = buffer.getNumSamples();
+    if (numSamples == 0)
+        return;
+
+    // every channel ramps the same way, from the gains the last block ended on
+    std::array<Lanes, numRegisters> gainSteps, noSteps;
+    for (int r = 0; r < numRegisters; ++r)
+    {
+        gainSteps[(size_t)r] = (design->targetGains[(size_t)r] - design->gains[(size_t)r]) * Lanes::expand(1.f / float(numSamples));
+        noSteps[(size_t)r] = Lanes::expand(0.f);
+    }
+
+    const auto fadePosition = fadeLength - fadeSamplesRemaining;
+    const auto fadeSamples = juce::jmin(numSamples, fadeSamplesRemaining);
+
+    for (int ch = 0; ch < juce::jmin(numChannels, buffer.getNumChannels()); ++ch)
+    {
+        auto* samples = buffer.getWritePointer(ch);
+        auto gains = design->gains;
+        auto fadingGains = fadingDesign->gains;
+
+        for (int i = 0; i < numSamples; ++i)
+        {
+            auto output = processSample(*design, states[ch], numSections, gains, gainSteps, samples[i]).sum();
+
+            if (i < fadeSamples)
+            {
+                const auto previous = processSample(*fadingDesign, fadingStates[ch], fadingNumSections, fadingGains, noSteps, samples[i]).sum();
+                const auto gain = float(fadePosition + i + 1) / float(fadeLength);
+                output = previous + gain * (output - previous);
+            }
+
+            samples[i] = output;
+        }
+    }
+
+    design->gains = design->targetGains;
+
+    if (fadeSamplesRemaining > 0)
+    {
+        fadeSamplesRemaining -= fadeSamples;
+        if (fadeSamplesRemaining == 0 && switchPending)
+        {
+            switchPending = false;
+            switchTo(pendingSettings, true);
+        }
+    }
+}
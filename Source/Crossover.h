@@ -0,0 +1,113 @@
+/*
+  ==============================================================================
+
+    Crossover.h
+    Linkwitz-Riley band split with per-band gain, mute and solo.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include "DSPArena.h"
+
+struct CrossoverSettings
+{
+    static constexpr int maxBands = 5;
+
+    int numBands{ 0 };  // 0 (off) or 2 - maxBands
+    std::array<float, maxBands - 1> frequencies{};
+    std::array<float, maxBands> gainsDB{};
+    std::array<bool, maxBands> mute{};
+    std::array<bool, maxBands> solo{};
+
+    // the linear gain each band is summed with, mute and solo applied
+    float getBandGain(int band) const;
+};
+
+inline bool operator==(const CrossoverSettings& a, const CrossoverSettings& b)
+{
+    return a.numBands == b.numBands && a.frequencies == b.frequencies && a.gainsDB == b.gainsDB
+        && a.mute == b.mute && a.solo == b.solo;
+}
+
+inline bool operator!=(const CrossoverSettings& a, const CrossoverSettings& b) { return !(a == b); }
+
+/**
+ every band is its own cascade straight from the input, so the bands run side by side
+ in SIMD lanes: one pass per channel filters all of them at once. each crossover point
+ is a fourth order Linkwitz-Riley stage (two second order Butterworth sections, the
+ designs the cut filters use), a low pass for the band below it, a high pass for the
+ bands above, and the matching all-pass for the bands below that, so the bands sum
+ back to a flat, phase coherent all-pass whatever the gains are.
+
+ moving a point or changing the number of bands moves bands to other lanes, so the old
+ split keeps running on its own state and is crossfaded into the new one, started from
+ silence, like the EQ kernel's slope switch. a change that arrives mid-fade waits for it.
+ */
+class Crossover
+{
+public:
+    using Lanes = juce::dsp::SIMDRegister<float>;
+
+    static constexpr int lanesPerRegister = (int)Lanes::SIMDNumElements;
+    static constexpr int numRegisters = (CrossoverSettings::maxBands + lanesPerRegister - 1) / lanesPerRegister;
+
+    // two sections per crossover point
+    static constexpr int maxSections = 2 * (CrossoverSettings::maxBands - 1);
+
+    static size_t getRequiredBytes(int numChannels);
+
+    void prepare(DSPArena& arena, int numChannels, double sampleRate);
+
+    // gains ramp over the next block, a change of the points or band count crossfades
+    void setSettings(const CrossoverSettings& settings);
+    void reset();
+
+    bool isActive() const { return numBands > 1; }
+
+    void process(juce::AudioBuffer<float>& buffer);
+
+private:
+    struct LaneSection
+    {
+        Lanes b0, b1, b2, a1, a2;
+    };
+
+    struct Design
+    {
+        std::array<std::array<LaneSection, numRegisters>, maxSections> sections;
+        std::array<Lanes, numRegisters> gains;
+        std::array<Lanes, numRegisters> targetGains;
+    };
+
+    struct alignas(DSPArena::alignment) ChannelState
+    {
+        std::array<std::array<Lanes, numRegisters>, maxSections> s1, s2;
+    };
+
+    // the split being faded out keeps its own design and state
+    Design* design = nullptr;
+    Design* fadingDesign = nullptr;
+    ChannelState* states = nullptr;
+    ChannelState* fadingStates = nullptr;
+    int numChannels = 0;
+    double sampleRate = 0;
+
+    int numBands = 0;
+    int numSections = 0;
+    int fadingNumSections = 0;
+    CrossoverSettings current;
+
+    int fadeLength = 1;
+    int fadeSamplesRemaining = 0;
+    bool switchPending = false;
+    CrossoverSettings pendingSettings;
+
+    void switchTo(const CrossoverSettings& settings, bool canFade);
+    void designSections(const CrossoverSettings& settings);
+
+    static Lanes processSample(const Design& design, ChannelState& state, int numSections,
+                               std::array<Lanes, numRegisters>& gains, const std::array<Lanes, numRegisters>& gainSteps, float input);
+};
@@ -0,0 +1,303 @@
+/*
+  ==============================================================================
+
+    CutDesign.cpp
+    Low and high cut families designed from analog prototype tables.
+
+  ==============================================================================
+*/
+
+#include "CutDesign.h"
+
+namespace
+{
+    /**
+     worked out offline in double, from the textbook pole and zero positions:
+     Bessel from the roots of the reverse Bessel polynomial, Chebyshev and elliptic
+     from their closed forms, the elliptic's modulus from the degree equation's nome
+     series. every low pass is then scaled so it is 3 dB down at 1 rad/s and each
+     section has unity gain at DC, so ripple rises above 0 dB rather than sinking
+     the pass band below it.
+
+     the elliptic's stop band deepens with the order, which keeps its highest Q
+     under 60 at 96 dB/oct instead of letting it run into the thousands.
+     */
+    const std::array<std::array<CutPrototype, CutPrototype::maxSections>, NumCutTypes - 1> prototypes
+    {{
+        // Linkwitz-Riley: the Butterworth of half the order, every section twice
+        {{
+            { 1, {{ { 1.0, 0.5, 0.0 } }} },
+            { 2, {{ { 1.0, 0.7071067811865476, 0.0 }, { 1.0, 0.7071067811865476, 0.0 } }} },
+            { 3, {{
+                { 1.0, 0.5, 0.0 },
+                { 1.0, 1.0, 0.0 },
+                { 1.0, 1.0, 0.0 },
+            }} },
+            { 4, {{
+                { 1.0, 0.541196100146197, 0.0 },
+                { 1.0, 0.541196100146197, 0.0 },
+                { 1.0, 1.306562964876377, 0.0 },
+                { 1.0, 1.306562964876377, 0.0 },
+            }} },
+            { 5, {{
+                { 1.0, 0.5, 0.0 },
+                { 1.0, 0.6180339887498948, 0.0 },
+                { 1.0, 0.6180339887498948, 0.0 },
+                { 1.0, 1.618033988749895, 0.0 },
+                { 1.0, 1.618033988749895, 0.0 },
+            }} },
+            { 6, {{
+                { 1.0, 0.5176380902050415, 0.0 },
+                { 1.0, 0.5176380902050415, 0.0 },
+                { 1.0, 0.7071067811865476, 0.0 },
+                { 1.0, 0.7071067811865476, 0.0 },
+                { 1.0, 1.931851652578137, 0.0 },
+                { 1.0, 1.931851652578137, 0.0 },
+            }} },
+            { 7, {{
+                { 1.0, 0.5, 0.0 },
+                { 1.0, 0.5549581320873712, 0.0 },
+                { 1.0, 0.5549581320873712, 0.0 },
+                { 1.0, 0.8019377358048383, 0.0 },
+                { 1.0, 0.8019377358048383, 0.0 },
+                { 1.0, 2.246979603717467, 0.0 },
+                { 1.0, 2.246979603717467, 0.0 },
+            }} },
+            { 8, {{
+                { 1.0, 0.5097955791041592, 0.0 },
+                { 1.0, 0.5097955791041592, 0.0 },
+                { 1.0, 0.6013448869350453, 0.0 },
+                { 1.0, 0.6013448869350453, 0.0 },
+                { 1.0, 0.8999762231364158, 0.0 },
+                { 1.0, 0.8999762231364158, 0.0 },
+                { 1.0, 2.562915447741506, 0.0 },
+                { 1.0, 2.562915447741506, 0.0 },
+            }} },
+        }},
+        // Bessel
+        {{
+            { 1, {{ { 1.272019649514069, 0.5773502691896257, 0.0 } }} },
+            { 2, {{ { 1.4301715599939908, 0.5219345816689802, 0.0 }, { 1.6033575162169733, 0.8055382818416658, 0.0 } }} },
+            { 3, {{
+                { 1.603919128773796, 0.5103178247487704, 0.0 },
+                { 1.6891682676204596, 0.6111945468780027, 0.0 },
+                { 1.9047076123027604, 1.023313953826724, 0.0 },
+            }} },
+            { 4, {{
+                { 1.7784659117746182, 0.5059910693974705, 0.0 },
+                { 1.8320926011985803, 0.5596091647957961, 0.0 },
+                { 1.9531957590220355, 0.7108520744416995, 0.0 },
+                { 2.1887262305274104, 1.2256694254081693, 0.0 },
+            }} },
+            { 5, {{
+                { 1.942704191660169, 0.503912727275614, 0.0 },
+                { 1.9805531088151225, 0.5375521513251429, 0.0 },
+                { 2.0622073179271188, 0.620470155556476, 0.0 },
+                { 2.203752625931104, 0.8097909648413326, 0.0 },
+                { 2.4506268430553435, 1.415308869163449, 0.0 },
+            }} },
+            { 6, {{
+                { 2.0961332254419602, 0.5027555581945734, 0.0 },
+                { 2.1247253847290866, 0.5259362020373202, 0.0 },
+                { 2.184967226389703, 0.57936723862217, 0.0 },
+                { 2.2843182539910347, 0.6840080681448608, 0.0 },
+                { 2.439126114318595, 0.9059471070239076, 0.0 },
+                { 2.6929892508415207, 1.5946569350718007, 0.0 },
+            }} },
+            { 7, {{
+                { 2.240057161361391, 0.5020454285920043, 0.0 },
+                { 2.262657465345263, 0.5190272932757303, 0.0 },
+                { 2.3096146223754395, 0.5566807727392452, 0.0 },
+                { 2.3849797694271144, 0.6247770824579552, 0.0 },
+                { 2.4966343458108526, 0.7476250682507437, 0.0 },
+                { 2.660690889563587, 0.9989984429945131, 0.0 },
+                { 2.919057144804353, 1.7655274349309875, 0.0 },
+            }} },
+            { 8, {{
+                { 2.375823081004773, 0.5015784002432008, 0.0 },
+                { 2.3942771006051777, 0.5145709536561707, 0.0 },
+                { 2.4322770797205964, 0.5426783660284659, 0.0 },
+                { 2.4922550482272032, 0.591144659532345, 0.0 },
+                { 2.57862945821014, 0.6713823795707865, 0.0 },
+                { 2.699350180689946, 0.8104103029044604, 0.0 },
+                { 2.8701609945665623, 1.0890637691784992, 0.0 },
+                { 3.131491674479267, 1.9292718407014395, 0.0 },
+            }} },
+        }},
+        // Chebyshev I, 0.1 dB ripple
+        {{
+            { 1, {{ { 0.9276011863261345, 0.7673593266495305, 0.0 } }} },
+            { 2, {{ { 0.6484865942368845, 0.6188009573912308, 0.0 }, { 0.94757633344521, 2.1829302792986796, 0.0 } }} },
+            { 3, {{
+                { 0.46882211898361004, 0.5994599705308236, 0.0 },
+                { 0.7623481488146602, 1.3315706699237702, 0.0 },
+                { 0.9708528316660545, 4.632901254046812, 0.0 },
+            }} },
+            { 4, {{
+                { 0.3624298698786768, 0.5931789395759814, 0.0 },
+                { 0.6127472943137986, 1.182961743765405, 0.0 },
+                { 0.8489253220048105, 2.452822938494773, 0.0 },
+                { 0.9822311532676907, 8.08190346000354, 0.0 },
+            }} },
+            { 5, {{
+                { 0.29414543287894224, 0.5903542152789863, 0.0 },
+                { 0.506455179035068, 1.1267579177973452, 0.0 },
+                { 0.729056020857698, 2.043837601227424, 0.0 },
+                { 0.8980804611649659, 3.9213803572234616, 0.0 },
+                { 0.9881922016562265, 12.522166296514849, 0.0 },
+            }} },
+            { 6, {{
+                { 0.24706924701136615, 0.5888413632886204, 0.0 },
+                { 0.42965830173461433, 1.098894616187833, 0.0 },
+                { 0.6313665539203842, 1.880455676300048, 0.0 },
+                { 0.8035855973514708, 3.1191280229811738, 0.0 },
+                { 0.9272363676164501, 5.725309653104266, 0.0 },
+                { 0.9916301351115032, 17.95147884406073, 0.0 },
+            }} },
+            { 7, {{
+                { 0.21279428755885174, 0.5879364460296381, 0.0 },
+                { 0.37228881921092943, 1.0829108897025854, 0.0 },
+                { 0.5538514156742281, 1.7959007914983258, 0.0 },
+                { 0.7186334502730557, 2.790316518100174, 0.0 },
+                { 0.8521248036868577, 4.397404674554085, 0.0 },
+                { 0.945658028461264, 7.861114378429249, 0.0 },
+                { 0.9937739495906669, 24.369038806473117, 0.0 },
+            }} },
+            { 8, {{
+                { 0.18677959060663368, 0.5873520407073161, 0.0 },
+                { 0.3280574244727875, 1.0728469607461413, 0.0 },
+                { 0.49195379563727054, 1.745690572560181, 0.0 },
+                { 0.6462325442226227, 2.616231819629781, 0.0 },
+                { 0.7795398437654393, 3.845497257416836, 0.0 },
+                { 0.8850312605712706, 5.875499640731522, 0.0 },
+                { 0.9579546938548663, 10.327462404931687, 0.0 },
+                { 0.9951945808549741, 31.774501062343184, 0.0 },
+            }} },
+        }},
+        // Chebyshev II, 60 dB stop band
+        {{
+            { 1, {{ { 1.0004996251872738, 0.7074605999633481, 31.638576137365526 } }} },
+            { 2, {{ { 1.0386511706737922, 0.5448919246647206, 3.700123480087857 }, { 1.0063253325553134, 1.3577423562214597, 8.932888288083237 } }} },
+            { 3, {{
+                { 1.1579872400323952, 0.5240921967199039, 1.9832077465942388 },
+                { 1.0759861587243276, 0.7704838830861656, 2.709112162829822 },
+                { 1.0092540372570122, 2.244184298731905, 7.4014320722538836 },
+            }} },
+            { 4, {{
+                { 1.3308721989032237, 0.5177562443310137, 1.515468581617233 },
+                { 1.2064250479033727, 0.6737346918068238, 1.7876170767656496 },
+                { 1.0781476610489147, 1.1282839858319436, 2.6753580185267065 },
+                { 1.008726771272697, 3.4342061776488793, 7.6187750494402575 },
+            }} },
+            { 5, {{
+                { 1.5330995898022912, 0.5150311883493778, 1.3192892896811477 },
+                { 1.370460769930273, 0.6386697274260864, 1.4624434433598303 },
+                { 1.190540352600753, 0.926391798014974, 1.8427862438308924 },
+                { 1.0668448623442381, 1.6101850447104775, 2.87020686564513 },
+                { 1.007285155358921, 4.949244949179819, 8.329664751018905 },
+            }} },
+            { 6, {{
+                { 1.7521519118306805, 0.5136125062201641, 1.2178190374994875 },
+                { 1.5532398164189678, 0.6217589596799331, 1.3068808046110882 },
+                { 1.3265683120911358, 0.8477731141372812, 1.5218949306608291 },
+                { 1.1579546039932886, 1.265718860125331, 1.9833720884355999 },
+                { 1.0543597713884933, 2.2112987745828847, 3.1550893628971513 },
+                { 1.0058950581382609, 6.795564983992405, 9.250253962641706 },
+            }} },
+            { 7, {{
+                { 1.9815335062138066, 0.5127793748532368, 1.1583211815678873 },
+                { 1.7472638492994172, 0.6122316642402281, 1.2194705257967973 },
+                { 1.4762400008659873, 0.8077810374897325, 1.3594012101591622 },
+                { 1.2673368217509213, 1.126718796680189, 1.6278134105438773 },
+                { 1.1276937152466764, 1.6829205668964695, 2.1634746322833727 },
+                { 1.043897442308911, 2.9285572539631834, 3.4850465369743033 },
+                { 1.004764803893025, 8.975278407079973, 10.28038482527203 },
+            }} },
+            { 8, {{
+                { 2.2176498206951134, 0.5122479545120601, 1.120372315237016 },
+                { 1.9484994755126737, 0.6063058390262467, 1.165148311422273 },
+                { 1.6343977438804178, 0.7843128608417622, 1.2642595902640974 },
+                { 1.3876322471674163, 1.0539430734883974, 1.442383361647815 },
+                { 1.216019177710214, 1.465473278006914, 1.7575492114172997 },
+                { 1.1034731035713972, 2.1733445424280737, 2.3652633317268954 },
+                { 1.0357174974461103, 3.7602046258389357, 3.840979230649717 },
+                { 1.0038865701805437, 11.489211722534844, 11.375331014161231 },
+            }} },
+        }},
+        // elliptic, 0.1 dB ripple, stop band max(60, 10 * order) dB
+        {{
+            { 1, {{ { 0.9280753141787749, 0.7678063627162859, 29.179861152994725 } }} },
+            { 2, {{ { 0.6754899016482356, 0.6256284228798336, 2.922439953491377 }, { 0.9541289474716019, 2.3245995404154667, 6.933944104420716 } }} },
+            { 3, {{
+                { 0.5546032713918946, 0.6137826952288828, 1.4877755855310266 },
+                { 0.8296403800751108, 1.5801782647293585, 1.9241291792519613 },
+                { 0.9814908021208127, 6.331637211284558, 4.9600595370354625 },
+            }} },
+            { 4, {{
+                { 0.44143276304893564, 0.602934783048892, 1.3735343194978988 },
+                { 0.7019280032304677, 1.3474006157313483, 1.551798781872261 },
+                { 0.8991925592715355, 3.2664494244735973, 2.1769635803931333 },
+                { 0.9891092274349095, 11.997033732095066, 5.905110170197932 },
+            }} },
+            { 5, {{
+                { 0.3661259230718182, 0.5974340482871242, 1.311546430378532 },
+                { 0.6020685613778642, 1.2444928175005379, 1.4065843208828397 },
+                { 0.8091048390628091, 2.592986272428862, 1.6755407461497038 },
+                { 0.935917223660293, 5.702370910949005, 2.4579414009244025 },
+                { 0.9930249108313819, 19.803331330272474, 6.859664115471019 },
+            }} },
+            { 6, {{
+                { 0.3127476985454144, 0.5942158615833204, 1.2730171597401543 },
+                { 0.5249151291289412, 1.1875114509419324, 1.3315105172581698 },
+                { 0.728023077724488, 2.2837755160567896, 1.4804653824033533 },
+                { 0.8711270936751877, 4.326878214762182, 1.8232266346431145 },
+                { 0.9563820201655724, 8.90563580723998, 2.7531925541189612 },
+                { 0.9952163653427338, 29.832536973525755, 7.821759050861936 },
+            }} },
+            { 7, {{
+                { 0.2729984712386349, 0.5921566592383986, 1.2468998191052223 },
+                { 0.464368976423424, 1.1520835972368004, 1.286318525959154 },
+                { 0.658280237217911, 2.1062800353358315, 1.380665624029088 },
+                { 0.8073498009348982, 3.690136957774086, 1.5732995059991977 },
+                { 0.9082816390959504, 6.552161477899466, 1.9840449143403682 },
+                { 0.9686600270119632, 12.888339252056275, 3.057015775957931 },
+                { 0.9965418215235601, 42.13687208145672, 8.789298841128629 },
+            }} },
+            { 8, {{
+                { 0.2422571317983436, 0.5907543625748235, 1.2280956326859307 },
+                { 0.4158990752876884, 1.1283732797307238, 1.256374076332878 },
+                { 0.5989134869004218, 1.9924745814761353, 1.3213916826387873 },
+                { 0.7483375114041083, 3.31889758921604, 1.4448491299554351 },
+                { 0.8579362192567015, 5.464743023389098, 1.6773250105703936 },
+                { 0.9318247870291406, 9.270787328881918, 2.153174566738712 },
+                { 0.9765097453229796, 17.657989244315285, 3.366464922461663 },
+                { 0.9973956163579054, 56.75087120141721, 9.760760388000687 },
+            }} },
+        }},
+    }};
+}
+
+const char* getCutTypeName(CutType type)
+{
+    switch (type)
+    {
+        case CutType_Butterworth:   return "Butterworth";
+        case CutType_LinkwitzRiley: return "Linkwitz-Riley";
+        case CutType_Bessel:        return "Bessel";
+        case CutType_ChebyshevI:    return "Chebyshev I";
+        case CutType_ChebyshevII:   return "Chebyshev II";
+        case CutType_Elliptic:      return "Elliptic";
+        case NumCutTypes:           break;
+    }
+
+    return "";
+}
+
+const CutPrototype& getCutPrototype(CutType type, int numSections)
+{
+    jassert(type != CutType_Butterworth && type < NumCutTypes);
+
+    const auto family = juce::jlimit(0, NumCutTypes - 2, int(type) - 1);
+    const auto index = juce::jlimit(0, CutPrototype::maxSections - 1, numSections - 1);
+    return prototypes[(size_t)family][(size_t)index];
+}
@@ -0,0 +1,100 @@
+/*
+  ==============================================================================
+
+    CutDesign.h
+    Low and high cut families designed from analog prototype tables.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include "ButterworthDesign.h"
+
+enum CutType
+{
+    CutType_Butterworth,
+    CutType_LinkwitzRiley,
+    CutType_Bessel,
+    CutType_ChebyshevI,
+    CutType_ChebyshevII,
+    CutType_Elliptic,
+    NumCutTypes
+};
+
+const char* getCutTypeName(CutType type);
+
+// one second order section of an analog low pass, unity gain at DC:
+// (s^2 / zeroFrequency^2 + 1) / (s^2 / frequency^2 + s / (q * frequency) + 1), no zeros when zeroFrequency is 0
+struct AnalogSection
+{
+    double frequency;
+    double q;
+    double zeroFrequency;
+};
+
+/**
+ a low pass of order numSections * 2, normalised so it is 3 dB down at 1 rad/s
+ (Linkwitz-Riley: 6 dB), sections in rising Q. every family has one section per
+ 12 dB/oct of slope, like the Butterworth, so a cut's section count only depends
+ on its slope.
+ */
+struct CutPrototype
+{
+    static constexpr int maxSections = ButterworthPrototype::maxSections;
+
+    int numSections = 0;
+    std::array<AnalogSection, maxSections> sections{};
+};
+
+// every type but the Butterworth, which designs from ButterworthPrototype instead
+const CutPrototype& getCutPrototype(CutType type, int numSections);
+
+/**
+ writes numSections normalised sections of a cut into sections, nothing allocates.
+ the Butterworth goes through designButterworthCut(), so it stays bit for bit what
+ FilterDesign would give. the other families are one bilinear transform per section,
+ prewarped to the cutoff and worked out in double whatever the sections' precision.
+ */
+template<typename Section>
+void designCut(Section* sections, int numSections, CutType type, bool highPass, decltype(Section::b0) frequency, double sampleRate)
+{
+    if (type == CutType_Butterworth)
+    {
+        designButterworthCut(sections, numSections, highPass, frequency, sampleRate);
+        return;
+    }
+
+    using FloatType = decltype(Section::b0);
+    const auto& prototype = getCutPrototype(type, numSections);
+
+    // the only thing that depends on the cutoff, s = (1 - z^-1) / (k (1 + z^-1))
+    const auto k = std::tan(juce::MathConstants<double>::pi * double(frequency) / sampleRate);
+    const auto kSquared = k * k;
+
+    // p2 s^2 + p1 s + p0, multiplied through by k^2 (1 + z^-1)^2
+    auto transform = [k, kSquared](double p2, double p1, double p0)
+        {
+            return std::array<double, 3>{ p2 + p1 * k + p0 * kSquared, 2.0 * (p0 * kSquared - p2), p2 - p1 * k + p0 * kSquared };
+        };
+
+    for (int i = 0; i < prototype.numSections; ++i)
+    {
+        const auto& analog = prototype.sections[(size_t)i];
+        const auto poleTerm = 1.0 / (analog.frequency * analog.frequency);
+        const auto dampingTerm = 1.0 / (analog.q * analog.frequency);
+        const auto zeroTerm = analog.zeroFrequency > 0 ? 1.0 / (analog.zeroFrequency * analog.zeroFrequency) : 0.0;
+
+        // the high pass is the low pass with s replaced by 1 / s
+        const auto numerator = highPass ? transform(1.0, 0.0, zeroTerm) : transform(zeroTerm, 0.0, 1.0);
+        const auto denominator = highPass ? transform(1.0, dampingTerm, poleTerm) : transform(poleTerm, dampingTerm, 1.0);
+        const auto a0Inv = 1.0 / denominator[0];
+
+        sections[i] = { FloatType(numerator[0] * a0Inv),
+                        FloatType(numerator[1] * a0Inv),
+                        FloatType(numerator[2] * a0Inv),
+                        FloatType(denominator[1] * a0Inv),
+                        FloatType(denominator[2] * a0Inv) };
+    }
+}
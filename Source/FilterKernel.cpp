@@ -0,0 +1,271 @@
+/*
+  ==============================================================================
+
+    FilterKernel.cpp
+    Plain-data biquad cascade the processor runs instead of two MonoChains.
+
+  ==============================================================================
+*/
+
+#include "FilterKernel.h"
+#include "PluginProcessor.h"
+#include <complex>
+
+namespace
+{
+    void setSection(KernelCoefficients& kernel, int section, const juce::dsp::IIR::Coefficients<float>& coefficients)
+    {
+        const auto* c = coefficients.coefficients.begin();
+        auto& s = kernel.sections[(size_t)section];
+
+        if (coefficients.coefficients.size() == 5)
+            s = { c[0], c[1], c[2], c[3], c[4] };
+        else
+            s = { c[0], c[1], 0.f, c[2], 0.f };  // first order
+
+        kernel.activeMask |= 1u << section;
+    }
+
+    // IIR::Coefficients::makePeakFilter's float arithmetic, without the allocation
+    BiquadCoefficients makePeakSection(double sampleRate, float frequency, float Q, float gainFactor)
+    {
+        const auto A = juce::jmax(0.f, std::sqrt(gainFactor));
+        const auto omega = (2 * juce::MathConstants<float>::pi * juce::jmax(frequency, 2.f)) / static_cast<float>(sampleRate);
+        const auto alpha = std::sin(omega) / (Q * 2);
+        const auto c2 = -2 * std::cos(omega);
+        const auto alphaTimesA = alpha * A;
+        const auto alphaOverA = alpha / A;
+        const auto a0Inv = 1.f / (1 + alphaOverA);
+
+        return { (1 + alphaTimesA) * a0Inv, c2 * a0Inv, (1 - alphaTimesA) * a0Inv, c2 * a0Inv, (1 - alphaOverA) * a0Inv };
+    }
+
+    // |x0 + x1 e^-jw + x2 e^-2jw|^2 = p[0] + p[1] cos(w) + p[2] cos(w)^2
+    std::array<double, 3> getSquaredMagnitudePolynomial(double x0, double x1, double x2)
+    {
+        return { x0 * x0 + x1 * x1 + x2 * x2 - 2.0 * x0 * x2, 2.0 * x1 * (x0 + x2), 4.0 * x0 * x2 };
+    }
+
+    double evaluate(const std::array<double, 3>& p, double c)
+    {
+        return p[0] + c * (p[1] + c * p[2]);
+    }
+
+    void markTransparentSections(KernelCoefficients& kernel)
+    {
+        kernel.transparentMask = 0;
+
+        for (int section = 0; section < KernelCoefficients::maxSections; ++section)
+            if (kernel.isActive(section) && isTransparent(kernel.sections[(size_t)section]))
+                kernel.transparentMask |= 1u << section;
+    }
+}
+
+bool isTransparent(const BiquadCoefficients& section, double toleranceDB)
+{
+    // |H - 1|^2 = |B - A|^2 / |A|^2 is a ratio of two quadratics in c = cos(w), so its maximum
+    // over every frequency is at c = +-1 or where the derivative's numerator, itself only a
+    // quadratic, has a root. that's exact, narrow resonances and the phase included
+    const auto n = getSquaredMagnitudePolynomial(double(section.b0) - 1.0, double(section.b1) - double(section.a1),
+                                                 double(section.b2) - double(section.a2));
+    const auto m = getSquaredMagnitudePolynomial(1.0, double(section.a1), double(section.a2));
+
+    std::array<double, 4> candidates{ -1.0, 1.0, 0.0, 0.0 };
+    int numCandidates = 2;
+
+    const auto qa = n[2] * m[1] - n[1] * m[2];
+    const auto qb = 2.0 * (n[2] * m[0] - n[0] * m[2]);
+    const auto qc = n[1] * m[0] - n[0] * m[1];
+
+    if (qa != 0.0)
+    {
+        const auto discriminant = qb * qb - 4.0 * qa * qc;
+        if (discriminant >= 0.0)
+        {
+            candidates[(size_t)numCandidates++] = (-qb + std::sqrt(discriminant)) / (2.0 * qa);
+            candidates[(size_t)numCandidates++] = (-qb - std::sqrt(discriminant)) / (2.0 * qa);
+        }
+    }
+    else if (qb != 0.0)
+    {
+        candidates[(size_t)numCandidates++] = -qc / qb;
+    }
+
+    // |A|^2 only reaches 0 with a pole on the unit circle
+    if (m[2] > 0.0 && std::abs(m[1]) < 2.0 * m[2] && evaluate(m, -m[1] / (2.0 * m[2])) <= 0.0)
+        return false;
+
+    const auto tolerance = 1.0 - juce::Decibels::decibelsToGain(-toleranceDB);
+    for (int i = 0; i < numCandidates; ++i)
+    {
+        const auto c = candidates[(size_t)i];
+        if (c < -1.0 || c > 1.0)
+            continue;
+
+        const auto denominator = evaluate(m, c);
+        if (denominator <= 0.0 || evaluate(n, c) > tolerance * tolerance * denominator)
+            return false;
+    }
+
+    return true;
+}
+
+void makeKernelCoefficients(KernelCoefficients& kernel, const ChainCoefficients& chainCoefficients)
+{
+    const auto& settings = chainCoefficients.settings;
+
+    // sections switched off keep their old coefficients, like a bypassed filter.
+    // a disabled band leaves all of its sections off, so process() never visits them
+    kernel.activeMask = 0;
+
+    if (settings.lowCutEnabled)
+        for (int i = 0; i <= settings.lowCutSlope; ++i)
+            setSection(kernel, i, *chainCoefficients.lowCut[i]);
+
+    if (settings.peakEnabled)
+        setSection(kernel, KernelCoefficients::peakSection, *chainCoefficients.peak);
+
+    if (settings.highCutEnabled)
+        for (int i = 0; i <= settings.highCutSlope; ++i)
+            setSection(kernel, KernelCoefficients::peakSection + 1 + i, *chainCoefficients.highCut[i]);
+
+    markTransparentSections(kernel);
+}
+
+void designKernelCoefficients(KernelCoefficients& kernel, const ChainSettings& settings, double sampleRate)
+{
+    kernel.activeMask = 0;
+
+    if (settings.lowCutEnabled)
+    {
+        const auto numLowCutSections = settings.lowCutSlope + 1;
+        designCut(kernel.sections.data(), numLowCutSections, settings.lowCutType, true, settings.lowCutFreq, sampleRate);
+        kernel.activeMask |= (1u << numLowCutSections) - 1;
+    }
+
+    if (settings.peakEnabled)
+    {
+        kernel.sections[KernelCoefficients::peakSection] = makePeakSection(sampleRate, settings.peakFreq, settings.peakQ,
+                                                                           juce::Decibels::decibelsToGain(settings.peakGainDB));
+        kernel.activeMask |= 1u << KernelCoefficients::peakSection;
+    }
+
+    if (settings.highCutEnabled)
+    {
+        const auto numHighCutSections = settings.highCutSlope + 1;
+        designCut(kernel.sections.data() + KernelCoefficients::peakSection + 1, numHighCutSections, settings.highCutType, false,
+                  settings.highCutFreq, sampleRate);
+        kernel.activeMask |= ((1u << numHighCutSections) - 1) << (KernelCoefficients::peakSection + 1);
+    }
+
+    markTransparentSections(kernel);
+}
+
+double getPinkNoisePowerGain(const KernelCoefficients& kernel, double sampleRate)
+{
+    constexpr int numPoints = 64;
+    const auto maxFrequency = juce::jmin(20000.0, sampleRate * 0.5 * 0.99);
+
+    double sum = 0;
+    for (int i = 0; i < numPoints; ++i)
+    {
+        const auto frequency = juce::mapToLog10(double(i) / double(numPoints - 1), 20.0, maxFrequency);
+        const auto z1 = std::polar(1.0, -juce::MathConstants<double>::twoPi * frequency / sampleRate);
+        const auto z2 = z1 * z1;
+
+        std::complex<double> response(1.0);
+        for (int section = 0; section < KernelCoefficients::maxSections; ++section)
+        {
+            if (!kernel.isActive(section))
+                continue;
+
+            const auto& c = kernel.sections[(size_t)section];
+            response *= (double(c.b0) + double(c.b1) * z1 + double(c.b2) * z2) / (1.0 + double(c.a1) * z1 + double(c.a2) * z2);
+        }
+
+        sum += std::norm(response);
+    }
+
+    return juce::jmax(1.0e-6, sum / double(numPoints));
+}
+
+size_t FilterKernel::getRequiredBytes(int numChannels)
+{
+    return DSPArena::getAlignedSize(sizeof(KernelCoefficients))
+         + DSPArena::getAlignedSize(sizeof(ChannelState) * (size_t)numChannels);
+}
+
+void FilterKernel::prepare(DSPArena& arena, int newNumChannels)
+{
+    numChannels = newNumChannels;
+    coefficients = arena.allocate<KernelCoefficients>();
+    states = arena.allocate<ChannelState>((size_t)numChannels);
+}
+
+void FilterKernel::setCoefficients(const ChainCoefficients& chainCoefficients)
+{
+    if (coefficients != nullptr)
+        makeKernelCoefficients(*coefficients, chainCoefficients);
+}
+
+void FilterKernel::setCoefficients(const KernelCoefficients& newCoefficients)
+{
+    if (coefficients != nullptr)
+        *coefficients = newCoefficients;
+}
+
+void FilterKernel::reset()
+{
+    for (int ch = 0; ch < numChannels; ++ch)
+        states[ch] = {};
+}
+
+void FilterKernel::resetSections(juce::uint32 sectionMask)
+{
+    for (int ch = 0; ch < numChannels; ++ch)
+        for (int section = 0; section < KernelCoefficients::maxSections; ++section)
+            if ((sectionMask >> section) & 1)
+                states[ch].sections[(size_t)section] = {};
+}
+
+void FilterKernel::copyFrom(const FilterKernel& other)
+{
+    if (coefficients == nullptr || other.coefficients == nullptr)
+        return;
+
+    jassert(numChannels == other.numChannels);
+    *coefficients = *other.coefficients;
+    std::copy(other.states, other.states + juce::jmin(numChannels, other.numChannels), states);
+}
+
+void FilterKernel::process(float* samples, int numSamples, int channel)
+{
+    if (coefficients == nullptr || !juce::isPositiveAndBelow(channel, numChannels))
+        return;
+
+    auto& channelState = states[channel];
+
+    // section by section over the whole block, transposed direct form II, as juce::dsp::IIR::Filter does
+    for (int section = 0; section < KernelCoefficients::maxSections; ++section)
+    {
+        if (!coefficients->isProcessed(section))
+            continue;
+
+        const auto c = coefficients->sections[(size_t)section];
+        auto s1 = channelState.sections[(size_t)section].s1;
+        auto s2 = channelState.sections[(size_t)section].s2;
+
+        for (int i = 0; i < numSamples; ++i)
+        {
+            const auto input = samples[i];
+            const auto output = c.b0 * input + s1;
+            s1 = c.b1 * input - c.a1 * output + s2;
+            s2 = c.b2 * input - c.a2 * output;
+            samples[i] = output;
+        }
+
+        juce::dsp::util::snapToZero(s1);
+        juce::dsp::util::snapToZero(s2);
+        channelState.sections[(size_t)section] = { s1, s2 };
+    }
+}
@@ -0,0 +1,106 @@
+/*
+  ==============================================================================
+
+    FilterKernel.h
+    Plain-data biquad cascade the processor runs instead of two MonoChains.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include "DSPArena.h"
+#include "CutDesign.h"
+
+struct ChainCoefficients;
+struct ChainSettings;
+
+struct BiquadCoefficients
+{
+    // a0 normalised to 1, same layout as juce::dsp::IIR::Coefficients
+    float b0 = 1, b1 = 0, b2 = 0, a1 = 0, a2 = 0;
+};
+
+struct BiquadState
+{
+    float s1 = 0, s2 = 0;
+};
+
+/**
+ the sections of a MonoChain in its own order: eight low cut, the peak, eight high cut.
+ inactive sections keep their state like a bypassed filter in the chain does, so the
+ kernel's output is sample for sample what MonoChain would produce.
+ active sections that are flat within transparentToleranceDB at every frequency, a
+ peak at 0 dB for instance, are marked transparent when they're designed and skipped.
+ */
+struct KernelCoefficients
+{
+    static constexpr int maxSections = 2 * CutPrototype::maxSections + 1;
+    static constexpr int peakSection = CutPrototype::maxSections;
+    static constexpr juce::uint32 lowCutMask = (1u << peakSection) - 1;
+    static constexpr juce::uint32 highCutMask = lowCutMask << (peakSection + 1);
+    static constexpr double transparentToleranceDB = 0.01;
+
+    std::array<BiquadCoefficients, maxSections> sections;
+    juce::uint32 activeMask = 0;
+    juce::uint32 transparentMask = 0;
+
+    bool isActive(int section) const { return (activeMask >> section) & 1; }
+
+    // the sections process() actually runs
+    juce::uint32 getProcessedMask() const { return activeMask & ~transparentMask; }
+    bool isProcessed(int section) const { return (getProcessedMask() >> section) & 1; }
+};
+
+// true if |H - 1| stays within toleranceDB's gain error from DC to nyquist, so the section
+// can be replaced by a wire: |H| is within toleranceDB of unity and the phase barely moves
+bool isTransparent(const BiquadCoefficients& section, double toleranceDB = KernelCoefficients::transparentToleranceDB);
+
+// copies the designed coefficients into plain data and marks the transparent sections, no allocation
+void makeKernelCoefficients(KernelCoefficients& kernel, const ChainCoefficients& chainCoefficients);
+
+// designs straight into the sections, the same coefficients makeChainCoefficients would allocate
+void designKernelCoefficients(KernelCoefficients& kernel, const ChainSettings& chainSettings, double sampleRate);
+
+// broadband power gain for pink noise, as getPinkNoisePowerGain() computes it for ChainCoefficients
+double getPinkNoisePowerGain(const KernelCoefficients& kernel, double sampleRate);
+
+class FilterKernel
+{
+public:
+    static size_t getRequiredBytes(int numChannels);
+
+    // carves the coefficients and every channel's state out of the arena
+    void prepare(DSPArena& arena, int numChannels);
+
+    void setCoefficients(const ChainCoefficients& chainCoefficients);
+    void setCoefficients(const KernelCoefficients& newCoefficients);
+    void reset();
+
+    // clears the state of the sections in the mask, e.g. ones that were just switched in
+    void resetSections(juce::uint32 sectionMask);
+
+    // takes over another kernel's coefficients and state, both prepared with the same channels
+    void copyFrom(const FilterKernel& other);
+
+    void process(float* samples, int numSamples, int channel);
+
+    int getNumChannels() const { return numChannels; }
+    const KernelCoefficients* getCoefficients() const { return coefficients; }
+
+    // one section's state, for handing a running filter over to another kernel
+    BiquadState& getState(int channel, int section) { return states[channel].sections[(size_t)section]; }
+    const BiquadState& getState(int channel, int section) const { return states[channel].sections[(size_t)section]; }
+
+private:
+    // whole cache lines per channel, so the two channels never share one
+    struct alignas(DSPArena::alignment) ChannelState
+    {
+        std::array<BiquadState, KernelCoefficients::maxSections> sections;
+    };
+
+    KernelCoefficients* coefficients = nullptr;
+    ChannelState* states = nullptr;
+    int numChannels = 0;
+};
@@ -0,0 +1,282 @@
+/*
+  ==============================================================================
+
+    LoudnessMeter.cpp
+    BS.1770 loudness and true-peak metering, computed off the audio thread.
+
+  ==============================================================================
+*/
+
+#include "LoudnessMeter.h"
+#include "Trace.h"
+
+namespace
+{
+    constexpr float silence = -std::numeric_limits<float>::infinity();
+
+    float powerToLoudness(double power)
+    {
+        return power > 0 ? float(-0.691 + 10.0 * std::log10(power)) : silence;
+    }
+}
+
+LoudnessMeter::LoudnessMeter() :
+    momentary(silence),
+    shortTerm(silence),
+    integrated(silence),
+    truePeak(silence)
+{
+}
+
+LoudnessMeter::~LoudnessMeter()
+{
+    release();
+}
+
+void LoudnessMeter::prepare(double newSampleRate, int newNumChannels)
+{
+    release();
+
+    sampleRate = newSampleRate;
+    numChannels = juce::jlimit(1, maxChannels, newNumChannels);
+
+    // one second of headroom for the worker
+    const auto capacity = juce::jmax(chunkSize * 4, int(sampleRate));
+    tapBuffer.setSize(numChannels, capacity);
+    tapFifo.setTotalSize(capacity);
+    tapFifo.reset();
+
+    chunk.setSize(numChannels, chunkSize);
+
+    oversampling = std::make_unique<juce::dsp::Oversampling<float>>(
+        (size_t)numChannels, 2, juce::dsp::Oversampling<float>::filterHalfBandFIREquiripple, true);
+    oversampling->initProcessing((size_t)chunkSize);
+
+    // BS.1770-4 pre-filter (high shelf) and RLB high-pass, re-derived for the sample rate
+    {
+        const auto K = std::tan(juce::MathConstants<double>::pi * 1681.974450955533 / sampleRate);
+        const auto Q = 0.7071752369554196;
+        const auto Vh = std::pow(10.0, 3.999843853973347 / 20.0);
+        const auto Vb = std::pow(Vh, 0.4996667741545416);
+        const auto a0 = 1.0 + K / Q + K * K;
+
+        Biquad shelf;
+        shelf.b0 = (Vh + Vb * K / Q + K * K) / a0;
+        shelf.b1 = 2.0 * (K * K - Vh) / a0;
+        shelf.b2 = (Vh - Vb * K / Q + K * K) / a0;
+        shelf.a1 = 2.0 * (K * K - 1.0) / a0;
+        shelf.a2 = (1.0 - K / Q + K * K) / a0;
+
+        const auto Kh = std::tan(juce::MathConstants<double>::pi * 38.13547087602444 / sampleRate);
+        const auto Qh = 0.5003270373238773;
+        const auto a0h = 1.0 + Kh / Qh + Kh * Kh;
+
+        Biquad highPass;
+        highPass.b0 = 1.0;
+        highPass.b1 = -2.0;
+        highPass.b2 = 1.0;
+        highPass.a1 = 2.0 * (Kh * Kh - 1.0) / a0h;
+        highPass.a2 = (1.0 - Kh / Qh + Kh * Kh) / a0h;
+
+        for (auto& channel : kWeighting)
+            channel = { shelf, highPass };
+    }
+
+    samplesPerBlock = juce::roundToInt(sampleRate * 0.1);
+    resetMeasurement();
+
+    sharedThread->addTimeSliceClient(this);
+    registered = true;
+}
+
+void LoudnessMeter::release()
+{
+    // blocks until the worker is out of useTimeSlice()
+    if (registered)
+        sharedThread->removeTimeSliceClient(this);
+
+    registered = false;
+}
+
+void LoudnessMeter::push(const juce::AudioBuffer<float>& buffer)
+{
+    if (!registered)
+        return;
+
+    const auto numSamples = buffer.getNumSamples();
+    if (tapFifo.getFreeSpace() < numSamples)
+    {
+        droppedSamples.fetch_add(numSamples);
+        return;
+    }
+
+    const auto scope = tapFifo.write(numSamples);
+    for (int ch = 0; ch < numChannels; ++ch)
+    {
+        const auto source = juce::jmin(ch, buffer.getNumChannels() - 1);
+        if (scope.blockSize1 > 0)
+            tapBuffer.copyFrom(ch, scope.startIndex1, buffer, source, 0, scope.blockSize1);
+        if (scope.blockSize2 > 0)
+            tapBuffer.copyFrom(ch, scope.startIndex2, buffer, source, scope.blockSize1, scope.blockSize2);
+    }
+}
+
+LoudnessMeter::Readings LoudnessMeter::getReadings() const
+{
+    return { momentary.load(), shortTerm.load(), integrated.load(), truePeak.load() };
+}
+
+size_t LoudnessMeter::getMemoryUsage() const
+{
+    auto bytes = sizeof(*this)
+        + (size_t)tapBuffer.getNumChannels() * (size_t)tapBuffer.getNumSamples() * sizeof(float)
+        + (size_t)chunk.getNumChannels() * (size_t)chunk.getNumSamples() * sizeof(float);
+
+    // the oversampler keeps a 4x copy of a chunk, its FIR states are small next to that
+    if (oversampling != nullptr)
+        bytes += (size_t)numChannels * chunkSize * 4 * sizeof(float);
+
+    return bytes;
+}
+
+int LoudnessMeter::useTimeSlice()
+{
+    EQTUT_TRACE_SCOPE("loudness worker");
+
+    if (resetRequested.exchange(false))
+        resetMeasurement();
+
+    while (tapFifo.getNumReady() > 0)
+    {
+        const auto numSamples = juce::jmin(chunkSize, tapFifo.getNumReady());
+        {
+            const auto scope = tapFifo.read(numSamples);
+            for (int ch = 0; ch < numChannels; ++ch)
+            {
+                if (scope.blockSize1 > 0)
+                    chunk.copyFrom(ch, 0, tapBuffer, ch, scope.startIndex1, scope.blockSize1);
+                if (scope.blockSize2 > 0)
+                    chunk.copyFrom(ch, scope.blockSize1, tapBuffer, ch, scope.startIndex2, scope.blockSize2);
+            }
+        }
+
+        processChunk(numSamples);
+    }
+
+    // 100 ms is the meter's resolution, there is no point waking up more often
+    return 50;
+}
+
+void LoudnessMeter::processChunk(int numSamples)
+{
+    // true peak: 4x oversampled absolute maximum
+    juce::dsp::AudioBlock<float> block(chunk);
+    auto upsampled = oversampling->processSamplesUp(block.getSubBlock(0, (size_t)numSamples));
+    for (size_t ch = 0; ch < upsampled.getNumChannels(); ++ch)
+    {
+        auto range = juce::FloatVectorOperations::findMinAndMax(upsampled.getChannelPointer(ch), (int)upsampled.getNumSamples());
+        truePeakGain = juce::jmax(truePeakGain, -range.getStart(), range.getEnd());
+    }
+    truePeak.store(juce::Decibels::gainToDecibels(truePeakGain, silence));
+
+    // loudness: K-weighted energy summed over channels in 100 ms blocks
+    for (int i = 0; i < numSamples; ++i)
+    {
+        for (int ch = 0; ch < numChannels; ++ch)
+        {
+            auto& filters = kWeighting[(size_t)ch];
+            auto y = filters[1].process(filters[0].process(chunk.getSample(ch, i)));
+            blockEnergy += y * y;
+        }
+
+        if (++blockSampleCount == samplesPerBlock)
+            finishBlock();
+    }
+}
+
+void LoudnessMeter::finishBlock()
+{
+    blockPowers[(size_t)blockWriteIndex] = blockEnergy / double(samplesPerBlock);
+    blockWriteIndex = (blockWriteIndex + 1) % numShortTermBlocks;
+    blockEnergy = 0;
+    blockSampleCount = 0;
+
+    double momentaryPower = 0, shortTermPower = 0;
+    for (int i = 0; i < numShortTermBlocks; ++i)
+    {
+        // i == 0 is the newest block
+        auto power = blockPowers[(size_t)((blockWriteIndex - 1 - i + numShortTermBlocks) % numShortTermBlocks)];
+        shortTermPower += power;
+        if (i < numMomentaryBlocks)
+            momentaryPower += power;
+    }
+    momentaryPower /= numMomentaryBlocks;
+    shortTermPower /= numShortTermBlocks;
+
+    momentary.store(powerToLoudness(momentaryPower));
+    shortTerm.store(powerToLoudness(shortTermPower));
+
+    // gating blocks are the 400 ms windows with 75% overlap, i.e. one per 100 ms step
+    auto loudness = powerToLoudness(momentaryPower);
+    if (loudness >= histogramMinimum)
+    {
+        auto bin = juce::jlimit(0, numHistogramBins - 1, int((loudness - histogramMinimum) * histogramBinsPerLU));
+        ++histogramCounts[(size_t)bin];
+        histogramPowers[(size_t)bin] += momentaryPower;
+    }
+
+    integrated.store(computeIntegrated());
+}
+
+float LoudnessMeter::computeIntegrated() const
+{
+    // absolute gate (-70 LUFS) is applied when blocks enter the histogram
+    juce::int64 count = 0;
+    double power = 0;
+    for (int i = 0; i < numHistogramBins; ++i)
+    {
+        count += histogramCounts[(size_t)i];
+        power += histogramPowers[(size_t)i];
+    }
+
+    if (count == 0)
+        return silence;
+
+    // relative gate: 10 LU below the absolute-gated loudness
+    const auto relativeGate = powerToLoudness(power / double(count)) - 10.f;
+    const auto firstBin = juce::jlimit(0, numHistogramBins, int(std::ceil((relativeGate - histogramMinimum) * histogramBinsPerLU)));
+
+    count = 0;
+    power = 0;
+    for (int i = firstBin; i < numHistogramBins; ++i)
+    {
+        count += histogramCounts[(size_t)i];
+        power += histogramPowers[(size_t)i];
+    }
+
+    return count > 0 ? powerToLoudness(power / double(count)) : silence;
+}
+
+void LoudnessMeter::resetMeasurement()
+{
+    for (auto& channel : kWeighting)
+        for (auto& filter : channel)
+            filter.z1 = filter.z2 = 0;
+
+    if (oversampling != nullptr)
+        oversampling->reset();
+
+    blockSampleCount = 0;
+    blockEnergy = 0;
+    blockPowers.fill(0);
+    blockWriteIndex = 0;
+
+    histogramCounts.fill(0);
+    histogramPowers.fill(0);
+    truePeakGain = 0;
+
+    momentary.store(silence);
+    shortTerm.store(silence);
+    integrated.store(silence);
+    truePeak.store(silence);
+}
@@ -0,0 +1,121 @@
+/*
+  ==============================================================================
+
+    LoudnessMeter.h
+    BS.1770 loudness and true-peak metering, computed off the audio thread.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+
+/**
+ the audio thread only copies the output into a lock-free sample ring. a worker shared
+ by every instance in the process K-weights it, gates it and oversamples it 4x for the
+ true peak, then publishes the readings through atomics.
+ */
+class LoudnessMeter : private juce::TimeSliceClient
+{
+public:
+    struct Readings
+    {
+        float momentary;    // LUFS, 400 ms window
+        float shortTerm;    // LUFS, 3 s window
+        float integrated;   // LUFS, gated, since the last reset
+        float truePeak;     // dBTP, maximum since the last reset
+    };
+
+    LoudnessMeter();
+    ~LoudnessMeter() override;
+
+    // call from prepareToPlay, never while processBlock can run
+    void prepare(double sampleRate, int numChannels);
+    void release();
+
+    // audio thread: copies the block into the ring, drops it if the worker has fallen behind
+    void push(const juce::AudioBuffer<float>& buffer);
+
+    Readings getReadings() const;
+
+    // clears integrated loudness and true peak, takes effect on the worker's next pass
+    void reset() { resetRequested.store(true); }
+
+    int getNumDroppedSamples() const { return droppedSamples.load(); }
+
+    // the meter and the buffers it allocated in prepare(), approximately
+    size_t getMemoryUsage() const;
+
+private:
+    struct Biquad
+    {
+        double b0 = 1, b1 = 0, b2 = 0, a1 = 0, a2 = 0;
+        double z1 = 0, z2 = 0;
+
+        double process(double x)
+        {
+            auto y = b0 * x + z1;
+            z1 = b1 * x - a1 * y + z2;
+            z2 = b2 * x - a2 * y;
+            return y;
+        }
+    };
+
+    static constexpr int maxChannels = 2;
+    static constexpr int chunkSize = 512;
+    static constexpr int numShortTermBlocks = 30;  // 100 ms blocks in 3 s
+    static constexpr int numMomentaryBlocks = 4;   // 100 ms blocks in 400 ms
+
+    // integrated loudness gating histogram, 0.1 LU bins from -70 to +10 LUFS
+    static constexpr float histogramMinimum = -70.f;
+    static constexpr int histogramBinsPerLU = 10;
+    static constexpr int numHistogramBins = 80 * histogramBinsPerLU;
+
+    // one worker for every meter in the process, alive while any meter exists
+    struct MeterThread : juce::TimeSliceThread
+    {
+        MeterThread() : juce::TimeSliceThread("Loudness Meter") { startThread(); }
+        ~MeterThread() override { stopThread(1000); }
+    };
+
+    juce::SharedResourcePointer<MeterThread> sharedThread;
+    bool registered = false;
+
+    // audio -> worker ring
+    juce::AbstractFifo tapFifo{ 1 };
+    juce::AudioBuffer<float> tapBuffer;
+    std::atomic<int> droppedSamples{ 0 };
+
+    // worker state
+    int numChannels = 0;
+    double sampleRate = 0;
+    juce::AudioBuffer<float> chunk;
+    std::unique_ptr<juce::dsp::Oversampling<float>> oversampling;
+
+    std::array<std::array<Biquad, 2>, maxChannels> kWeighting;
+
+    int samplesPerBlock = 0;
+    int blockSampleCount = 0;
+    double blockEnergy = 0;
+
+    std::array<double, numShortTermBlocks> blockPowers{};
+    int blockWriteIndex = 0;
+
+    std::array<juce::int64, numHistogramBins> histogramCounts{};
+    std::array<double, numHistogramBins> histogramPowers{};
+
+    float truePeakGain = 0;
+
+    std::atomic<bool> resetRequested{ false };
+    std::atomic<float> momentary, shortTerm, integrated, truePeak;
+
+    int useTimeSlice() override;
+
+    void processChunk(int numSamples);
+    void finishBlock();
+    void resetMeasurement();
+    float computeIntegrated() const;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(LoudnessMeter)
+};
@@ -0,0 +1,459 @@
+/*
+  ==============================================================================
+
+    MatchEQ.cpp
+    Fits the EQ's ChainSettings so a source spectrum matches a reference.
+
+  ==============================================================================
+*/
+
+#include "MatchEQ.h"
+
+//==============================================================================
+void SpectrumAverage::addFrame(const float* decibels, int numBins, double binWidth)
+{
+    for (int i = 0; i < MatchGrid::numPoints; ++i)
+    {
+        const auto position = MatchGrid::getFrequency(i) / binWidth;
+        const auto bin = int(position);
+        if (bin + 1 >= numBins)
+            break;
+
+        // interpolate in power between the neighbouring bins
+        const auto frac = position - double(bin);
+        const auto p0 = std::pow(10.0, decibels[bin] / 10.0);
+        const auto p1 = std::pow(10.0, decibels[bin + 1] / 10.0);
+        powerSum[(size_t)i] += p0 + (p1 - p0) * frac;
+    }
+
+    ++numFrames;
+}
+
+void SpectrumAverage::clear()
+{
+    powerSum.fill(0);
+    numFrames = 0;
+}
+
+MatchSpectrum SpectrumAverage::getDecibels() const
+{
+    MatchSpectrum decibels;
+    for (size_t i = 0; i < decibels.size(); ++i)
+        decibels[i] = 10.0 * std::log10(juce::jmax(1.0e-12, powerSum[i] / juce::jmax(1, numFrames)));
+
+    return decibels;
+}
+
+bool analyseReferenceFile(const juce::File& file, SpectrumAverage& average, const std::function<bool()>& shouldExit)
+{
+    juce::AudioFormatManager formats;
+    formats.registerBasicFormats();
+
+    std::unique_ptr<juce::AudioFormatReader> reader(formats.createReaderFor(file));
+    if (reader == nullptr)
+        return false;
+
+    constexpr int order = 12;
+    constexpr int fftSize = 1 << order;
+    constexpr int numBins = fftSize / 2;
+
+    juce::dsp::FFT fft(order);
+    juce::dsp::WindowingFunction<float> window((size_t)fftSize, juce::dsp::WindowingFunction<float>::hann);
+
+    const auto numChannels = (int)juce::jmin(2u, reader->numChannels);
+    juce::AudioBuffer<float> block(numChannels, fftSize);
+    std::vector<float> fftData(fftSize * 2, 0);
+
+    const auto binWidth = reader->sampleRate / double(fftSize);
+
+    // ten minutes is plenty for a long-term average
+    const auto length = juce::jmin(reader->lengthInSamples, juce::int64(reader->sampleRate * 600.0));
+
+    for (juce::int64 start = 0; start + fftSize <= length; start += fftSize / 2)
+    {
+        if (shouldExit())
+            return false;
+
+        reader->read(&block, 0, fftSize, start, true, true);
+
+        // mono sum, windowed, with the same normalisation the analyzer uses
+        std::fill(fftData.begin(), fftData.end(), 0.f);
+        for (int ch = 0; ch < numChannels; ++ch)
+            juce::FloatVectorOperations::addWithMultiply(fftData.data(), block.getReadPointer(ch), 1.f / float(numChannels), fftSize);
+
+        window.multiplyWithWindowingTable(fftData.data(), (size_t)fftSize);
+        fft.performFrequencyOnlyForwardTransform(fftData.data());
+
+        for (int i = 0; i < numBins; ++i)
+            fftData[(size_t)i] = juce::Decibels::gainToDecibels(fftData[(size_t)i] / float(numBins), -120.f);
+
+        average.addFrame(fftData.data(), numBins, binWidth);
+    }
+
+    return !average.isEmpty();
+}
+
+//==============================================================================
+namespace
+{
+    // normalised biquad, a0 == 1
+    struct Section
+    {
+        double b0, b1, b2, a1, a2;
+    };
+
+    constexpr int maxSections = KernelCoefficients::maxSections;
+
+    // same formula as juce::dsp::IIR::Coefficients::makePeakFilter
+    Section makePeakSection(double sampleRate, double frequency, double Q, double gainDB)
+    {
+        const auto A = std::pow(10.0, gainDB / 40.0);
+        const auto omega = juce::MathConstants<double>::twoPi * frequency / sampleRate;
+        const auto alpha = std::sin(omega) / (2.0 * Q);
+        const auto c2 = -2.0 * std::cos(omega);
+        const auto a0 = 1.0 + alpha / A;
+
+        return { (1.0 + alpha * A) / a0, c2 / a0, (1.0 - alpha * A) / a0, c2 / a0, (1.0 - alpha / A) / a0 };
+    }
+
+    int addCutSections(bool highPass, double sampleRate, double frequency, Slope slope, CutType type, Section* sections)
+    {
+        // sections from the compile-time prototypes, order (slope + 1) * 2
+        designCut(sections, slope + 1, type, highPass, frequency, sampleRate);
+        return slope + 1;
+    }
+
+    int makeSections(const ChainSettings& settings, double sampleRate, Section* sections)
+    {
+        const auto nyquistLimit = sampleRate * 0.499;
+        int numSections = 0;
+
+        // disabled bands don't run in the chain, so they don't shape the fit either
+        if (settings.lowCutEnabled)
+            numSections += addCutSections(true, sampleRate, juce::jmin<double>(settings.lowCutFreq, nyquistLimit), settings.lowCutSlope, settings.lowCutType, sections + numSections);
+        if (settings.peakEnabled)
+            sections[numSections++] = makePeakSection(sampleRate, juce::jmin<double>(settings.peakFreq, nyquistLimit), settings.peakQ, settings.peakGainDB);
+        if (settings.highCutEnabled)
+            numSections += addCutSections(false, sampleRate, juce::jmin<double>(settings.highCutFreq, nyquistLimit), settings.highCutSlope, settings.highCutType, sections + numSections);
+
+        return numSections;
+    }
+
+    // evaluates the rms dB error of many candidates against one target
+    struct BatchEvaluator
+    {
+        static constexpr int N = MatchGrid::numPoints;
+        static constexpr double floorDB = -60.0;
+
+        BatchEvaluator(double rate, const MatchSpectrum& targetDecibels) :
+            sampleRate(rate)
+        {
+            for (int i = 0; i < N; ++i)
+            {
+                const auto frequency = MatchGrid::getFrequency(i);
+                const auto w = juce::MathConstants<double>::twoPi * frequency / sampleRate;
+
+                cosW[(size_t)i] = std::cos(w);
+                cos2W[(size_t)i] = std::cos(2.0 * w);
+                target[(size_t)i] = juce::jmax(floorDB, targetDecibels[(size_t)i]);
+
+                // points at or above nyquist say nothing about the filters
+                weight[(size_t)i] = frequency < sampleRate * 0.49 ? 1.0 : 0.0;
+            }
+        }
+
+        void evaluate(const std::vector<ChainSettings>& candidates, std::vector<double>& errors)
+        {
+            const auto numCandidates = candidates.size();
+            power.assign(numCandidates * N, 1.0);
+            errors.resize(numCandidates);
+
+            for (size_t c = 0; c < numCandidates; ++c)
+            {
+                std::array<Section, maxSections> sections;
+                const auto numSections = makeSections(candidates[c], sampleRate, sections.data());
+
+                auto* p = power.data() + c * N;
+                for (int s = 0; s < numSections; ++s)
+                    accumulateSectionPower(sections[(size_t)s], p);
+
+                errors[c] = getError(p);
+            }
+        }
+
+    private:
+        double sampleRate;
+        std::array<double, N> cosW, cos2W, target, weight;
+        std::vector<double> power;
+
+        // |B|^2 and |A|^2 expand to constants plus cos(w) and cos(2w) terms
+        void accumulateSectionPower(const Section& s, double* p) const
+        {
+            const auto n0 = s.b0 * s.b0 + s.b1 * s.b1 + s.b2 * s.b2;
+            const auto n1 = 2.0 * (s.b0 * s.b1 + s.b1 * s.b2);
+            const auto n2 = 2.0 * s.b0 * s.b2;
+            const auto d0 = 1.0 + s.a1 * s.a1 + s.a2 * s.a2;
+            const auto d1 = 2.0 * (s.a1 + s.a1 * s.a2);
+            const auto d2 = 2.0 * s.a2;
+
+            for (int i = 0; i < N; ++i)
+                p[i] *= (n0 + n1 * cosW[(size_t)i] + n2 * cos2W[(size_t)i]) / (d0 + d1 * cosW[(size_t)i] + d2 * cos2W[(size_t)i]);
+        }
+
+        // rms deviation once the best level offset has been removed, the EQ has no output gain
+        double getError(const double* p) const
+        {
+            std::array<double, N> diff;
+            double sum = 0, totalWeight = 0;
+            for (int i = 0; i < N; ++i)
+            {
+                diff[(size_t)i] = target[(size_t)i] - juce::jmax(floorDB, 10.0 * std::log10(juce::jmax(1.0e-30, p[i])));
+                sum += weight[(size_t)i] * diff[(size_t)i];
+                totalWeight += weight[(size_t)i];
+            }
+
+            const auto offset = sum / totalWeight;
+            double squares = 0;
+            for (int i = 0; i < N; ++i)
+                squares += weight[(size_t)i] * juce::square(diff[(size_t)i] - offset);
+
+            return std::sqrt(squares / totalWeight);
+        }
+    };
+
+    // the continuous part of a candidate lives in a normalised, mostly logarithmic space
+    struct SearchPoint
+    {
+        std::array<double, 5> x;    // log peak freq, peak gain, log peak Q, log low cut freq, log high cut freq
+        Slope lowCutSlope, highCutSlope;
+        CutType lowCutType, highCutType;    // the user's choice, the fit doesn't change families
+        bool lowCutEnabled, peakEnabled, highCutEnabled;    // likewise, the fit never switches a band on or off
+    };
+
+    const std::array<double, 5> lowerBounds{ std::log(20.0), -24.0, std::log(0.1), std::log(20.0), std::log(20.0) };
+    const std::array<double, 5> upperBounds{ std::log(20000.0), 24.0, std::log(10.0), std::log(20000.0), std::log(20000.0) };
+
+    SearchPoint toSearchPoint(const ChainSettings& s)
+    {
+        SearchPoint p;
+        p.x = { std::log((double)s.peakFreq), (double)s.peakGainDB, std::log((double)s.peakQ), std::log((double)s.lowCutFreq), std::log((double)s.highCutFreq) };
+        for (size_t k = 0; k < p.x.size(); ++k)
+            p.x[k] = juce::jlimit(lowerBounds[k], upperBounds[k], p.x[k]);
+
+        p.lowCutSlope = s.lowCutSlope;
+        p.highCutSlope = s.highCutSlope;
+        p.lowCutType = s.lowCutType;
+        p.highCutType = s.highCutType;
+        p.lowCutEnabled = s.lowCutEnabled;
+        p.peakEnabled = s.peakEnabled;
+        p.highCutEnabled = s.highCutEnabled;
+        return p;
+    }
+
+    ChainSettings toChainSettings(const SearchPoint& p)
+    {
+        ChainSettings s;
+        s.peakFreq = float(std::exp(p.x[0]));
+        s.peakGainDB = float(p.x[1]);
+        s.peakQ = float(std::exp(p.x[2]));
+        s.lowCutFreq = float(std::exp(p.x[3]));
+        s.lowCutSlope = p.lowCutSlope;
+        s.highCutFreq = float(std::exp(p.x[4]));
+        s.highCutSlope = p.highCutSlope;
+        s.lowCutType = p.lowCutType;
+        s.highCutType = p.highCutType;
+        s.lowCutEnabled = p.lowCutEnabled;
+        s.peakEnabled = p.peakEnabled;
+        s.highCutEnabled = p.highCutEnabled;
+        return s;
+    }
+
+    double nextGaussian(juce::Random& random)
+    {
+        // Box-Muller
+        const auto u1 = juce::jmax(1.0e-12, random.nextDouble());
+        const auto u2 = random.nextDouble();
+        return std::sqrt(-2.0 * std::log(u1)) * std::cos(juce::MathConstants<double>::twoPi * u2);
+    }
+}
+
+//==============================================================================
+struct MatchEQ::FitJob : juce::ThreadPoolJob
+{
+    FitJob(LatestValue<MatchResult>& resultsToUse, const ChainSettings& initialSettings, double rate) :
+        juce::ThreadPoolJob("Match EQ"),
+        results(resultsToUse),
+        initial(initialSettings),
+        sampleRate(rate)
+    {
+    }
+
+    JobStatus runJob() override
+    {
+        if (referenceFile != juce::File())
+        {
+            SpectrumAverage reference;
+            if (!analyseReferenceFile(referenceFile, reference, [this] { return shouldExit(); }))
+            {
+                publish(toSearchPoint(initial), 0, 0.f, true, true);
+                return jobHasFinished;
+            }
+
+            auto referenceDecibels = reference.getDecibels();
+            for (size_t i = 0; i < target.size(); ++i)
+                target[i] = referenceDecibels[i] - target[i];
+        }
+
+        fit();
+        return jobHasFinished;
+    }
+
+    MatchSpectrum target{};
+    juce::File referenceFile;
+
+private:
+    static constexpr int batchSize = 64;
+    static constexpr int maxBatches = 150;
+
+    LatestValue<MatchResult>& results;
+    ChainSettings initial;
+    double sampleRate;
+
+    void fit()
+    {
+        BatchEvaluator evaluator(sampleRate, target);
+        juce::Random random(0x3c6ef372);
+
+        std::vector<SearchPoint> points(batchSize);
+        std::vector<ChainSettings> candidates(batchSize);
+        std::vector<double> errors;
+
+        // first batch: the current settings plus a uniform spread over the whole space
+        auto best = toSearchPoint(initial);
+        points[0] = best;
+        for (size_t b = 1; b < points.size(); ++b)
+        {
+            points[b] = best;
+            for (size_t k = 0; k < best.x.size(); ++k)
+                points[b].x[k] = juce::jmap(random.nextDouble(), lowerBounds[k], upperBounds[k]);
+
+            points[b].lowCutSlope = static_cast<Slope>(random.nextInt(numSlopes));
+            points[b].highCutSlope = static_cast<Slope>(random.nextInt(numSlopes));
+        }
+
+        auto bestError = std::numeric_limits<double>::max();
+        auto sigma = 0.25;
+
+        for (int batch = 0; batch < maxBatches; ++batch)
+        {
+            if (shouldExit())
+                return;
+
+            if (batch > 0)
+            {
+                // later batches: gaussian steps around the best point, slopes mutate occasionally
+                for (auto& point : points)
+                {
+                    point = best;
+                    for (size_t k = 0; k < point.x.size(); ++k)
+                    {
+                        const auto step = nextGaussian(random) * sigma * (upperBounds[k] - lowerBounds[k]);
+                        point.x[k] = juce::jlimit(lowerBounds[k], upperBounds[k], point.x[k] + step);
+                    }
+
+                    if (random.nextFloat() < 0.1f)
+                        point.lowCutSlope = static_cast<Slope>(random.nextInt(numSlopes));
+                    if (random.nextFloat() < 0.1f)
+                        point.highCutSlope = static_cast<Slope>(random.nextInt(numSlopes));
+                }
+            }
+
+            for (size_t b = 0; b < points.size(); ++b)
+                candidates[b] = toChainSettings(points[b]);
+
+            evaluator.evaluate(candidates, errors);
+
+            const auto bestInBatch = std::min_element(errors.begin(), errors.end()) - errors.begin();
+            if (errors[(size_t)bestInBatch] < bestError)
+            {
+                bestError = errors[(size_t)bestInBatch];
+                best = points[(size_t)bestInBatch];
+                sigma = juce::jmin(0.5, sigma * 1.2);
+            }
+            else
+            {
+                sigma *= 0.8;
+            }
+
+            const bool converged = sigma < 1.0e-3;
+            publish(best, bestError, float(batch + 1) / float(maxBatches), converged, false);
+
+            if (converged)
+                return;
+        }
+
+        publish(best, bestError, 1.f, true, false);
+    }
+
+    void publish(const SearchPoint& point, double error, float progress, bool finished, bool failed)
+    {
+        auto& result = results.getWriteSlot();
+        result.settings = toChainSettings(point);
+        result.error = error;
+        result.progress = progress;
+        result.finished = finished;
+        result.failed = failed;
+        results.publish();
+    }
+};
+
+//==============================================================================
+MatchEQ::MatchEQ() = default;
+
+MatchEQ::~MatchEQ()
+{
+    cancel();
+}
+
+void MatchEQ::start(const MatchSpectrum& target, const ChainSettings& initial, double sampleRate)
+{
+    auto newJob = std::make_unique<FitJob>(results, initial, sampleRate);
+    newJob->target = target;
+    launch(std::move(newJob));
+}
+
+void MatchEQ::start(const MatchSpectrum& sourceDecibels, const juce::File& referenceFile, const ChainSettings& initial, double sampleRate)
+{
+    auto newJob = std::make_unique<FitJob>(results, initial, sampleRate);
+    newJob->target = sourceDecibels;
+    newJob->referenceFile = referenceFile;
+    launch(std::move(newJob));
+}
+
+void MatchEQ::launch(std::unique_ptr<FitJob> newJob)
+{
+    cancel();
+
+    // drop whatever the previous job published last
+    results.pull();
+
+    job = std::move(newJob);
+    pool.addJob(job.get(), false);
+}
+
+void MatchEQ::cancel()
+{
+    if (job == nullptr)
+        return;
+
+    // no timeout: the job may still be inside a file read and must not be deleted under the pool.
+    // it checks shouldExit() between read chunks and fit batches, so this is one chunk or batch at most
+    pool.removeJob(job.get(), true, -1);
+
+    job.reset();
+}
+
+bool MatchEQ::isRunning() const
+{
+    return job != nullptr && pool.contains(job.get());
+}
@@ -0,0 +1,91 @@
+/*
+  ==============================================================================
+
+    MatchEQ.h
+    Fits the EQ's ChainSettings so a source spectrum matches a reference.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include "PluginProcessor.h"
+
+// log-spaced frequencies every spectrum and candidate response is compared on
+struct MatchGrid
+{
+    static constexpr int numPoints = 128;
+
+    static double getFrequency(int index)
+    {
+        return juce::mapToLog10(double(index) / double(numPoints - 1), 20.0, 20000.0);
+    }
+};
+
+using MatchSpectrum = std::array<double, MatchGrid::numPoints>;
+
+/**
+ long-term average power spectrum on the match grid, fed with the
+ decibel frames the analyzer already produces.
+ */
+struct SpectrumAverage
+{
+    void addFrame(const float* decibels, int numBins, double binWidth);
+    void clear();
+
+    bool isEmpty() const { return numFrames == 0; }
+    MatchSpectrum getDecibels() const;
+
+private:
+    MatchSpectrum powerSum{};
+    int numFrames = 0;
+};
+
+// long-term average spectrum of an audio file, returns false if it can't be read or was cancelled
+bool analyseReferenceFile(const juce::File& file, SpectrumAverage& average, const std::function<bool()>& shouldExit);
+
+struct MatchResult
+{
+    ChainSettings settings;
+    double error{ 0 };      // rms dB deviation from the target, after removing the level offset
+    float progress{ 0 };
+    bool finished{ false };
+    bool failed{ false };
+};
+
+/**
+ runs the fit as a cancellable background job. candidates are evaluated in batches
+ straight from their biquad coefficients, |H|^2 = |B(e^jw)|^2 / |A(e^jw)|^2, over
+ precomputed cos(w) and cos(2w) tables, so the inner loops are plain vectorizable
+ arithmetic. the best candidate so far is published after every batch.
+ */
+class MatchEQ
+{
+public:
+    MatchEQ();
+    ~MatchEQ();
+
+    // target is the desired EQ response in dB on the match grid (reference minus source)
+    void start(const MatchSpectrum& target, const ChainSettings& initial, double sampleRate);
+
+    // the source is measured here, the reference is analysed from a file inside the job
+    void start(const MatchSpectrum& sourceDecibels, const juce::File& referenceFile, const ChainSettings& initial, double sampleRate);
+
+    void cancel();
+    bool isRunning() const;
+
+    // newest progress from the job, nullptr if nothing changed since the last call
+    const MatchResult* pullResult() { return results.pull(); }
+
+private:
+    struct FitJob;
+
+    juce::ThreadPool pool{ 1 };
+    std::unique_ptr<FitJob> job;
+    LatestValue<MatchResult> results;
+
+    void launch(std::unique_ptr<FitJob> newJob);
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(MatchEQ)
+};
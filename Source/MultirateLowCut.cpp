@@ -0,0 +1,542 @@
+/*
+  ==============================================================================
+
+    MultirateLowCut.cpp
+    The low cut run at a decimated rate, for very low cutoffs at high sample rates.
+
+  ==============================================================================
+*/
+
+#include "MultirateLowCut.h"
+#include "OfflineRender.h"
+
+namespace
+{
+    // the last half-band is steep, 0.2 - 0.3 of its input rate, so the internal rate is usable up
+    // to 0.4 of it. the ones before only have to keep their images clear of that and get by with less
+    constexpr int steepTaps = 67;
+    constexpr int wideTaps = 27;
+    constexpr double passbandEdge = 0.4;
+    constexpr double stopbandAttenuationDB = 100.0;
+
+    int getNumTaps(int stage, int numStages)
+    {
+        return stage == numStages - 1 ? steepTaps : wideTaps;
+    }
+
+    double besselI0(double x)
+    {
+        double sum = 1, term = 1;
+        for (int k = 1; k < 64 && term > sum * 1.0e-17; ++k)
+        {
+            term *= (x * x) / (4.0 * double(k) * double(k));
+            sum += term;
+        }
+        return sum;
+    }
+
+    // kaiser windowed sinc at a quarter of the rate. only the even taps before the middle are
+    // written, scaled so the taps sum to exactly 1 around the 0.5 in the middle
+    void designHalfBand(float* taps, int numTaps)
+    {
+        const auto beta = 0.1102 * (stopbandAttenuationDB - 8.7);
+        const auto middle = (numTaps - 1) / 2;
+        const auto numPairs = (numTaps + 1) / 4;
+
+        std::array<double, 32> even{};
+        double sum = 0;
+
+        for (int i = 0; i < numPairs; ++i)
+        {
+            const auto offset = double(2 * i - middle);
+            const auto ideal = std::sin(juce::MathConstants<double>::halfPi * offset) / (juce::MathConstants<double>::pi * offset);
+            const auto position = offset / double(middle);
+            even[(size_t)i] = ideal * besselI0(beta * std::sqrt(1.0 - position * position)) / besselI0(beta);
+            sum += even[(size_t)i];
+        }
+
+        for (int i = 0; i < numPairs; ++i)
+            taps[i] = float(even[(size_t)i] * 0.25 / sum);
+    }
+
+    template<typename Section>
+    std::complex<double> getResponse(const Section* sections, int numSections, double normalisedFrequency)
+    {
+        const auto z1 = std::polar(1.0, -juce::MathConstants<double>::twoPi * normalisedFrequency);
+        const auto z2 = z1 * z1;
+
+        std::complex<double> response(1.0);
+        for (int i = 0; i < numSections; ++i)
+        {
+            const auto& c = sections[i];
+            response *= (double(c.b0) + double(c.b1) * z1 + double(c.b2) * z2) / (1.0 + double(c.a1) * z1 + double(c.a2) * z2);
+        }
+
+        return response;
+    }
+
+    // how far float coefficients take the cut from its double precision design over the audio band.
+    // at a high rate a low cutoff's poles round onto each other and this is what the kernel would get wrong
+    double getRoundingError(const BiquadCoefficients* sections, int numSections, CutType type, float frequency, double sampleRate)
+    {
+        constexpr int numPoints = 16;
+
+        std::array<DoubleBiquadCoefficients, CutPrototype::maxSections> exact;
+        designCut(exact.data(), numSections, type, true, double(frequency), sampleRate);
+
+        double worst = 0;
+        for (int i = 0; i < numPoints; ++i)
+        {
+            const auto normalised = juce::mapToLog10(double(i) / double(numPoints - 1), 10.0, 20000.0) / sampleRate;
+            worst = juce::jmax(worst, std::abs(getResponse(sections, numSections, normalised) - getResponse(exact.data(), numSections, normalised)));
+        }
+
+        return worst;
+    }
+
+    // transposed direct form II, section by section over the block, like FilterKernel::process()
+    void processSections(const BiquadCoefficients* sections, BiquadState* states, int numSections, float* samples, int numSamples)
+    {
+        for (int section = 0; section < numSections; ++section)
+        {
+            const auto c = sections[section];
+            auto s1 = states[section].s1;
+            auto s2 = states[section].s2;
+
+            for (int i = 0; i < numSamples; ++i)
+            {
+                const auto input = samples[i];
+                const auto output = c.b0 * input + s1;
+                s1 = c.b1 * input - c.a1 * output + s2;
+                s2 = c.b2 * input - c.a2 * output;
+                samples[i] = output;
+            }
+
+            juce::dsp::util::snapToZero(s1);
+            juce::dsp::util::snapToZero(s2);
+            states[section] = { s1, s2 };
+        }
+    }
+}
+
+int MultirateLowCut::getNumStages(double sampleRate)
+{
+    int stages = 0;
+    while (stages < maxStages && sampleRate / double(2 << stages) >= minimumRate * 0.999)
+        ++stages;
+
+    return stages;
+}
+
+int MultirateLowCut::getLatencySamples(double sampleRate)
+{
+    // each stage delays by (numTaps - 1) / 2 of its own input samples on the way down and again on the way up
+    const auto stages = getNumStages(sampleRate);
+
+    int samples = 0;
+    for (int stage = 0; stage < stages; ++stage)
+        samples += (getNumTaps(stage, stages) - 1) << stage;
+
+    return samples;
+}
+
+size_t MultirateLowCut::getRequiredBytes(int numChannels)
+{
+    return DSPArena::getAlignedSize(sizeof(Design))
+         + DSPArena::getAlignedSize(sizeof(ChannelState) * (size_t)numChannels);
+}
+
+void MultirateLowCut::prepare(DSPArena& arena, int newNumChannels, double newSampleRate, int maximumBlockSize)
+{
+    static_assert(steepTaps <= maxTaps && (steepTaps + 1) % 4 == 0 && (wideTaps + 1) % 4 == 0, "half-bands have 4k + 3 taps");
+
+    numChannels = newNumChannels;
+    sampleRate = newSampleRate;
+    design = arena.allocate<Design>();
+    states = arena.allocate<ChannelState>((size_t)numChannels);
+
+    numStages = getNumStages(sampleRate);
+    jassert(getLatencySamples(sampleRate) < delaySize);
+
+    for (int stage = 0; stage < numStages; ++stage)
+    {
+        auto& halfBand = design->halfBands[(size_t)stage];
+        halfBand.numTaps = getNumTaps(stage, numStages);
+        designHalfBand(halfBand.taps.data(), halfBand.numTaps);
+    }
+
+    input.setSize(numChannels, juce::jmax(1, maximumBlockSize));
+
+    gainStep = 1.f / float(juce::jmax(1, juce::roundToInt(sampleRate * 0.02)));
+    lowFadeLength = juce::jmax(1, juce::roundToInt(sampleRate / double(1 << numStages) * 0.02));
+
+    resetAll();
+}
+
+void MultirateLowCut::setEnabled(bool shouldBeEnabled)
+{
+    if (shouldBeEnabled == enabled)
+        return;
+
+    enabled = shouldBeEnabled;
+    resetAll();
+}
+
+void MultirateLowCut::resetAll()
+{
+    if (states != nullptr)
+        for (int ch = 0; ch < numChannels; ++ch)
+            states[ch] = {};
+
+    latency = enabled && design != nullptr ? getLatencySamples(sampleRate) : 0;
+    numSections = numFadingSections = 0;
+    sectionsPending = false;
+    requestedSections = -1;
+    engaged = false;
+    gain = 0;
+}
+
+void MultirateLowCut::reset()
+{
+    if (states == nullptr)
+        return;
+
+    for (int ch = 0; ch < numChannels; ++ch)
+    {
+        auto& state = states[ch];
+        state.stages = {};
+        state.sections = {};
+        state.fadingSections = {};
+        state.fadeRemaining = 0;
+    }
+
+    if (sectionsPending)
+        switchSections(design->pendingSections, numPendingSections, pendingType, false);
+}
+
+bool MultirateLowCut::setCut(int newNumSections, CutType type, float frequency, bool fade)
+{
+    if (latency == 0)
+        return false;
+
+    newNumSections = juce::jlimit(0, CutPrototype::maxSections, newNumSections);
+
+    // the rest of the chain redesigns far more often than the low cut changes
+    if (newNumSections == requestedSections && type == requestedType && frequency == requestedFrequency)
+    {
+        if (!fade)
+            finishFades();
+
+        return engaged;
+    }
+
+    requestedSections = newNumSections;
+    requestedType = type;
+    requestedFrequency = frequency;
+
+    const auto wasRunning = isRunning();
+    const auto internalRate = sampleRate / double(1 << numStages);
+
+    Sections designed;
+    auto shouldEngage = newNumSections > 0;
+
+    // the cut runs wherever it comes out closer to its exact response. here that is the rounding at the
+    // internal rate plus |1 - H| at the last half-band's passband edge, what the subtraction leaves there
+    if (shouldEngage)
+    {
+        designCut(designed.data(), newNumSections, type, true, frequency, internalRate);
+        const auto residual = std::abs(1.0 - getResponse(designed.data(), newNumSections, passbandEdge));
+
+        if (residual > maxResidual)
+        {
+            shouldEngage = false;
+        }
+        else
+        {
+            Sections fullRate;
+            designCut(fullRate.data(), newNumSections, type, true, frequency, sampleRate);
+
+            shouldEngage = residual + getRoundingError(designed.data(), newNumSections, type, frequency, internalRate)
+                         < getRoundingError(fullRate.data(), newNumSections, type, frequency, sampleRate);
+        }
+    }
+
+    // going out keeps the cut it had, so the band it removed ramps out unchanged
+    if (shouldEngage)
+    {
+        if (!wasRunning)
+            reset();
+
+        switchSections(designed, newNumSections, type, fade && wasRunning);
+    }
+
+    engaged = shouldEngage;
+
+    if (!fade)
+        finishFades();
+
+    return engaged;
+}
+
+void MultirateLowCut::switchSections(const Sections& designed, int newNumSections, CutType type, bool fade)
+{
+    const auto changed = newNumSections != numSections || type != sectionsType;
+
+    // a change that needs a fade of its own waits for the running one to end, restarting would jump out of the mix
+    if (fade && changed && numChannels > 0 && states[0].fadeRemaining > 0)
+    {
+        design->pendingSections = designed;
+        numPendingSections = newNumSections;
+        pendingType = type;
+        sectionsPending = true;
+        return;
+    }
+
+    sectionsPending = false;
+
+    if (changed)
+    {
+        // the cascade as it was keeps running at the internal rate while the new one fades in
+        if (fade)
+        {
+            design->fadingSections = design->sections;
+            numFadingSections = numSections;
+
+            for (int ch = 0; ch < numChannels; ++ch)
+            {
+                states[ch].fadingSections = states[ch].sections;
+                states[ch].fadeRemaining = lowFadeLength;
+            }
+        }
+
+        // sections coming in, or all of them for another family, start from silence
+        const auto firstCleared = type != sectionsType ? 0 : numSections;
+        for (int ch = 0; ch < numChannels; ++ch)
+            for (int section = firstCleared; section < newNumSections; ++section)
+                states[ch].sections[(size_t)section] = {};
+    }
+
+    design->sections = designed;
+    numSections = newNumSections;
+    sectionsType = type;
+}
+
+void MultirateLowCut::disengage()
+{
+    engaged = false;
+    requestedSections = -1;
+    finishFades();
+}
+
+void MultirateLowCut::finishFades()
+{
+    gain = engaged ? 1.f : 0.f;
+
+    for (int ch = 0; ch < numChannels; ++ch)
+        states[ch].fadeRemaining = 0;
+
+    if (sectionsPending)
+        switchSections(design->pendingSections, numPendingSections, pendingType, false);
+}
+
+void MultirateLowCut::process(juce::AudioBuffer<float>& buffer)
+{
+    if (latency == 0)
+        return;
+
+    // the prepared size covers every well-behaved host, this only grows for the others
+    const auto numSamples = buffer.getNumSamples();
+    const auto channels = juce::jmin(buffer.getNumChannels(), numChannels);
+    if (input.getNumChannels() < channels || input.getNumSamples() < numSamples)
+        input.setSize(channels, numSamples, false, false, true);
+
+    constexpr int mask = delaySize - 1;
+    static_assert((delaySize & mask) == 0, "the delay wraps with a mask");
+
+    for (int ch = 0; ch < channels; ++ch)
+    {
+        auto* samples = buffer.getWritePointer(ch);
+        input.copyFrom(ch, 0, samples, numSamples);
+
+        auto& state = states[ch];
+        auto position = state.delayPosition;
+
+        for (int i = 0; i < numSamples; ++i)
+        {
+            state.delay[(size_t)position] = samples[i];
+            samples[i] = state.delay[(size_t)((position - latency) & mask)];
+            position = (position + 1) & mask;
+        }
+
+        state.delayPosition = position;
+    }
+}
+
+void MultirateLowCut::subtractLowBand(juce::AudioBuffer<float>& buffer)
+{
+    if (latency == 0 || !isRunning())
+        return;
+
+    const auto numSamples = juce::jmin(buffer.getNumSamples(), input.getNumSamples());
+    const auto channels = juce::jmin(buffer.getNumChannels(), input.getNumChannels(), numChannels);
+    const auto target = engaged ? 1.f : 0.f;
+    auto rampedGain = gain;
+
+    for (int ch = 0; ch < channels; ++ch)
+    {
+        auto* low = input.getWritePointer(ch);
+        auto* samples = buffer.getWritePointer(ch);
+        processLowBand(states[ch], low, numSamples);
+
+        if (gain == target)
+        {
+            juce::FloatVectorOperations::addWithMultiply(samples, low, -gain, numSamples);
+            continue;
+        }
+
+        rampedGain = gain;
+        for (int i = 0; i < numSamples; ++i)
+        {
+            rampedGain = target > rampedGain ? juce::jmin(target, rampedGain + gainStep) : juce::jmax(target, rampedGain - gainStep);
+            samples[i] -= rampedGain * low[i];
+        }
+    }
+
+    gain = rampedGain;
+
+    // the fades run in step on every channel
+    if (sectionsPending && states[0].fadeRemaining == 0)
+        switchSections(design->pendingSections, numPendingSections, pendingType, true);
+}
+
+void MultirateLowCut::processLowBand(ChannelState& state, float* samples, int numSamples)
+{
+    // down through the stages a chunk at a time, the cut at the bottom, then back up in place
+    std::array<std::array<float, chunkSize / 2>, maxStages> decimated;
+    std::array<float*, maxStages + 1> levels;
+    std::array<int, maxStages + 1> counts;
+    std::array<bool, maxStages> startedOnSecond;
+
+    for (int start = 0; start < numSamples; start += chunkSize)
+    {
+        levels[0] = samples + start;
+        counts[0] = juce::jmin(chunkSize, numSamples - start);
+
+        for (int k = 0; k < numStages; ++k)
+        {
+            auto& stage = state.stages[(size_t)k];
+            startedOnSecond[(size_t)k] = stage.secondSample;
+            levels[(size_t)k + 1] = decimated[(size_t)k].data();
+            counts[(size_t)k + 1] = decimate(design->halfBands[(size_t)k], stage, levels[(size_t)k], counts[(size_t)k], levels[(size_t)k + 1]);
+        }
+
+        processLowRate(state, levels[(size_t)numStages], counts[(size_t)numStages]);
+
+        for (int k = numStages; --k >= 0;)
+            interpolate(design->halfBands[(size_t)k], state.stages[(size_t)k], startedOnSecond[(size_t)k],
+                        levels[(size_t)k + 1], counts[(size_t)k + 1], levels[(size_t)k], counts[(size_t)k]);
+    }
+}
+
+int MultirateLowCut::decimate(const HalfBand& halfBand, Stage& stage, const float* input, int numInput, float* output)
+{
+    const auto numTaps = halfBand.numTaps;
+    const auto numHistory = numTaps - 1;
+    const auto middle = numHistory / 2;
+    const auto numPairs = (numTaps + 1) / 4;
+
+    std::array<float, maxTaps - 1 + chunkSize> linear;
+    std::copy(stage.inputHistory.begin(), stage.inputHistory.begin() + numHistory, linear.begin());
+    std::copy(input, input + numInput, linear.begin() + numHistory);
+    const auto total = numHistory + numInput;
+
+    // an output on every second input, from the first one if the last chunk stopped half way
+    const auto first = stage.secondSample ? 0 : 1;
+    const auto numOutput = numInput > first ? (numInput - first + 1) / 2 : 0;
+    if (numInput % 2 != 0)
+        stage.secondSample = !stage.secondSample;
+
+    // the paired taps only ever meet inputs of the output's own phase and the middle tap only the other
+    // phase's, so split the two and every tap runs over contiguous samples, one output per lane
+    std::array<float, (maxTaps + chunkSize) / 2> own, other;
+    for (int i = 0; 2 * i + first < total; ++i)
+        own[(size_t)i] = linear[(size_t)(2 * i + first)];
+    for (int i = 0; 2 * i + 1 - first < total; ++i)
+        other[(size_t)i] = linear[(size_t)(2 * i + 1 - first)];
+
+    const auto* middleInputs = other.data() + (middle - 1) / 2 + first;
+    for (int j = 0; j < numOutput; ++j)
+        output[j] = 0.5f * middleInputs[j];
+
+    for (int p = 0; p < numPairs; ++p)
+    {
+        const auto tap = halfBand.taps[(size_t)p];
+        const auto* newer = own.data() + middle - p;
+        const auto* older = own.data() + p;
+
+        for (int j = 0; j < numOutput; ++j)
+            output[j] += tap * (newer[j] + older[j]);
+    }
+
+    std::copy(linear.begin() + (total - numHistory), linear.begin() + total, stage.inputHistory.begin());
+    return numOutput;
+}
+
+void MultirateLowCut::interpolate(const HalfBand& halfBand, Stage& stage, bool second, const float* input, int numInput,
+                                  float* output, int numOutput)
+{
+    const auto numLow = (halfBand.numTaps + 1) / 2;
+    const auto numHistory = numLow - 1;
+    const auto numPairs = numLow / 2;
+
+    std::array<float, maxLowTaps - 1 + chunkSize / 2> linear;
+    std::copy(stage.lowHistory.begin(), stage.lowHistory.begin() + numHistory, linear.begin());
+    std::copy(input, input + numInput, linear.begin() + numHistory);
+    const auto total = numHistory + numInput;
+
+    // the outputs on the inputs a low rate sample arrived with, the even taps doubled back to unity gain
+    std::array<float, chunkSize / 2> arrivals{};
+    for (int p = 0; p < numPairs; ++p)
+    {
+        const auto tap = 2.f * halfBand.taps[(size_t)p];
+        const auto* newer = linear.data() + numHistory - p;
+        const auto* older = linear.data() + p;
+
+        for (int j = 0; j < numInput; ++j)
+            arrivals[(size_t)j] += tap * (newer[j] + older[j]);
+    }
+
+    // in between, the only tap that lines up with a low rate sample is the 0.5 in the middle
+    int numArrived = 0;
+    for (int i = 0; i < numOutput; ++i)
+    {
+        output[i] = second ? arrivals[(size_t)numArrived++] : linear[(size_t)(numHistory + numArrived - numPairs)];
+        second = !second;
+    }
+
+    jassert(numArrived == numInput);
+    std::copy(linear.begin() + (total - numHistory), linear.begin() + total, stage.lowHistory.begin());
+}
+
+void MultirateLowCut::processLowRate(ChannelState& state, float* samples, int numSamples)
+{
+    // v - lowCut(v) in place, crossfading from the old cascade after a slope change
+    std::array<float, chunkSize / 2> filtered, previous;
+    std::copy(samples, samples + numSamples, filtered.begin());
+    processSections(design->sections.data(), state.sections.data(), numSections, filtered.data(), numSamples);
+
+    if (state.fadeRemaining > 0)
+    {
+        std::copy(samples, samples + numSamples, previous.begin());
+        processSections(design->fadingSections.data(), state.fadingSections.data(), numFadingSections, previous.data(), numSamples);
+
+        for (int i = 0; i < numSamples; ++i)
+        {
+            const auto fadeGain = state.fadeRemaining > 0 ? float(lowFadeLength - --state.fadeRemaining) / float(lowFadeLength) : 1.f;
+            filtered[(size_t)i] = previous[(size_t)i] + fadeGain * (filtered[(size_t)i] - previous[(size_t)i]);
+        }
+    }
+
+    for (int i = 0; i < numSamples; ++i)
+        samples[i] -= filtered[(size_t)i];
+}
@@ -0,0 +1,153 @@
+/*
+  ==============================================================================
+
+    MultirateLowCut.h
+    The low cut run at a decimated rate, for very low cutoffs at high sample rates.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include "DSPArena.h"
+#include "FilterKernel.h"
+
+/**
+ at 88.2 kHz and above a low cut of a few tens of Hz puts its poles so close to z = 1 that
+ float coefficients can barely tell them apart. this halves the rate down to the lowest one
+ that is still 44.1 kHz or more, runs the cut there, and takes what it removed away from the
+ full rate signal:
+
+     y = delayed(x) - interpolated(v - lowCut(v)),   v = decimated(x)
+
+ the resampling is a chain of linear phase half-band FIRs, so the full rate path only needs
+ a matching delay, which is the latency the processor reports while the option is on.
+ the removed band has to be gone by the time the last half-band starts to roll off, so a
+ cut whose response still differs from a wire there by more than maxResidual stays in the
+ kernel at the full rate instead, and so does one the kernel's float coefficients already
+ get closer to its double precision design than this path would.
+ */
+class MultirateLowCut
+{
+public:
+    static constexpr int maxStages = 4;             // 705.6 / 768 kHz down to 44.1 / 48 kHz
+    static constexpr double minimumRate = 44100.0;
+    static constexpr double maxResidual = 0.05;     // |1 - H| at the last half-band's passband edge
+
+    // halvings down to the internal rate, 0 below 88.2 kHz where the kernel does fine on its own
+    static int getNumStages(double sampleRate);
+
+    // the delay the option adds at this rate, 0 if it has nothing to do there
+    static int getLatencySamples(double sampleRate);
+
+    static size_t getRequiredBytes(int numChannels);
+
+    // allocates the kept input for maximumBlockSize samples, so call from prepareToPlay
+    void prepare(DSPArena& arena, int numChannels, double sampleRate, int maximumBlockSize);
+
+    // switching either way starts over from silence, the caller reports the new latency
+    void setEnabled(bool shouldBeEnabled);
+    bool isEnabled() const { return enabled; }
+    int getLatencySamples() const { return latency; }
+
+    // clears the decimated path, the delay keeps running
+    void reset();
+
+    // designs the cut at the internal rate, numSections 0 for no low cut. returns true if it runs here,
+    // in which case the kernel must leave it out. with fade the removed band ramps in or out
+    bool setCut(int numSections, CutType type, float frequency, bool fade);
+
+    bool isEngaged() const { return engaged; }
+
+    // stops subtracting at once, e.g. while an offline render runs the cut at the full rate
+    void disengage();
+
+    // delays the block by the latency and keeps the undelayed input for subtractLowBand()
+    void process(juce::AudioBuffer<float>& buffer);
+
+    // runs the decimated cut over the kept input and subtracts what it removes, call once per process()
+    void subtractLowBand(juce::AudioBuffer<float>& buffer);
+
+private:
+    // 4k + 3 taps, every odd tap but the 0.5 in the middle is zero
+    static constexpr int maxTaps = 67;
+    static constexpr int maxPairs = (maxTaps + 1) / 4;
+    static constexpr int maxLowTaps = (maxTaps + 1) / 2;     // the even ones, what the interpolator sees
+
+    static constexpr int delaySize = 1024;
+    static constexpr int chunkSize = 256;
+
+    struct HalfBand
+    {
+        int numTaps = 0;
+        std::array<float, maxPairs> taps{};   // h[0], h[2], ... up to the middle, the rest mirrors them
+    };
+
+    using Sections = std::array<BiquadCoefficients, CutPrototype::maxSections>;
+
+    struct Design
+    {
+        std::array<HalfBand, maxStages> halfBands;
+        Sections sections, fadingSections, pendingSections;
+    };
+
+    // the newest inputs each side of the stage, oldest first, carried over from the last chunk
+    struct Stage
+    {
+        std::array<float, maxTaps - 1> inputHistory{};
+        std::array<float, maxLowTaps - 1> lowHistory{};
+        bool secondSample = false;
+    };
+
+    struct alignas(DSPArena::alignment) ChannelState
+    {
+        std::array<float, delaySize> delay{};
+        int delayPosition = 0;
+
+        std::array<Stage, maxStages> stages;
+        std::array<BiquadState, CutPrototype::maxSections> sections, fadingSections;
+        int fadeRemaining = 0;
+    };
+
+    Design* design = nullptr;
+    ChannelState* states = nullptr;
+    int numChannels = 0;
+    double sampleRate = 0;
+
+    bool enabled = false;
+    int numStages = 0;
+    int latency = 0;
+
+    juce::AudioBuffer<float> input;
+
+    int numSections = 0, numFadingSections = 0;
+    CutType sectionsType = CutType_Butterworth;
+
+    // a change that arrived during a fade, switched to once it is over
+    bool sectionsPending = false;
+    int numPendingSections = 0;
+    CutType pendingType = CutType_Butterworth;
+
+    // the last cut asked for, engaged says where it went
+    int requestedSections = -1;
+    CutType requestedType = CutType_Butterworth;
+    float requestedFrequency = 0;
+
+    int lowFadeLength = 1;
+    bool engaged = false;
+    float gain = 0, gainStep = 1;
+
+    void resetAll();
+    void finishFades();
+    void switchSections(const Sections& designed, int newNumSections, CutType type, bool fade);
+    bool isRunning() const { return engaged || gain > 0; }
+
+    void processLowBand(ChannelState& state, float* samples, int numSamples);
+    void processLowRate(ChannelState& state, float* samples, int numSamples);
+
+    // chunkSize inputs at most, returns the number of outputs
+    static int decimate(const HalfBand& halfBand, Stage& stage, const float* input, int numInput, float* output);
+    static void interpolate(const HalfBand& halfBand, Stage& stage, bool startedOnSecond, const float* input, int numInput,
+                            float* output, int numOutput);
+};
@@ -0,0 +1,220 @@
+/*
+  ==============================================================================
+
+    OfflineRender.cpp
+    Double precision filter kernel and designs for non-realtime bounces.
+
+  ==============================================================================
+*/
+
+#include "OfflineRender.h"
+#include "PluginProcessor.h"
+#include "CutDesign.h"
+#include <complex>
+
+namespace
+{
+    constexpr double pi = juce::MathConstants<double>::pi;
+
+    // IIR::Coefficients::makePeakFilter in double
+    DoubleBiquadCoefficients makePeak(double sampleRate, double frequency, double q, double gainFactor)
+    {
+        const auto A = std::sqrt(juce::jmax(0.0, gainFactor));
+        const auto omega = 2.0 * pi * juce::jmax(frequency, 2.0) / sampleRate;
+        const auto alpha = std::sin(omega) / (q * 2.0);
+        const auto c2 = -2.0 * std::cos(omega);
+        const auto alphaTimesA = alpha * A;
+        const auto alphaOverA = alpha / A;
+        const auto a0 = 1.0 + alphaOverA;
+
+        return { (1.0 + alphaTimesA) / a0, c2 / a0, (1.0 - alphaTimesA) / a0, c2 / a0, (1.0 - alphaOverA) / a0 };
+    }
+}
+
+int getOfflineSubBlockSize(OfflineQuality quality)
+{
+    switch (quality)
+    {
+        case OfflineQuality::High:      return 64;
+        case OfflineQuality::Maximum:   return 16;
+        case OfflineQuality::Realtime:  break;
+    }
+
+    return 0;
+}
+
+juce::String getOfflineQualityName(OfflineQuality quality)
+{
+    switch (quality)
+    {
+        case OfflineQuality::High:      return "High";
+        case OfflineQuality::Maximum:   return "Maximum";
+        case OfflineQuality::Realtime:  break;
+    }
+
+    return "Same as Realtime";
+}
+
+void designDoubleKernel(DoubleKernelCoefficients& kernel, const ChainSettings& settings, double sampleRate)
+{
+    // sections switched off keep their old coefficients, like FilterKernel
+    kernel.activeMask = 0;
+
+    if (settings.lowCutEnabled)
+    {
+        const auto numLowCutSections = settings.lowCutSlope + 1;
+        designCut(kernel.sections.data(), numLowCutSections, settings.lowCutType, true, double(settings.lowCutFreq), sampleRate);
+        kernel.activeMask |= (1u << numLowCutSections) - 1;
+    }
+
+    if (settings.peakEnabled)
+    {
+        kernel.sections[KernelCoefficients::peakSection] = makePeak(sampleRate, settings.peakFreq, settings.peakQ,
+                                                                    juce::Decibels::decibelsToGain(double(settings.peakGainDB)));
+        kernel.activeMask |= 1u << KernelCoefficients::peakSection;
+    }
+
+    if (settings.highCutEnabled)
+    {
+        const auto numHighCutSections = settings.highCutSlope + 1;
+        designCut(kernel.sections.data() + KernelCoefficients::peakSection + 1, numHighCutSections, settings.highCutType, false,
+                  double(settings.highCutFreq), sampleRate);
+        kernel.activeMask |= ((1u << numHighCutSections) - 1) << (KernelCoefficients::peakSection + 1);
+    }
+}
+
+double getPinkNoisePowerGain(const DoubleKernelCoefficients& kernel, double sampleRate)
+{
+    constexpr int numPoints = 64;
+    const auto maxFrequency = juce::jmin(20000.0, sampleRate * 0.5 * 0.99);
+
+    double sum = 0;
+    for (int i = 0; i < numPoints; ++i)
+    {
+        const auto frequency = juce::mapToLog10(double(i) / double(numPoints - 1), 20.0, maxFrequency);
+        const auto z1 = std::polar(1.0, -2.0 * pi * frequency / sampleRate);
+        const auto z2 = z1 * z1;
+
+        std::complex<double> response(1.0);
+        for (int section = 0; section < KernelCoefficients::maxSections; ++section)
+        {
+            if (!kernel.isActive(section))
+                continue;
+
+            const auto& c = kernel.sections[(size_t)section];
+            response *= (c.b0 + c.b1 * z1 + c.b2 * z2) / (1.0 + c.a1 * z1 + c.a2 * z2);
+        }
+
+        sum += std::norm(response);
+    }
+
+    return juce::jmax(1.0e-6, sum / double(numPoints));
+}
+
+//==============================================================================
+size_t DoubleFilterKernel::getRequiredBytes(int numChannels)
+{
+    return DSPArena::getAlignedSize(sizeof(DoubleKernelCoefficients))
+         + DSPArena::getAlignedSize(sizeof(ChannelState) * (size_t)numChannels);
+}
+
+void DoubleFilterKernel::prepare(DSPArena& arena, int newNumChannels)
+{
+    numChannels = newNumChannels;
+    coefficients = arena.allocate<DoubleKernelCoefficients>();
+    states = arena.allocate<ChannelState>((size_t)numChannels);
+}
+
+void DoubleFilterKernel::setCoefficients(const DoubleKernelCoefficients& newCoefficients)
+{
+    if (coefficients != nullptr)
+        *coefficients = newCoefficients;
+}
+
+void DoubleFilterKernel::reset()
+{
+    for (int ch = 0; ch < numChannels; ++ch)
+        states[ch] = {};
+}
+
+void DoubleFilterKernel::resetSections(juce::uint32 sectionMask)
+{
+    for (int ch = 0; ch < numChannels; ++ch)
+        for (int section = 0; section < KernelCoefficients::maxSections; ++section)
+            if ((sectionMask >> section) & 1)
+                states[ch].sections[(size_t)section] = {};
+}
+
+void DoubleFilterKernel::copyFrom(const DoubleFilterKernel& other)
+{
+    if (coefficients == nullptr || other.coefficients == nullptr)
+        return;
+
+    jassert(numChannels == other.numChannels);
+    *coefficients = *other.coefficients;
+    std::copy(other.states, other.states + juce::jmin(numChannels, other.numChannels), states);
+}
+
+void DoubleFilterKernel::process(float* samples, int numSamples, int channel)
+{
+    if (coefficients == nullptr || !juce::isPositiveAndBelow(channel, numChannels) || numSamples <= 0)
+        return;
+
+    auto& channelState = states[channel];
+
+    // sample by sample through the whole cascade, so nothing is rounded to float between sections
+    std::array<DoubleBiquadCoefficients, KernelCoefficients::maxSections> active;
+    std::array<DoubleBiquadState*, KernelCoefficients::maxSections> activeStates;
+    int numActive = 0;
+
+    for (int section = 0; section < KernelCoefficients::maxSections; ++section)
+    {
+        if (coefficients->isActive(section))
+        {
+            active[(size_t)numActive] = coefficients->sections[(size_t)section];
+            activeStates[(size_t)numActive] = &channelState.sections[(size_t)section];
+            ++numActive;
+        }
+    }
+
+    for (int i = 0; i < numSamples; ++i)
+    {
+        double x = samples[i];
+        for (int s = 0; s < numActive; ++s)
+        {
+            const auto& c = active[(size_t)s];
+            auto& state = *activeStates[(size_t)s];
+
+            const auto y = c.b0 * x + state.s1;
+            state.s1 = c.b1 * x - c.a1 * y + state.s2;
+            state.s2 = c.b2 * x - c.a2 * y;
+            x = y;
+        }
+
+        samples[i] = float(x);
+    }
+}
+
+void DoubleFilterKernel::takeStateFrom(const FilterKernel& kernel)
+{
+    for (int ch = 0; ch < juce::jmin(numChannels, kernel.getNumChannels()); ++ch)
+    {
+        for (int section = 0; section < KernelCoefficients::maxSections; ++section)
+        {
+            const auto& state = kernel.getState(ch, section);
+            states[ch].sections[(size_t)section] = { double(state.s1), double(state.s2) };
+        }
+    }
+}
+
+void DoubleFilterKernel::giveStateTo(FilterKernel& kernel) const
+{
+    for (int ch = 0; ch < juce::jmin(numChannels, kernel.getNumChannels()); ++ch)
+    {
+        for (int section = 0; section < KernelCoefficients::maxSections; ++section)
+        {
+            const auto& state = states[ch].sections[(size_t)section];
+            kernel.getState(ch, section) = { float(state.s1), float(state.s2) };
+        }
+    }
+}
@@ -0,0 +1,101 @@
+/*
+  ==============================================================================
+
+    OfflineRender.h
+    Double precision filter kernel and designs for non-realtime bounces.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include "DSPArena.h"
+#include "FilterKernel.h"
+
+struct ChainSettings;
+
+/**
+ what the processor does when the host renders offline. Realtime renders exactly like
+ playback; the other tiers run the filters in double and redesign the coefficients
+ every few samples, interpolating from the previous block's settings to this block's.
+ */
+enum class OfflineQuality
+{
+    Realtime,
+    High,       // a new design every 64 samples
+    Maximum     // a new design every 16 samples
+};
+
+// samples between designs, 0 when the tier doesn't interpolate
+int getOfflineSubBlockSize(OfflineQuality quality);
+juce::String getOfflineQualityName(OfflineQuality quality);
+
+struct DoubleBiquadCoefficients
+{
+    double b0 = 1, b1 = 0, b2 = 0, a1 = 0, a2 = 0;
+};
+
+struct DoubleBiquadState
+{
+    double s1 = 0, s2 = 0;
+};
+
+// the same sections, in the same order, as KernelCoefficients
+struct DoubleKernelCoefficients
+{
+    std::array<DoubleBiquadCoefficients, KernelCoefficients::maxSections> sections;
+    juce::uint32 activeMask = 0;
+
+    bool isActive(int section) const { return (activeMask >> section) & 1; }
+};
+
+/**
+ the filters makeChainCoefficients designs (cuts from their prototype sections, RBJ
+ peak), computed in double straight into the sections. nothing allocates, so it can
+ run on the audio thread as often as the quality tier asks.
+ */
+void designDoubleKernel(DoubleKernelCoefficients& kernel, const ChainSettings& chainSettings, double sampleRate);
+
+// broadband power gain for pink noise, as getPinkNoisePowerGain() computes it for the float designs
+double getPinkNoisePowerGain(const DoubleKernelCoefficients& kernel, double sampleRate);
+
+/**
+ FilterKernel's cascade with double coefficients and state. sections map one to one,
+ so a running filter hands its state over in either direction without a click.
+ */
+class DoubleFilterKernel
+{
+public:
+    static size_t getRequiredBytes(int numChannels);
+
+    void prepare(DSPArena& arena, int numChannels);
+
+    void setCoefficients(const DoubleKernelCoefficients& newCoefficients);
+    void reset();
+
+    // clears the state of the sections in the mask, e.g. ones that were just switched in
+    void resetSections(juce::uint32 sectionMask);
+
+    // takes over another kernel's coefficients and state, both prepared with the same channels
+    void copyFrom(const DoubleFilterKernel& other);
+
+    void process(float* samples, int numSamples, int channel);
+
+    // continue from, or hand back to, the realtime kernel's filter state
+    void takeStateFrom(const FilterKernel& kernel);
+    void giveStateTo(FilterKernel& kernel) const;
+
+    int getNumChannels() const { return numChannels; }
+    const DoubleKernelCoefficients* getCoefficients() const { return coefficients; }
+
+private:
+    struct alignas(DSPArena::alignment) ChannelState
+    {
+        std::array<DoubleBiquadState, KernelCoefficients::maxSections> sections;
+    };
+
+    DoubleKernelCoefficients* coefficients = nullptr;
+    ChannelState* states = nullptr;
+    int numChannels = 0;
+};
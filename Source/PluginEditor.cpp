@@ -1,5 +1,6 @@
 #include "PluginProcessor.h"
 #include "PluginEditor.h"
+#include "Trace.h"
 
 //=============================================================================
 // Knob Look And Feel
@@ -177,8 +178,8 @@ juce::String Knob::getDisplayString() const
 
 ResponseCurveComponent::ResponseCurveComponent(EQtutAudioProcessor& p) :
     audioProcessor(p),
-    leftPathProducer(audioProcessor.leftChannelFifo),
-    rightPathProducer(audioProcessor.rightChannelFifo)
+    leftPathProducer(audioProcessor.leftChannelFifo, *analyzerService),
+    rightPathProducer(audioProcessor.rightChannelFifo, *analyzerService)
 {
     const auto& params = audioProcessor.getParameters();
     for (auto param : params)
@@ -188,11 +189,16 @@ ResponseCurveComponent::ResponseCurveComponent(EQtutAudioProcessor& p) :
 
     updateChain();
 
-    startTimerHz(60);
+    // the analyzer's buffers are allocated for as long as this component exists
+    audioProcessor.setAnalyzerActive(true);
+    analyzerService->addClient(*this);
 }
 
 ResponseCurveComponent::~ResponseCurveComponent()
 {
+    analyzerService->removeClient(*this);
+    audioProcessor.setAnalyzerActive(false);
+
     const auto& params = audioProcessor.getParameters();
     for (auto param : params)
     {
@@ -202,6 +208,8 @@ ResponseCurveComponent::~ResponseCurveComponent()
 
 void ResponseCurveComponent::paint(juce::Graphics& g)
 {
+    EQTUT_TRACE_SCOPE("ResponseCurveComponent::paint");
+
     using namespace juce;
 
     g.fillAll(Colour(0xFF111111));
@@ -227,23 +235,13 @@ void ResponseCurveComponent::paint(juce::Graphics& g)
         if (!monoChain.isBypassed<ChainPositions::Peak>())
             mag *= peak.coefficients->getMagnitudeForFrequency(freq, sampleRate);
 
-        if (!lowcut.isBypassed<0>())
-            mag *= lowcut.get<0>().coefficients->getMagnitudeForFrequency(freq, sampleRate);
-        if (!lowcut.isBypassed<1>())
-            mag *= lowcut.get<1>().coefficients->getMagnitudeForFrequency(freq, sampleRate);
-        if (!lowcut.isBypassed<2>())
-            mag *= lowcut.get<2>().coefficients->getMagnitudeForFrequency(freq, sampleRate);
-        if (!lowcut.isBypassed<3>())
-            mag *= lowcut.get<3>().coefficients->getMagnitudeForFrequency(freq, sampleRate);
-
-        if (!highcut.isBypassed<0>())
-            mag *= highcut.get<0>().coefficients->getMagnitudeForFrequency(freq, sampleRate);
-        if (!highcut.isBypassed<1>())
-            mag *= highcut.get<1>().coefficients->getMagnitudeForFrequency(freq, sampleRate);
-        if (!highcut.isBypassed<2>())
-            mag *= highcut.get<2>().coefficients->getMagnitudeForFrequency(freq, sampleRate);
-        if (!highcut.isBypassed<3>())
-            mag *= highcut.get<3>().coefficients->getMagnitudeForFrequency(freq, sampleRate);
+        if (!monoChain.isBypassed<ChainPositions::LowCut>())
+            for (int section = 0; section < lowcut.numSections; ++section)
+                mag *= lowcut.filters[(size_t)section].coefficients->getMagnitudeForFrequency(freq, sampleRate);
+
+        if (!monoChain.isBypassed<ChainPositions::HighCut>())
+            for (int section = 0; section < highcut.numSections; ++section)
+                mag *= highcut.filters[(size_t)section].coefficients->getMagnitudeForFrequency(freq, sampleRate);
 
         mags[i] = Decibels::gainToDecibels(mag);
     }
@@ -265,20 +263,52 @@ void ResponseCurveComponent::paint(juce::Graphics& g)
         responseCurve.lineTo(float(responseArea.getX() + i), float(map(mags[i])));
     }
 
-    auto leftChannelFFTPath = leftPathProducer.getPath();
-    leftChannelFFTPath.applyTransform(AffineTransform().translation(float(responseArea.getX()), float(responseArea.getY())));
+    // stroked in place, the analyzer paths aren't copied to move them into the response area
+    auto analysisTransform = AffineTransform::translation(float(responseArea.getX()), float(responseArea.getY()));
+
     g.setColour(Colours::red);
-    g.strokePath(leftChannelFFTPath, PathStrokeType(1.5f));
+    g.strokePath(leftPathProducer.getPath(), PathStrokeType(1.5f), analysisTransform);
 
-    auto rightChannelFFTPath = rightPathProducer.getPath();
-    rightChannelFFTPath.applyTransform(AffineTransform().translation(float(responseArea.getX()), float(responseArea.getY())));
     g.setColour(Colours::green);
-    g.strokePath(rightChannelFFTPath, PathStrokeType(1.5f));
+    g.strokePath(rightPathProducer.getPath(), PathStrokeType(1.5f), analysisTransform);
+
+    leftPathProducer.markPainted();
+    rightPathProducer.markPainted();
     
     g.setColour(Colour(0xFF222222));
     g.drawRoundedRectangle(getRenderArea().toFloat(), 1.0f, 4.f);
     g.setColour(Colour(0xFFCCCCCC));
     g.strokePath(responseCurve, PathStrokeType(2.f));
+
+    if (showStats)
+        paintStats(g);
+}
+
+void ResponseCurveComponent::paintStats(juce::Graphics& g)
+{
+    auto lines = audioProcessor.analyzerStats.createReport();
+    lines.addArray(audioProcessor.getMemoryReport());
+    auto area = getAnalysisArea().reduced(4).removeFromTop(14 * lines.size() + 6).removeFromLeft(360);
+
+    g.setColour(juce::Colours::black.withAlpha(0.7f));
+    g.fillRect(area);
+
+    g.setColour(juce::Colours::yellow);
+    g.setFont(juce::Font(juce::Font::getDefaultMonospacedFontName(), 11.f, juce::Font::plain));
+
+    area.reduce(4, 3);
+    for (auto& line : lines)
+        g.drawText(line, area.removeFromTop(14), juce::Justification::centredLeft, false);
+}
+
+void ResponseCurveComponent::mouseDoubleClick(const juce::MouseEvent&)
+{
+    // counting starts over each time the overlay is opened
+    showStats = !showStats;
+    if (showStats)
+        audioProcessor.analyzerStats.reset();
+
+    repaint();
 }
 
 void ResponseCurveComponent::resized()
@@ -389,15 +419,24 @@ void ResponseCurveComponent::resized()
 
 void ResponseCurveComponent::updateChain()
 {
-    auto chainSettings = getChainSettings(audioProcessor.apvts);
-    auto peakCoefficients = makePeakFilter(chainSettings, audioProcessor.getSampleRate());
-    updateCoefficients(monoChain.get<ChainPositions::Peak>().coefficients, peakCoefficients);
+    auto chainSettings = previewSettings.value_or(audioProcessor.getCurrentChainSettings());
+    applyChainCoefficients(monoChain, makeChainCoefficients(chainSettings, audioProcessor.getSampleRate()));
+}
+
+void ResponseCurveComponent::setSpectrumCapture(SpectrumAverage* average)
+{
+    leftPathProducer.setSpectrumCapture(average);
+    rightPathProducer.setSpectrumCapture(average);
+}
 
-    auto lowCutCoefficients = makeLowCutFilter(chainSettings, audioProcessor.getSampleRate());
-    updateCutFilter(monoChain.get<ChainPositions::LowCut>(), lowCutCoefficients, chainSettings.lowCutSlope);
+void ResponseCurveComponent::setPreviewSettings(const ChainSettings* settings)
+{
+    if (settings != nullptr)
+        previewSettings = *settings;
+    else
+        previewSettings.reset();
 
-    auto highCutCoefficients = makeHighCutFilter(chainSettings, audioProcessor.getSampleRate());
-    updateCutFilter(monoChain.get<ChainPositions::HighCut>(), highCutCoefficients, chainSettings.highCutSlope);
+    parametersChanged.set(true);
 }
 
 void ResponseCurveComponent::parameterValueChanged(int parameterIndex, float newValue)
@@ -407,13 +446,24 @@ void ResponseCurveComponent::parameterValueChanged(int parameterIndex, float new
 
 void PathProducer::process(juce::Rectangle<float> fftBounds, double sampleRate)
 {
-    juce::AudioBuffer<float> tempIncomingBuffer;
+    EQTUT_TRACE_SCOPE("analyzer fifo pull + FFT");
+
+    // handed back to the fifo on every pull, so it has to match the fifo's buffers
+    if (incomingBuffer.getNumSamples() != leftChannelFifo->getSize())
+        incomingBuffer.setSize(1, leftChannelFifo->getSize(), false, true, true);
+
+    const auto fftSize = leftChannelFFTDataGenerator.getFFTSize();
+    const auto binWidth = sampleRate / (double(fftSize));
+
+    juce::int64 ticks = 0, frameTicks = 0;
+    bool hasNewFrame = false;
+
     while (leftChannelFifo->getNumCompleteBuffersAvailable() > 0)
     {
-        if (leftChannelFifo->getAudioBuffer(tempIncomingBuffer))
+        if (leftChannelFifo->getAudioBuffer(incomingBuffer, ticks))
         {
             // shift mono buffer
-            auto size = tempIncomingBuffer.getNumSamples();
+            auto size = incomingBuffer.getNumSamples();
             juce::FloatVectorOperations::copy(
                 monoBuffer.getWritePointer(0, 0),
                 monoBuffer.getReadPointer(0, size),
@@ -423,46 +473,126 @@ void PathProducer::process(juce::Rectangle<float> fftBounds, double sampleRate)
             // copy temp buffer to end of mono buffer
             juce::FloatVectorOperations::copy(
                 monoBuffer.getWritePointer(0, monoBuffer.getNumSamples() - size),
-                tempIncomingBuffer.getReadPointer(0, 0),
+                incomingBuffer.getReadPointer(0, 0),
                 size
             );
 
             // send mono buffer to FFT data generator
-            leftChannelFFTDataGenerator.produceFFTDataForRendering(monoBuffer, -48.f);
+            leftChannelFFTDataGenerator.produceFFTDataForRendering(monoBuffer, -48.f, ticks);
+
+            // frames are taken as they're made, so the FFT fifo never holds more than one
+            while (leftChannelFFTDataGenerator.getNumAvailableFFTDataBlocks() > 0)
+            {
+                if (leftChannelFFTDataGenerator.getFFTData(fftData, frameTicks))
+                {
+                    const juce::SpinLock::ScopedLockType lock(captureLock);
+                    if (spectrumCapture != nullptr)
+                        spectrumCapture->addFrame(fftData.data(), fftSize / 2, binWidth);
+
+                    hasNewFrame = true;
+                }
+            }
+        }
+        else
+        {
+            // the fifo is being prepared or released on the message thread
+            break;
         }
     }
 
-    const auto fftSize = leftChannelFFTDataGenerator.getFFTSize();
-    const auto binWidth = sampleRate / (double(fftSize));
+    // only the newest frame is drawn
+    if (hasNewFrame)
+    {
+        EQTUT_TRACE_SCOPE("generatePath");
+        pathProducer.generatePath(fftData, fftBounds, fftSize, float(binWidth), -48.f, frameTicks);
+    }
+}
 
-    while (leftChannelFFTDataGenerator.getNumAvailableFFTDataBlocks() > 0)
+void PathProducer::discardPendingAudio()
+{
+    while (leftChannelFifo->getNumCompleteBuffersAvailable() > 0)
     {
-        std::vector<float> fftData;
-        if (leftChannelFFTDataGenerator.getFFTData(fftData))
-        {
-            pathProducer.generatePath(fftData, fftBounds, fftSize, float(binWidth), -48.f);
-        }
+        if (incomingBuffer.getNumSamples() != leftChannelFifo->getSize())
+            incomingBuffer.setSize(1, leftChannelFifo->getSize(), false, true, true);
+
+        if (!leftChannelFifo->getAudioBuffer(incomingBuffer))
+            break;
     }
+}
+
+bool PathProducer::updatePath()
+{
+    EQTUT_TRACE_SCOPE("analyzer path pull");
 
+    bool updated = false;
     while (pathProducer.getNumPathsAvailable())
     {
-        pathProducer.getPath(leftChannelFFTPath);
+        if (pathProducer.getPath(leftChannelFFTPath, pathTicks))
+        {
+            pathPainted = false;
+            updated = true;
+        }
     }
+
+    return updated;
 }
 
-void ResponseCurveComponent::timerCallback()
+void PathProducer::markPainted()
 {
-    auto fftBounds = getAnalysisArea().toFloat();
+    if (pathPainted)
+        return;
+
+    if (auto* stats = leftChannelFifo->getStats())
+        stats->record(AnalyzerStats::Paint, pathTicks);
+
+    pathPainted = true;
+}
+
+int ResponseCurveComponent::useTimeSlice()
+{
+    EQTUT_TRACE_SCOPE("analyzer worker");
+
+    if (!analyzerVisible.load())
+    {
+        leftPathProducer.discardPendingAudio();
+        rightPathProducer.discardPendingAudio();
+        return 1000 / AnalyzerService::framesPerSecond;
+    }
+
+    juce::Rectangle<float> fftBounds;
+    {
+        const juce::SpinLock::ScopedLockType lock(analysisAreaLock);
+        fftBounds = analysisArea;
+    }
+
     auto sampleRate = audioProcessor.getSampleRate();
     leftPathProducer.process(fftBounds, sampleRate);
     rightPathProducer.process(fftBounds, sampleRate);
 
+    // twice per display frame, so a finished path waits half a frame at most
+    return 1000 / (AnalyzerService::framesPerSecond * 2);
+}
+
+void ResponseCurveComponent::refreshAnalyzer()
+{
+    analyzerVisible.store(renderingOffscreen || isShowing());
+    {
+        const juce::SpinLock::ScopedLockType lock(analysisAreaLock);
+        analysisArea = getAnalysisArea().toFloat();
+    }
+
+    // only repaint when there's something new to show
+    auto needsRepaint = leftPathProducer.updatePath();
+    needsRepaint = rightPathProducer.updatePath() || needsRepaint;
+
     if (parametersChanged.compareAndSetBool(false, true))
     {
         updateChain();
+        needsRepaint = true;
     }
 
-    repaint();
+    if (needsRepaint || showStats)
+        repaint();
 }
 
 juce::Rectangle<int> ResponseCurveComponent::getRenderArea()
@@ -484,6 +614,372 @@ juce::Rectangle<int> ResponseCurveComponent::getAnalysisArea()
     return bounds;
 }
 
+//=============================================================================
+// Match EQ
+//=============================================================================
+
+MatchEQPanel::MatchEQPanel(EQtutAudioProcessor& p, ResponseCurveComponent& rc) :
+    audioProcessor(p),
+    responseCurve(rc)
+{
+    captureSourceButton.onClick = [this] { toggleCapture(sourceCapture); };
+    captureReferenceButton.onClick = [this] { toggleCapture(referenceCapture); };
+
+    loadReferenceButton.onClick = [this]
+        {
+            chooser = std::make_unique<juce::FileChooser>("Reference audio", juce::File(), "*.wav;*.aif;*.aiff;*.flac;*.ogg");
+            chooser->launchAsync(juce::FileBrowserComponent::openMode | juce::FileBrowserComponent::canSelectFiles,
+                [this](const juce::FileChooser& fc)
+                {
+                    if (fc.getResult().existsAsFile())
+                    {
+                        referenceFile = fc.getResult();
+                        referenceDecibels.reset();
+                        status.setText("Reference: " + referenceFile.getFileName(), juce::dontSendNotification);
+                    }
+                });
+        };
+
+    matchButton.onClick = [this]
+        {
+            if (matchEQ.isRunning())
+            {
+                matchEQ.cancel();
+                responseCurve.setPreviewSettings(nullptr);
+                status.setText("Match cancelled", juce::dontSendNotification);
+                updateButtons();
+            }
+            else
+            {
+                startMatch();
+            }
+        };
+
+    status.setColour(juce::Label::textColourId, juce::Colour(0xFFCCCCCC));
+    status.setFont(12.f);
+
+    addAndMakeVisible(captureSourceButton);
+    addAndMakeVisible(captureReferenceButton);
+    addAndMakeVisible(loadReferenceButton);
+    addAndMakeVisible(matchButton);
+    addAndMakeVisible(status);
+
+    startTimerHz(10);
+}
+
+MatchEQPanel::~MatchEQPanel()
+{
+    responseCurve.setSpectrumCapture(nullptr);
+    responseCurve.setPreviewSettings(nullptr);
+}
+
+void MatchEQPanel::toggleCapture(SpectrumAverage& average)
+{
+    const bool wasCapturing = activeCapture == &average;
+    stopCapture();
+
+    if (!wasCapturing)
+    {
+        average.clear();
+        activeCapture = &average;
+        responseCurve.setSpectrumCapture(activeCapture);
+    }
+
+    updateButtons();
+}
+
+void MatchEQPanel::stopCapture()
+{
+    if (activeCapture == nullptr)
+        return;
+
+    responseCurve.setSpectrumCapture(nullptr);
+
+    if (!activeCapture->isEmpty())
+    {
+        if (activeCapture == &sourceCapture)
+        {
+            sourceDecibels = getInputSpectrum(sourceCapture);
+        }
+        else
+        {
+            referenceDecibels = getInputSpectrum(referenceCapture);
+            referenceFile = juce::File();
+        }
+    }
+
+    activeCapture = nullptr;
+}
+
+MatchSpectrum MatchEQPanel::getInputSpectrum(const SpectrumAverage& average)
+{
+    auto decibels = average.getDecibels();
+
+    const auto sampleRate = audioProcessor.getSampleRate();
+    if (sampleRate <= 0)
+        return decibels;
+
+    auto chainCoefficients = makeChainCoefficients(audioProcessor.getCurrentChainSettings(), sampleRate);
+    for (int i = 0; i < MatchGrid::numPoints; ++i)
+    {
+        const auto frequency = MatchGrid::getFrequency(i);
+        if (frequency < sampleRate * 0.5)
+            decibels[(size_t)i] -= juce::Decibels::gainToDecibels(getMagnitudeForFrequency(chainCoefficients, frequency), -120.0);
+    }
+
+    return decibels;
+}
+
+void MatchEQPanel::startMatch()
+{
+    stopCapture();
+
+    const auto sampleRate = audioProcessor.getSampleRate();
+    if (!sourceDecibels.has_value() || sampleRate <= 0)
+    {
+        status.setText("Capture the source first", juce::dontSendNotification);
+        updateButtons();
+        return;
+    }
+
+    const auto initial = audioProcessor.getCurrentChainSettings();
+
+    if (referenceDecibels.has_value())
+    {
+        MatchSpectrum target;
+        for (size_t i = 0; i < target.size(); ++i)
+            target[i] = (*referenceDecibels)[i] - (*sourceDecibels)[i];
+
+        matchEQ.start(target, initial, sampleRate);
+    }
+    else if (referenceFile.existsAsFile())
+    {
+        matchEQ.start(*sourceDecibels, referenceFile, initial, sampleRate);
+    }
+    else
+    {
+        status.setText("Capture or load a reference first", juce::dontSendNotification);
+        updateButtons();
+        return;
+    }
+
+    status.setText("Matching...", juce::dontSendNotification);
+    updateButtons();
+}
+
+void MatchEQPanel::timerCallback()
+{
+    auto* result = matchEQ.pullResult();
+    if (result == nullptr)
+        return;
+
+    if (result->failed)
+    {
+        responseCurve.setPreviewSettings(nullptr);
+        status.setText("Couldn't read the reference", juce::dontSendNotification);
+    }
+    else
+    {
+        // progressive results are only drawn, the parameters (and the host's undo) get the final one
+        if (result->finished)
+        {
+            responseCurve.setPreviewSettings(nullptr);
+            audioProcessor.setChainSettings(result->settings);
+        }
+        else
+        {
+            responseCurve.setPreviewSettings(&result->settings);
+        }
+
+        juce::String text;
+        text << (result->finished ? "Matched, " : "Matching " + juce::String(juce::roundToInt(result->progress * 100.f)) + "%, ")
+             << juce::String(result->error, 1) << " dB rms";
+        status.setText(text, juce::dontSendNotification);
+    }
+
+    if (result->finished)
+        updateButtons();
+}
+
+void MatchEQPanel::updateButtons()
+{
+    captureSourceButton.setButtonText(activeCapture == &sourceCapture ? "Stop" : "Capture Source");
+    captureReferenceButton.setButtonText(activeCapture == &referenceCapture ? "Stop" : "Capture Ref");
+    matchButton.setButtonText(matchEQ.isRunning() ? "Cancel" : "Match");
+}
+
+void MatchEQPanel::resized()
+{
+    auto bounds = getLocalBounds().reduced(2);
+    const auto buttonWidth = 90;
+
+    captureSourceButton.setBounds(bounds.removeFromLeft(buttonWidth));
+    bounds.removeFromLeft(4);
+    captureReferenceButton.setBounds(bounds.removeFromLeft(buttonWidth));
+    bounds.removeFromLeft(4);
+    loadReferenceButton.setBounds(bounds.removeFromLeft(buttonWidth));
+    bounds.removeFromLeft(4);
+    matchButton.setBounds(bounds.removeFromLeft(60));
+    bounds.removeFromLeft(4);
+    status.setBounds(bounds);
+}
+
+//=============================================================================
+// Loudness Display
+//=============================================================================
+
+LoudnessDisplay::LoudnessDisplay(EQtutAudioProcessor& p) :
+    audioProcessor(p),
+    readings(p.getLoudnessReadings())
+{
+    startTimerHz(10);
+}
+
+void LoudnessDisplay::timerCallback()
+{
+    readings = audioProcessor.getLoudnessReadings();
+    repaint();
+}
+
+void LoudnessDisplay::mouseDown(const juce::MouseEvent&)
+{
+    audioProcessor.resetLoudnessMeter();
+}
+
+void LoudnessDisplay::paint(juce::Graphics& g)
+{
+    EQTUT_TRACE_SCOPE("LoudnessDisplay::paint");
+
+    using namespace juce;
+
+    g.fillAll(Colour(0xFF111111));
+
+    auto format = [](float value)
+        {
+            return std::isfinite(value) ? String(value, 1) : String("-inf");
+        };
+
+    struct Row
+    {
+        const char* label;
+        String value;
+        bool over;
+    };
+
+    // true peak above -1 dBTP is the usual delivery limit
+    const Row rows[]
+    {
+        { "M",  format(readings.momentary) + " LUFS",   false },
+        { "S",  format(readings.shortTerm) + " LUFS",   false },
+        { "I",  format(readings.integrated) + " LUFS",  false },
+        { "TP", format(readings.truePeak) + " dBTP",    readings.truePeak > -1.f }
+    };
+
+    g.setFont(12.f);
+    auto bounds = getLocalBounds().reduced(4);
+    const auto rowHeight = bounds.getHeight() / int(std::size(rows));
+
+    for (const auto& row : rows)
+    {
+        auto r = bounds.removeFromTop(rowHeight);
+        g.setColour(Colour(0xFF888888));
+        g.drawText(row.label, r.removeFromLeft(24), Justification::centredLeft, false);
+        g.setColour(row.over ? Colour(0xFFCC0000) : Colour(0xFFCCCCCC));
+        g.drawText(row.value, r, Justification::centredRight, false);
+    }
+}
+
+//=============================================================================
+// Preset Browser
+//=============================================================================
+
+PresetBrowser::PresetBrowser(EQtutAudioProcessor& p) :
+    audioProcessor(p)
+{
+    searchBox.setTextToShowWhenEmpty("Search presets", juce::Colour(0xFF888888));
+    searchBox.onTextChange = [this] { refreshResults(); };
+
+    // saves the current settings under whatever is typed in the search box
+    saveButton.onClick = [this]
+        {
+            auto name = searchBox.getText().trim();
+            if (name.isEmpty())
+                name << "Preset " << (audioProcessor.getPresetBank().getNumPresets() + 1);
+
+            audioProcessor.savePreset(name);
+            refreshResults();
+        };
+
+    presetList.setModel(this);
+    presetList.setRowHeight(18);
+    presetList.setColour(juce::ListBox::backgroundColourId, juce::Colour(0xFF111111));
+
+    addAndMakeVisible(searchBox);
+    addAndMakeVisible(saveButton);
+    addAndMakeVisible(presetList);
+
+    // another instance may have added presets since this one mapped the bank
+    audioProcessor.getPresetBank().reload();
+    refreshResults();
+}
+
+void PresetBrowser::refreshResults()
+{
+    const auto& bank = audioProcessor.getPresetBank();
+    results = bank.search(searchBox.getText().trim(), bank.getNumPresets());
+    presetList.updateContent();
+    presetList.repaint();
+}
+
+int PresetBrowser::getNumRows()
+{
+    return results.size();
+}
+
+void PresetBrowser::paintListBoxItem(int rowNumber, juce::Graphics& g, int width, int height, bool rowIsSelected)
+{
+    using namespace juce;
+
+    if (!isPositiveAndBelow(rowNumber, results.size()))
+        return;
+
+    auto index = results[rowNumber];
+    if (rowIsSelected || index == audioProcessor.getCurrentProgram())
+        g.fillAll(Colour(0xFF333333));
+
+    g.setColour(Colour(0xFFCCCCCC));
+    g.setFont(float(height) * 0.7f);
+    g.drawText(audioProcessor.getPresetBank().getName(index), 4, 0, width - 8, height, Justification::centredLeft, true);
+}
+
+void PresetBrowser::listBoxItemClicked(int row, const juce::MouseEvent&)
+{
+    if (!juce::isPositiveAndBelow(row, results.size()))
+        return;
+
+    audioProcessor.setCurrentProgram(results[row]);
+    audioProcessor.updateHostDisplay(juce::AudioProcessorListener::ChangeDetails().withProgramChanged(true));
+    presetList.repaint();
+}
+
+void PresetBrowser::paint(juce::Graphics& g)
+{
+    g.fillAll(juce::Colour(0xFF111111));
+}
+
+void PresetBrowser::resized()
+{
+    auto bounds = getLocalBounds().reduced(4);
+
+    auto header = bounds.removeFromTop(24);
+    saveButton.setBounds(header.removeFromRight(50));
+    header.removeFromRight(4);
+    searchBox.setBounds(header);
+
+    bounds.removeFromTop(4);
+    presetList.setBounds(bounds);
+}
+
 //=============================================================================
 // Editor
 //=============================================================================
@@ -491,29 +987,50 @@ EQtutAudioProcessorEditor::EQtutAudioProcessorEditor(EQtutAudioProcessor& p)
     : AudioProcessorEditor(&p), audioProcessor(p),
     
     // init labelled knobs
-    peakFreqKnob    (*audioProcessor.apvts.getParameter("Peak Freq"), "Hz"),
-    peakGainKnob    (*audioProcessor.apvts.getParameter("Peak Gain"), "dB"),
-    peakQualityKnob (*audioProcessor.apvts.getParameter("Peak Q"),    ""),
+    peakFreqKnob    (audioProcessor.parameters.getParameter(Param::PeakFreq), "Hz"),
+    peakGainKnob    (audioProcessor.parameters.getParameter(Param::PeakGain), "dB"),
+    peakQualityKnob (audioProcessor.parameters.getParameter(Param::PeakQ),    ""),
 
-    lowCutFreqKnob  (*audioProcessor.apvts.getParameter("LowCut Freq"), "Hz"),
-    lowCutSlopeKnob (*audioProcessor.apvts.getParameter("LowCut Slope"), "dB/Oct"),
+    lowCutFreqKnob  (audioProcessor.parameters.getParameter(Param::LowCutFreq), "Hz"),
+    lowCutSlopeKnob (audioProcessor.parameters.getParameter(Param::LowCutSlope), "dB/Oct"),
 
-    highCutFreqKnob (*audioProcessor.apvts.getParameter("HighCut Freq"), "Hz"),
-    highCutSlopeKnob(*audioProcessor.apvts.getParameter("HighCut Slope"), "dB/Oct"),
+    highCutFreqKnob (audioProcessor.parameters.getParameter(Param::HighCutFreq), "Hz"),
+    highCutSlopeKnob(audioProcessor.parameters.getParameter(Param::HighCutSlope), "dB/Oct"),
 
     // init response curve
     responseCurveComponent  (audioProcessor),
+
+    // init match eq
+    matchEQPanel            (audioProcessor, responseCurveComponent),
+
+    // init preset browser
+    presetBrowser           (audioProcessor),
     
     // init knob attachments
-    peakFreqKnobAtch    (audioProcessor.apvts, "Peak Freq",     peakFreqKnob),
-    peakGainKnobAtch    (audioProcessor.apvts, "Peak Gain",     peakGainKnob),
-    peakQualityKnobAtch (audioProcessor.apvts, "Peak Q",        peakQualityKnob),
+    peakFreqKnobAtch    (audioProcessor.apvts, getParameterID(Param::PeakFreq), peakFreqKnob),
+    peakGainKnobAtch    (audioProcessor.apvts, getParameterID(Param::PeakGain), peakGainKnob),
+    peakQualityKnobAtch (audioProcessor.apvts, getParameterID(Param::PeakQ), peakQualityKnob),
     
-    lowCutFreqKnobAtch  (audioProcessor.apvts, "LowCut Freq",   lowCutFreqKnob),
-    lowCutSlopeKnobAtch (audioProcessor.apvts, "LowCut Slope",  lowCutSlopeKnob),
+    lowCutFreqKnobAtch  (audioProcessor.apvts, getParameterID(Param::LowCutFreq), lowCutFreqKnob),
+    lowCutSlopeKnobAtch (audioProcessor.apvts, getParameterID(Param::LowCutSlope), lowCutSlopeKnob),
     
-    highCutFreqKnobAtch (audioProcessor.apvts, "HighCut Freq",  highCutFreqKnob),
-    highCutSlopeKnobAtch(audioProcessor.apvts, "HighCut Slope", highCutSlopeKnob)
+    highCutFreqKnobAtch (audioProcessor.apvts, getParameterID(Param::HighCutFreq), highCutFreqKnob),
+    highCutSlopeKnobAtch(audioProcessor.apvts, getParameterID(Param::HighCutSlope), highCutSlopeKnob),
+
+    // init band enable attachments
+    lowCutEnabledAtch   (audioProcessor.apvts, getParameterID(Param::LowCutEnabled), lowCutEnabledButton),
+    peakEnabledAtch     (audioProcessor.apvts, getParameterID(Param::PeakEnabled), peakEnabledButton),
+    highCutEnabledAtch  (audioProcessor.apvts, getParameterID(Param::HighCutEnabled), highCutEnabledButton),
+
+    // init morph attachments
+    morphSliderAtch     (audioProcessor.apvts, getParameterID(Param::Morph), morphSlider),
+    morphEnabledAtch    (audioProcessor.apvts, getParameterID(Param::MorphEnabled), morphEnabledButton),
+
+    // init loudness display
+    loudnessDisplay     (audioProcessor),
+
+    // init auto gain attachment
+    autoGainAtch        (audioProcessor.apvts, getParameterID(Param::AutoGain), autoGainButton)
 {
     // Make sure that before the constructor has finished, you've set the
     // editor's size to whatever you need it to be.
@@ -528,12 +1045,12 @@ EQtutAudioProcessorEditor::EQtutAudioProcessorEditor(EQtutAudioProcessor& p)
     lowCutFreqKnob.labels.add({ 0.f, "20 Hz" });
     lowCutFreqKnob.labels.add({ 1.f, "20 kHz" });
     lowCutSlopeKnob.labels.add({ 0.f, "12" });
-    lowCutSlopeKnob.labels.add({ 1.f, "48" });
+    lowCutSlopeKnob.labels.add({ 1.f, "96" });
 
     highCutFreqKnob.labels.add({ 0.f, "20 Hz" });
     highCutFreqKnob.labels.add({ 1.f, "20 kHz" });
     highCutSlopeKnob.labels.add({ 0.f, "12" });
-    highCutSlopeKnob.labels.add({ 1.f, "48" });
+    highCutSlopeKnob.labels.add({ 1.f, "96" });
 
 
     
@@ -542,7 +1059,43 @@ EQtutAudioProcessorEditor::EQtutAudioProcessorEditor(EQtutAudioProcessor& p)
         addAndMakeVisible(knob);
     }
 
-    setSize (600, 488);
+    addAndMakeVisible(lowCutEnabledButton);
+    addAndMakeVisible(peakEnabledButton);
+    addAndMakeVisible(highCutEnabledButton);
+
+    // --- CUT TYPES ---
+
+    auto setUpTypeBox = [this](juce::ComboBox& box, Param param)
+        {
+            auto* choice = dynamic_cast<juce::AudioParameterChoice*>(&audioProcessor.parameters.getParameter(param));
+            jassert(choice != nullptr);
+            box.addItemList(choice->choices, 1);
+            addAndMakeVisible(box);
+            return std::make_unique<APVTS::ComboBoxAttachment>(audioProcessor.apvts, getParameterID(param), box);
+        };
+
+    lowCutTypeAtch = setUpTypeBox(lowCutTypeBox, Param::LowCutType);
+    highCutTypeAtch = setUpTypeBox(highCutTypeBox, Param::HighCutType);
+
+    // --- MORPH CONTROLS ---
+
+    storeAButton.onClick = [this] { audioProcessor.storeMorphSnapshot(MorphA); };
+    storeBButton.onClick = [this] { audioProcessor.storeMorphSnapshot(MorphB); };
+    morphSlider.setSliderStyle(juce::Slider::SliderStyle::LinearHorizontal);
+    morphSlider.setTextBoxStyle(juce::Slider::TextEntryBoxPosition::NoTextBox, true, 0, 0);
+
+    addAndMakeVisible(storeAButton);
+    addAndMakeVisible(storeBButton);
+    addAndMakeVisible(morphEnabledButton);
+    addAndMakeVisible(morphSlider);
+
+    addAndMakeVisible(loudnessDisplay);
+    addAndMakeVisible(autoGainButton);
+
+    exportButton.onClick = [this] { showExportMenu(); };
+    addAndMakeVisible(exportButton);
+
+    setSize (800, 516);
 }
 
 EQtutAudioProcessorEditor::~EQtutAudioProcessorEditor()
@@ -563,11 +1116,41 @@ void EQtutAudioProcessorEditor::resized()
     // subcomponents in your editor..
 
     auto bounds = getLocalBounds();
+    auto presetArea = bounds.removeFromRight(200);
+
+    autoGainButton.setBounds(presetArea.removeFromBottom(28).reduced(4));
+    loudnessDisplay.setBounds(presetArea.removeFromBottom(72));
+
+    auto morphArea = presetArea.removeFromBottom(56).reduced(4);
+    auto morphButtons = morphArea.removeFromTop(24);
+    storeAButton.setBounds(morphButtons.removeFromLeft(60));
+    morphButtons.removeFromLeft(4);
+    storeBButton.setBounds(morphButtons.removeFromLeft(60));
+    morphButtons.removeFromLeft(4);
+    morphEnabledButton.setBounds(morphButtons);
+    morphSlider.setBounds(morphArea);
+
+    presetBrowser.setBounds(presetArea);
+
     auto responseArea = bounds.removeFromTop(int(bounds.getHeight() * 0.33f));
     responseCurveComponent.setBounds(responseArea);
 
+    auto matchArea = bounds.removeFromTop(28);
+    exportButton.setBounds(matchArea.removeFromRight(80).reduced(2));
+    matchEQPanel.setBounds(matchArea);
+
     bounds.removeFromTop(5);
 
+    // one enable toggle above each band's knobs, the cuts' type beside theirs
+    auto enableArea = bounds.removeFromTop(24);
+    auto lowCutEnableArea = enableArea.removeFromLeft(int(enableArea.getWidth() * 0.33f));
+    auto highCutEnableArea = enableArea.removeFromRight(int(enableArea.getWidth() * 0.5f));
+    lowCutEnabledButton.setBounds(lowCutEnableArea.removeFromLeft(int(lowCutEnableArea.getWidth() * 0.45f)).reduced(8, 0));
+    lowCutTypeBox.setBounds(lowCutEnableArea.reduced(4, 1));
+    highCutEnabledButton.setBounds(highCutEnableArea.removeFromLeft(int(highCutEnableArea.getWidth() * 0.45f)).reduced(8, 0));
+    highCutTypeBox.setBounds(highCutEnableArea.reduced(4, 1));
+    peakEnabledButton.setBounds(enableArea.reduced(8, 0));
+
     auto lowCutArea = bounds.removeFromLeft(int(bounds.getWidth() * 0.33f));
     lowCutFreqKnob.setBounds(lowCutArea.removeFromTop(int(lowCutArea.getHeight() * 0.5f)));
     lowCutSlopeKnob.setBounds(lowCutArea);
@@ -581,6 +1164,102 @@ void EQtutAudioProcessorEditor::resized()
     peakQualityKnob.setBounds(bounds);
 }
 
+void EQtutAudioProcessorEditor::showExportMenu()
+{
+    juce::PopupMenu lengths, rates, sizes;
+
+    for (auto length : { 4096, 16384, 65536, 262144 })
+        lengths.addItem(juce::String(length) + " samples", true, exportOptions.impulseLength == length,
+                        [this, length] { exportOptions.impulseLength = length; showExportMenu(); });
+
+    for (auto rate : { 44100.0, 48000.0, 88200.0, 96000.0, 192000.0 })
+        rates.addItem(juce::String(rate / 1000.0, 1) + " kHz", true, exportOptions.sampleRate == rate,
+                      [this, rate] { exportOptions.sampleRate = rate; showExportMenu(); });
+
+    for (auto size : { 1024, 4096, 65536, 1 << 20 })
+        sizes.addItem(juce::String(size) + " points", true, exportOptions.tableSize == size,
+                      [this, size] { exportOptions.tableSize = size; showExportMenu(); });
+
+    juce::PopupMenu offlineQualities;
+    for (auto quality : { OfflineQuality::Realtime, OfflineQuality::High, OfflineQuality::Maximum })
+        offlineQualities.addItem(getOfflineQualityName(quality), true, audioProcessor.getOfflineQuality() == quality,
+                                 [this, quality] { audioProcessor.setOfflineQuality(quality); });
+
+    juce::PopupMenu menu;
+    menu.addItem("Impulse Response (WAV)...", [this] { exportResponse(".wav"); });
+    menu.addItem("Response Table (CSV)...", [this] { exportResponse(".csv"); });
+    menu.addItem("Response Table (binary)...", [this] { exportResponse(".eqrt"); });
+    menu.addSeparator();
+    menu.addSubMenu("Impulse Length", lengths);
+    menu.addSubMenu("Sample Rate", rates);
+    menu.addSubMenu("Table Size", sizes);
+    menu.addSeparator();
+    menu.addSubMenu("Offline Bounce Quality", offlineQualities);
+    menu.addItem("Multirate Low Cut (latency above 88.2 kHz)", true, audioProcessor.getMultirateLowCut(),
+                 [this] { audioProcessor.setMultirateLowCut(!audioProcessor.getMultirateLowCut()); });
+    menu.addItem("Performance Trace (JSON)...", [this] { exportTrace(); });
+
+    menu.showMenuAsync(juce::PopupMenu::Options().withTargetComponent(&exportButton));
+}
+
+void EQtutAudioProcessorEditor::exportResponse(const juce::String& extension)
+{
+    auto defaultFile = juce::File::getSpecialLocation(juce::File::userDocumentsDirectory)
+        .getChildFile(juce::String(JucePlugin_Name) + " Response" + extension);
+
+    exportChooser = std::make_unique<juce::FileChooser>("Export response", defaultFile, "*" + extension);
+    exportChooser->launchAsync(juce::FileBrowserComponent::saveMode
+                               | juce::FileBrowserComponent::canSelectFiles
+                               | juce::FileBrowserComponent::warnAboutOverwriting,
+        [this, extension](const juce::FileChooser& fc)
+        {
+            auto file = fc.getResult();
+            if (file == juce::File())
+                return;
+
+            file = file.withFileExtension(extension);
+            const auto settings = audioProcessor.getCurrentChainSettings();
+
+            bool ok = false;
+            if (extension == ".wav")
+                ok = writeImpulseResponse(file, settings, exportOptions);
+            else
+                ok = writeResponseTable(file, settings, exportOptions,
+                                        extension == ".csv" ? ResponseTableFormat::CSV : ResponseTableFormat::Binary);
+
+            if (!ok)
+                juce::AlertWindow::showMessageBoxAsync(juce::MessageBoxIconType::WarningIcon, "Export failed",
+                                                       "Couldn't write " + file.getFullPathName());
+        });
+}
+
+void EQtutAudioProcessorEditor::exportTrace()
+{
+    // what the rings hold right now, the chooser may stay open for a while
+    juce::MemoryOutputStream trace;
+    TraceLog::getInstance().writeChromeTrace(trace);
+    auto data = std::make_shared<juce::MemoryBlock>(trace.getMemoryBlock());
+
+    auto defaultFile = juce::File::getSpecialLocation(juce::File::userDocumentsDirectory)
+        .getChildFile(juce::String(JucePlugin_Name) + " Trace.json");
+
+    exportChooser = std::make_unique<juce::FileChooser>("Save performance trace", defaultFile, "*.json");
+    exportChooser->launchAsync(juce::FileBrowserComponent::saveMode
+                               | juce::FileBrowserComponent::canSelectFiles
+                               | juce::FileBrowserComponent::warnAboutOverwriting,
+        [data](const juce::FileChooser& fc)
+        {
+            auto file = fc.getResult();
+            if (file == juce::File())
+                return;
+
+            file = file.withFileExtension(".json");
+            if (!file.replaceWithData(data->getData(), data->getSize()))
+                juce::AlertWindow::showMessageBoxAsync(juce::MessageBoxIconType::WarningIcon, "Export failed",
+                                                       "Couldn't write " + file.getFullPathName());
+        });
+}
+
 std::vector<juce::Component*> EQtutAudioProcessorEditor::getKnobs()
 {
     return
@@ -595,6 +1274,10 @@ std::vector<juce::Component*> EQtutAudioProcessorEditor::getKnobs()
         &highCutFreqKnob,
         &highCutSlopeKnob,
 
-        &responseCurveComponent
+        &responseCurveComponent,
+
+        &matchEQPanel,
+
+        &presetBrowser
     };
 }
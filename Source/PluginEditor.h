@@ -10,6 +10,10 @@
 
 #include <JuceHeader.h>
 #include "PluginProcessor.h"
+#include "MatchEQ.h"
+#include "ResponseExport.h"
+#include "AnalyzerService.h"
+#include <optional>
 
 enum FFTOrder
 {
@@ -24,7 +28,7 @@ struct FFTDataGenerator
     /**
      produces the FFT data from an audio buffer.
      */
-    void produceFFTDataForRendering(const juce::AudioBuffer<float>& audioData, const float negativeInfinity)
+    void produceFFTDataForRendering(const juce::AudioBuffer<float>& audioData, const float negativeInfinity, juce::int64 sourceTicks = 0)
     {
         const auto fftSize = getFFTSize();
 
@@ -33,10 +37,10 @@ struct FFTDataGenerator
         std::copy(readIndex, readIndex + fftSize, fftData.begin());
 
         // first apply a windowing function to our data
-        window->multiplyWithWindowingTable(fftData.data(), fftSize);       // [1]
+        plan->window.multiplyWithWindowingTable(fftData.data(), fftSize);       // [1]
 
         // then render our FFT data..
-        forwardFFT->performFrequencyOnlyForwardTransform(fftData.data());  // [2]
+        plan->fft.performFrequencyOnlyForwardTransform(fftData.data());  // [2]
 
         int numBins = (int)fftSize / 2;
 
@@ -59,46 +63,82 @@ struct FFTDataGenerator
         //convert them to decibels
         for (int i = 0; i < numBins; ++i)
         {
-            fftData[i] = juce::Decibels::gainToDecibels(fftData[i], negativeInfinity);
+            frame[i] = juce::Decibels::gainToDecibels(fftData[i], negativeInfinity);
         }
 
-        fftDataFifo.push(fftData);
+        // only the bins travel, fftData stays behind as the transform's 2 * fftSize work area
+        auto ok = fftDataFifo.push(frame, sourceTicks);
+
+        if (stats != nullptr)
+        {
+            stats->recordPush(AnalyzerStats::FFTQueue, ok);
+            stats->record(AnalyzerStats::FFTComplete, sourceTicks);
+        }
     }
 
-    void changeOrder(FFTOrder newOrder)
+    void changeOrder(FFTOrder newOrder, AnalyzerService& service)
     {
-        //when you change order, recreate the window, forwardFFT, fifo, fftData
+        //when you change order, pick up the shared window and FFT plan, recreate the fifo, fftData
         //also reset the fifoIndex
-        //things that need recreating should be created on the heap via std::make_unique<>
 
         order = newOrder;
         auto fftSize = getFFTSize();
 
-        forwardFFT = std::make_unique<juce::dsp::FFT>(order);
-        window = std::make_unique<juce::dsp::WindowingFunction<float>>(fftSize, juce::dsp::WindowingFunction<float>::blackmanHarris);
+        plan = &service.getPlan(order);
 
         fftData.clear();
         fftData.resize(fftSize * 2, 0);
 
-        fftDataFifo.prepare(fftData.size());
+        frame.clear();
+        frame.resize(fftSize / 2, 0);
+
+        fftDataFifo.prepare(frame.size());
     }
     //==============================================================================
     int getFFTSize() const { return 1 << order; }
     int getNumAvailableFFTDataBlocks() const { return fftDataFifo.getNumAvailableForReading(); }
     //==============================================================================
     bool getFFTData(BlockType& fftData) { return fftDataFifo.pull(fftData); }
+    bool getFFTData(BlockType& fftData, juce::int64& sourceTicks) { return fftDataFifo.pull(fftData, sourceTicks); }
+
+    void setStats(AnalyzerStats* statsToUse) { stats = statsToUse; }
 private:
+    AnalyzerStats* stats = nullptr;
+
     FFTOrder order;
     BlockType fftData;
-    std::unique_ptr<juce::dsp::FFT> forwardFFT;
-    std::unique_ptr<juce::dsp::WindowingFunction<float>> window;
+    BlockType frame;
+
+    // owned by the AnalyzerService, shared with every other generator of this size
+    const AnalyzerService::Plan* plan = nullptr;
 
-    Fifo<BlockType> fftDataFifo;
+    // PathProducer takes every frame as soon as it's made
+    Fifo<BlockType, 2> fftDataFifo;
 };
 
 template<typename PathType>
 struct AnalyzerPathGenerator
 {
+    /*
+     reserves room for a full spectrum in every path the generator and its fifo
+     cycle through. the paths are cleared and swapped, never rebuilt, so once
+     they're all prepared generating a path doesn't allocate.
+     */
+    void prepare(int fftSize)
+    {
+        // one startNewSubPath and a lineTo per drawn bin, 3 floats each
+        const auto numPathFloats = 3 * (fftSize / 2 / pathResolution + 2);
+
+        workingPath.clear();
+        workingPath.preallocateSpace(numPathFloats);
+
+        pathFifo.prepareSlots([numPathFloats](PathType& slot)
+            {
+                slot.clear();
+                slot.preallocateSpace(numPathFloats);
+            });
+    }
+
     /*
      converts 'renderData[]' into a juce::Path
      */
@@ -106,7 +146,8 @@ struct AnalyzerPathGenerator
         juce::Rectangle<float> fftBounds,
         int fftSize,
         float binWidth,
-        float negativeInfinity)
+        float negativeInfinity,
+        juce::int64 sourceTicks = 0)
     {
         auto top = fftBounds.getY();
         auto bottom = fftBounds.getHeight();
@@ -114,8 +155,9 @@ struct AnalyzerPathGenerator
 
         int numBins = (int)fftSize / 2;
 
-        PathType p;
-        p.preallocateSpace(3 * (int)fftBounds.getWidth());
+        // the path that came back from the fifo last time, storage and all
+        auto& p = workingPath;
+        p.clear();
 
         auto map = [bottom, top, negativeInfinity](float v)
             {
@@ -132,8 +174,6 @@ struct AnalyzerPathGenerator
 
         p.startNewSubPath(0, y);
 
-        const int pathResolution = 2; //you can draw line-to's every 'pathResolution' pixels.
-
         for (int binNum = 1; binNum < numBins; binNum += pathResolution)
         {
             y = map(renderData[binNum]);
@@ -149,7 +189,13 @@ struct AnalyzerPathGenerator
             }
         }
 
-        pathFifo.push(p);
+        auto ok = pathFifo.push(p, sourceTicks);
+
+        if (stats != nullptr)
+        {
+            stats->recordPush(AnalyzerStats::PathQueue, ok);
+            stats->record(AnalyzerStats::PathComplete, sourceTicks);
+        }
     }
 
     int getNumPathsAvailable() const
@@ -161,8 +207,22 @@ struct AnalyzerPathGenerator
     {
         return pathFifo.pull(path);
     }
+
+    bool getPath(PathType& path, juce::int64& sourceTicks)
+    {
+        return pathFifo.pull(path, sourceTicks);
+    }
+
+    void setStats(AnalyzerStats* statsToUse) { stats = statsToUse; }
 private:
-    Fifo<PathType> pathFifo;
+    static constexpr int pathResolution = 2; //you can draw line-to's every 'pathResolution' pixels.
+
+    AnalyzerStats* stats = nullptr;
+
+    PathType workingPath;
+
+    // only the newest path is ever drawn, older ones are skipped rather than copied
+    Fifo<PathType, 2, FifoPolicy::LatestOnly> pathFifo;
 };
 
 struct LookAndFeel : juce::LookAndFeel_V4
@@ -218,29 +278,64 @@ private:
 
 struct PathProducer
 {
-    PathProducer(SingleChannelSampleFifo<EQtutAudioProcessor::BlockType>& scsf) :
+    PathProducer(SingleChannelSampleFifo<EQtutAudioProcessor::BlockType>& scsf, AnalyzerService& service) :
         leftChannelFifo(&scsf)
     {
-        leftChannelFFTDataGenerator.changeOrder(FFTOrder::order2048);
+        leftChannelFFTDataGenerator.changeOrder(FFTOrder::order2048, service);
         monoBuffer.setSize(1, leftChannelFFTDataGenerator.getFFTSize());
+
+        // the fifos swap these with their slots, so they're kept at the slots' size
+        fftData.resize(size_t(leftChannelFFTDataGenerator.getFFTSize() / 2), 0);
+
+        pathProducer.prepare(leftChannelFFTDataGenerator.getFFTSize());
+        leftChannelFFTPath.preallocateSpace(3 * leftChannelFFTDataGenerator.getFFTSize() / 2);
+
+        leftChannelFFTDataGenerator.setStats(scsf.getStats());
+        pathProducer.setStats(scsf.getStats());
     }
+    // analyzer worker: turns the queued audio into the next path
     void process(juce::Rectangle<float> fftBounds, double sampleRate);
-    juce::Path getPath() { return leftChannelFFTPath; }
+
+    // analyzer worker: drops the queued audio while nothing is displayed
+    void discardPendingAudio();
+
+    // message thread: takes the newest path from the worker, returns false if there's none
+    bool updatePath();
+
+    const juce::Path& getPath() const { return leftChannelFFTPath; }
+
+    // call when the path is painted, records its latency the first time it's shown
+    void markPainted();
+
+    // every FFT frame is also added here while set, for the match EQ
+    void setSpectrumCapture(SpectrumAverage* average)
+    {
+        // once this returns the worker won't touch the old average again
+        const juce::SpinLock::ScopedLockType lock(captureLock);
+        spectrumCapture = average;
+    }
 
 private:
+    juce::SpinLock captureLock;
+    SpectrumAverage* spectrumCapture = nullptr;
+
     SingleChannelSampleFifo<EQtutAudioProcessor::BlockType>* leftChannelFifo;
+    juce::AudioBuffer<float> incomingBuffer;
     juce::AudioBuffer<float> monoBuffer;
+    std::vector<float> fftData;
 
     FFTDataGenerator<std::vector<float>> leftChannelFFTDataGenerator;
 
     AnalyzerPathGenerator<juce::Path> pathProducer;
 
     juce::Path leftChannelFFTPath;
+    juce::int64 pathTicks = 0;
+    bool pathPainted = true;
 };
 
 struct ResponseCurveComponent : juce::Component,
     juce::AudioProcessorParameter::Listener,
-    juce::Timer
+    AnalyzerService::Client
 {
 public:
     ResponseCurveComponent(EQtutAudioProcessor&);
@@ -249,14 +344,30 @@ public:
     void parameterValueChanged(int parameterIndex, float newValue) override;
     void parameterGestureChanged(int parameterIndex, bool gestureIsStarting) override { };
    
-    void timerCallback() override;
+    // analyzer worker
+    int useTimeSlice() override;
+
+    // message thread, from the service's display timer
+    void refreshAnalyzer() override;
+
+    // keeps the analyzer running without a window, for rendering into an image
+    void setRenderingOffscreen(bool shouldRenderOffscreen) { renderingOffscreen = shouldRenderOffscreen; }
 
     void paint(juce::Graphics& g) override;
     void resized() override;
 
+    // toggles the analyzer latency overlay
+    void mouseDoubleClick(const juce::MouseEvent&) override;
+
+    void setSpectrumCapture(SpectrumAverage* average);
+
+    // draws these settings instead of the parameters until called with nullptr
+    void setPreviewSettings(const ChainSettings* settings);
+
 private:
     EQtutAudioProcessor& audioProcessor;
     juce::Atomic<bool> parametersChanged{ false };
+    std::optional<ChainSettings> previewSettings;
     
     MonoChain monoChain;
     void updateChain();
@@ -266,7 +377,96 @@ private:
     juce::Rectangle<int> getRenderArea();
     juce::Rectangle<int> getAnalysisArea();
 
+    juce::SharedResourcePointer<AnalyzerService> analyzerService;
     PathProducer leftPathProducer, rightPathProducer;
+
+    // what the worker needs from the UI, updated on every refresh
+    juce::SpinLock analysisAreaLock;
+    juce::Rectangle<float> analysisArea;
+    std::atomic<bool> analyzerVisible{ false };
+    bool renderingOffscreen = false;
+
+    bool showStats = false;
+    void paintStats(juce::Graphics& g);
+};
+
+struct MatchEQPanel : juce::Component,
+    juce::Timer
+{
+public:
+    MatchEQPanel(EQtutAudioProcessor&, ResponseCurveComponent&);
+    ~MatchEQPanel() override;
+
+    void timerCallback() override;
+    void resized() override;
+
+private:
+    EQtutAudioProcessor& audioProcessor;
+    ResponseCurveComponent& responseCurve;
+
+    juce::TextButton captureSourceButton{ "Capture Source" };
+    juce::TextButton captureReferenceButton{ "Capture Ref" };
+    juce::TextButton loadReferenceButton{ "Load Ref..." };
+    juce::TextButton matchButton{ "Match" };
+    juce::Label status;
+
+    SpectrumAverage sourceCapture, referenceCapture;
+    SpectrumAverage* activeCapture = nullptr;
+    std::optional<MatchSpectrum> sourceDecibels, referenceDecibels;
+    juce::File referenceFile;
+    std::unique_ptr<juce::FileChooser> chooser;
+
+    MatchEQ matchEQ;
+
+    void toggleCapture(SpectrumAverage& average);
+    void stopCapture();
+    void startMatch();
+    void updateButtons();
+
+    // removes the current EQ curve from a spectrum captured at the output
+    MatchSpectrum getInputSpectrum(const SpectrumAverage& average);
+};
+
+struct LoudnessDisplay : juce::Component,
+    juce::Timer
+{
+public:
+    LoudnessDisplay(EQtutAudioProcessor&);
+
+    void timerCallback() override;
+    void paint(juce::Graphics& g) override;
+
+    // click to restart the integrated and true-peak measurement
+    void mouseDown(const juce::MouseEvent&) override;
+
+private:
+    EQtutAudioProcessor& audioProcessor;
+    LoudnessMeter::Readings readings;
+};
+
+struct PresetBrowser : juce::Component,
+    juce::ListBoxModel
+{
+public:
+    PresetBrowser(EQtutAudioProcessor&);
+
+    int getNumRows() override;
+    void paintListBoxItem(int rowNumber, juce::Graphics& g, int width, int height, bool rowIsSelected) override;
+    void listBoxItemClicked(int row, const juce::MouseEvent&) override;
+
+    void paint(juce::Graphics& g) override;
+    void resized() override;
+
+private:
+    EQtutAudioProcessor& audioProcessor;
+
+    juce::TextEditor searchBox;
+    juce::TextButton saveButton{ "Save" };
+    juce::ListBox presetList;
+
+    // bank indices of the presets currently listed
+    juce::Array<int> results;
+    void refreshResults();
 };
 
 //==============================================================================
@@ -296,6 +496,12 @@ private:
     // --- CREATE RESPONSE CURVE ---
     ResponseCurveComponent responseCurveComponent;
 
+    // --- CREATE MATCH EQ ---
+    MatchEQPanel matchEQPanel;
+
+    // --- CREATE PRESET BROWSER ---
+    PresetBrowser presetBrowser;
+
     // --- CREATE ATTACHMENTS ---
     using APVTS = juce::AudioProcessorValueTreeState;
     using Attachment = APVTS::SliderAttachment;
@@ -304,6 +510,41 @@ private:
     Attachment lowCutFreqKnobAtch, lowCutSlopeKnobAtch;
     Attachment highCutFreqKnobAtch, highCutSlopeKnobAtch;
 
+    // --- CREATE BAND ENABLES ---
+    juce::ToggleButton lowCutEnabledButton{ "Low Cut" }, peakEnabledButton{ "Peak" }, highCutEnabledButton{ "High Cut" };
+    APVTS::ButtonAttachment lowCutEnabledAtch, peakEnabledAtch, highCutEnabledAtch;
+
+    // --- CREATE CUT TYPES ---
+    // attached in the constructor body, once the boxes hold the parameter's choices
+    juce::ComboBox lowCutTypeBox, highCutTypeBox;
+    std::unique_ptr<APVTS::ComboBoxAttachment> lowCutTypeAtch, highCutTypeAtch;
+
+    // --- CREATE MORPH CONTROLS ---
+    juce::TextButton storeAButton{ "Store A" }, storeBButton{ "Store B" };
+    juce::ToggleButton morphEnabledButton{ "Morph" };
+    juce::Slider morphSlider;
+
+    Attachment morphSliderAtch;
+    APVTS::ButtonAttachment morphEnabledAtch;
+
+    // --- CREATE LOUDNESS DISPLAY ---
+    LoudnessDisplay loudnessDisplay;
+
+    // --- CREATE AUTO GAIN TOGGLE ---
+    juce::ToggleButton autoGainButton{ "Auto Gain" };
+    APVTS::ButtonAttachment autoGainAtch;
+
+    // --- CREATE RESPONSE EXPORT ---
+    juce::TextButton exportButton{ "Export..." };
+    ResponseExportOptions exportOptions;
+    std::unique_ptr<juce::FileChooser> exportChooser;
+
+    void showExportMenu();
+    void exportResponse(const juce::String& extension);
+
+    // snapshot of the trace rings, open in chrome://tracing or Perfetto
+    void exportTrace();
+
     std::vector<juce::Component*> getKnobs();
 
     JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (EQtutAudioProcessorEditor)
@@ -8,6 +8,7 @@
 
 #include "PluginProcessor.h"
 #include "PluginEditor.h"
+#include "Trace.h"
 
 //==============================================================================
 EQtutAudioProcessor::EQtutAudioProcessor()
@@ -22,6 +23,10 @@ EQtutAudioProcessor::EQtutAudioProcessor()
                        )
 #endif
 {
+   #if EQTUT_TRACING
+    // the trace rings are allocated with the log, here rather than on the audio thread's first marker
+    TraceLog::getInstance();
+   #endif
 }
 
 EQtutAudioProcessor::~EQtutAudioProcessor()
@@ -68,26 +73,65 @@ double EQtutAudioProcessor::getTailLengthSeconds() const
 
 int EQtutAudioProcessor::getNumPrograms()
 {
-    return 1;   // NB: some hosts don't cope very well if you tell them there are 0 programs,
-                // so this should be at least 1, even if you're not really implementing programs.
+    // NB: some hosts don't cope very well if you tell them there are 0 programs,
+    // so this should be at least 1, even if the preset bank is empty.
+    return juce::jmax(1, getPresetBank().getNumPresets());
 }
 
 int EQtutAudioProcessor::getCurrentProgram()
 {
-    return 0;
+    return currentProgram;
 }
 
 void EQtutAudioProcessor::setCurrentProgram (int index)
 {
+    auto& bank = getPresetBank();
+    if (!juce::isPositiveAndBelow(index, bank.getNumPresets()))
+        return;
+
+    beginStateRestore();
+    bank.recall(index);
+    endStateRestore();
+
+    currentProgram = index;
 }
 
 const juce::String EQtutAudioProcessor::getProgramName (int index)
 {
-    return {};
+    return getPresetBank().getName(index);
 }
 
 void EQtutAudioProcessor::changeProgramName (int index, const juce::String& newName)
 {
+    if (getPresetBank().rename(index, newName))
+        updateHostDisplay(juce::AudioProcessorListener::ChangeDetails().withProgramChanged(true));
+}
+
+PresetBank& EQtutAudioProcessor::getPresetBank()
+{
+    if (presetBank == nullptr)
+        presetBank = std::make_unique<PresetBank>(apvts, presetBankFile, getPresetParameterIDs());
+
+    return *presetBank;
+}
+
+void EQtutAudioProcessor::setPresetBankFile(const juce::File& file)
+{
+    presetBankFile = file;
+    presetBank.reset();
+    currentProgram = 0;
+}
+
+int EQtutAudioProcessor::savePreset(const juce::String& name)
+{
+    auto index = getPresetBank().save(name);
+    if (index >= 0)
+    {
+        currentProgram = index;
+        updateHostDisplay(juce::AudioProcessorListener::ChangeDetails().withProgramChanged(true));
+    }
+
+    return index;
 }
 
 //==============================================================================
@@ -96,26 +140,50 @@ void EQtutAudioProcessor::prepareToPlay (double sampleRate, int samplesPerBlock)
     // Use this method as the place to do any pre-playback
     // initialisation that you need..
 
-    // spec prepares filters before we use them
-    juce::dsp::ProcessSpec spec;
-    spec.maximumBlockSize = samplesPerBlock;
-    spec.numChannels = 1;
-    spec.sampleRate = sampleRate;
+    // every channel's filter state and the shared coefficients, contiguous
+    const auto numChannels = juce::jmax(1, getTotalNumOutputChannels());
+    arena.reset(FilterKernel::getRequiredBytes(numChannels) * 2 + DoubleFilterKernel::getRequiredBytes(numChannels) * 2
+              + Crossover::getRequiredBytes(numChannels) + MultirateLowCut::getRequiredBytes(numChannels));
+    filterKernel.prepare(arena, numChannels);
+    fadingKernel.prepare(arena, numChannels);
+    offlineKernel.prepare(arena, numChannels);
+    fadingOfflineKernel.prepare(arena, numChannels);
+    crossover.prepare(arena, numChannels, sampleRate);
+    renderingOffline = false;
+
+    multirateLowCut.prepare(arena, numChannels, sampleRate, samplesPerBlock);
+    multirateLowCut.setEnabled(multirateLowCutEnabled.load());
+    setLatencySamples(multirateLowCut.getLatencySamples());
+
+    fadeLength = juce::jmax(1, juce::roundToInt(sampleRate * 0.02));
+    fadeSamplesRemaining = 0;
+    switchPending = false;
+
+    // bypass starts where the parameter is, without a fade
+    bypassed = parameters.load(Param::Bypass) > 0.5f;
+    wetGain.reset(sampleRate, 0.02);
+    wetGain.setCurrentAndTargetValue(bypassed ? 0.f : 1.f);
+    dryBuffer.setSize(numChannels, samplesPerBlock);
 
-    // pass spec to left and right channel chains
-    leftChain.prepare(spec);
-    rightChain.prepare(spec);
+    outputGain.reset(sampleRate, 0.05);
+    outputGain.setCurrentAndTargetValue(1.f);
 
-    updateFilters();
+    appliedSampleRate = 0;
+    updateMorphTable();
+    updateFilters(loadBlockParameters());
 
-    leftChannelFifo.prepare(samplesPerBlock);
-    rightChannelFifo.prepare(samplesPerBlock);
+    // small host blocks are grouped, so the analyzer never sees more than ~240 buffers a second
+    analyzerBufferSize = juce::jmax(samplesPerBlock, (int)std::ceil(sampleRate / 240.0));
+    prepareAnalyzer();
+
+    loudnessMeter.prepare(sampleRate, getTotalNumOutputChannels());
 }
 
 void EQtutAudioProcessor::releaseResources()
 {
     // When playback stops, you can use this as an opportunity to free up any
     // spare memory, etc.
+    loudnessMeter.release();
 }
 
 #ifndef JucePlugin_PreferredChannelConfigurations
@@ -145,8 +213,40 @@ bool EQtutAudioProcessor::isBusesLayoutSupported (const BusesLayout& layouts) co
 #endif
 
 void EQtutAudioProcessor::processBlock (juce::AudioBuffer<float>& buffer, juce::MidiBuffer& midiMessages)
+{
+    EQTUT_TRACE_THREAD_NAME("Audio");
+    EQTUT_TRACE_SCOPE("processBlock");
+
+    processAudio(buffer, false);
+}
+
+void EQtutAudioProcessor::processBlockBypassed (juce::AudioBuffer<float>& buffer, juce::MidiBuffer&)
+{
+    EQTUT_TRACE_THREAD_NAME("Audio");
+    EQTUT_TRACE_SCOPE("processBlockBypassed");
+
+    processAudio(buffer, true);
+}
+
+EQtutAudioProcessor::BlockParameters EQtutAudioProcessor::loadBlockParameters() const
+{
+    BlockParameters blockParameters;
+
+    const auto generation = stateRestoreGeneration.load(std::memory_order_acquire);
+    blockParameters.values = parameters.load();
+    blockParameters.restoring = (generation & 1) != 0 || stateRestoreGeneration.load(std::memory_order_acquire) != generation;
+
+    return blockParameters;
+}
+
+void EQtutAudioProcessor::processAudio(juce::AudioBuffer<float>& buffer, bool hostBypassed)
 {
     juce::ScopedNoDenormals noDenormals;
+
+    // the one pass over the parameters this block, everything below reads from it
+    const auto blockParameters = loadBlockParameters();
+    const auto shouldBypass = hostBypassed || blockParameters.values[Param::Bypass] > 0.5f;
+
     auto totalNumInputChannels  = getTotalNumInputChannels();
     auto totalNumOutputChannels = getTotalNumOutputChannels();
 
@@ -159,21 +259,122 @@ void EQtutAudioProcessor::processBlock (juce::AudioBuffer<float>& buffer, juce::
     for (auto i = totalNumInputChannels; i < totalNumOutputChannels; ++i)
         buffer.clear (i, 0, buffer.getNumSamples());
 
-    updateFilters();
+    // the host already has the new latency, the filters start over with the low cut routed the new way
+    if (const auto multirate = multirateLowCutEnabled.load(std::memory_order_relaxed); multirate != multirateLowCut.isEnabled())
+    {
+        multirateLowCut.setEnabled(multirate);
+        filterKernel.reset();
+        fadeSamplesRemaining = 0;
+        switchPending = false;
+        appliedSampleRate = 0;
+        morphIndex = -1;
+    }
+
+    // delayed whether bypassed or not, so the reported latency always holds
+    multirateLowCut.process(buffer);
+
+    wetGain.setTargetValue(shouldBypass ? 0.f : 1.f);
+
+    if (!wetGain.isSmoothing() && wetGain.getTargetValue() == 0.f)
+    {
+        // fully bypassed, the input stays in place untouched
+        bypassed = true;
+    }
+    else
+    {
+        if (bypassed)
+            resumeFromBypass();
+
+        if (!wetGain.isSmoothing())
+        {
+            processEffect(buffer, blockParameters);
+        }
+        else
+        {
+            EQTUT_TRACE_SCOPE("bypass fade");
+
+            // the prepared size covers every well-behaved host, this only grows for the others
+            const auto numChannels = buffer.getNumChannels();
+            const auto numSamples = buffer.getNumSamples();
+            if (dryBuffer.getNumChannels() < numChannels || dryBuffer.getNumSamples() < numSamples)
+                dryBuffer.setSize(numChannels, numSamples, false, false, true);
+
+            for (int ch = 0; ch < numChannels; ++ch)
+                dryBuffer.copyFrom(ch, 0, buffer, ch, 0, numSamples);
 
-    // -- PROCESS --
-    juce::dsp::AudioBlock<float> block(buffer);
-    auto leftBlock = block.getSingleChannelBlock(0);
-    auto rightBlock = block.getSingleChannelBlock(1);
+            processEffect(buffer, blockParameters);
 
-    juce::dsp::ProcessContextReplacing<float> leftContext(leftBlock);
-    juce::dsp::ProcessContextReplacing<float> rightContext(rightBlock);
+            auto* const* wet = buffer.getArrayOfWritePointers();
+            auto* const* dry = dryBuffer.getArrayOfReadPointers();
+            for (int i = 0; i < numSamples; ++i)
+            {
+                const auto gain = wetGain.getNextValue();
+                for (int ch = 0; ch < numChannels; ++ch)
+                    wet[ch][i] = dry[ch][i] + gain * (wet[ch][i] - dry[ch][i]);
+            }
+        }
+    }
 
-    leftChain.process(leftContext);
-    rightChain.process(rightContext);
+    // nobody watches the analyzer while a bounce runs
+    if (!isNonRealtime())
+    {
+        EQTUT_TRACE_SCOPE("analyzer fifo push");
+        leftChannelFifo.update(buffer);
+        rightChannelFifo.update(buffer);
+    }
 
-    leftChannelFifo.update(buffer);
-    rightChannelFifo.update(buffer);
+    loudnessMeter.push(buffer);
+}
+
+void EQtutAudioProcessor::processEffect(juce::AudioBuffer<float>& buffer, const BlockParameters& blockParameters)
+{
+    // bounces get the double precision kernel unless the quality is set to match playback
+    const auto quality = offlineQuality.load(std::memory_order_relaxed);
+    const auto offline = isNonRealtime() && quality != OfflineQuality::Realtime;
+    if (offline != renderingOffline)
+        setRenderingOffline(offline);
+
+    if (offline)
+    {
+        EQTUT_TRACE_SCOPE("renderOffline");
+        renderOffline(buffer, quality, blockParameters);
+        applyCrossover(buffer, blockParameters);
+        applyOutputGain(buffer, blockParameters);
+    }
+    else
+    {
+        {
+            EQTUT_TRACE_SCOPE("updateFilters");
+            updateFilters(blockParameters);
+        }
+
+        // -- PROCESS --
+        {
+            EQTUT_TRACE_SCOPE("filter");
+            processFilters(buffer);
+        }
+
+        applyCrossover(buffer, blockParameters);
+        applyOutputGain(buffer, blockParameters);
+    }
+}
+
+void EQtutAudioProcessor::resumeFromBypass()
+{
+    // nothing ran while bypassed, so start from silence with a fresh design rather than stale state.
+    // the fade back in from the dry signal covers the filters settling
+    bypassed = false;
+
+    filterKernel.reset();
+    offlineKernel.reset();
+    crossover.reset();
+    multirateLowCut.reset();
+    fadeSamplesRemaining = 0;
+    switchPending = false;
+
+    appliedSampleRate = 0;
+    morphIndex = -1;
+    renderingOffline = false;
 }
 
 //==============================================================================
@@ -189,6 +390,9 @@ juce::AudioProcessorEditor* EQtutAudioProcessor::createEditor()
 }
 
 //==============================================================================
+static const juce::Identifier offlineQualityID{ "offlineQuality" };
+static const juce::Identifier multirateLowCutID{ "multirateLowCut" };
+
 void EQtutAudioProcessor::getStateInformation (juce::MemoryBlock& destData)
 {
     // You should use this method to store your parameters in the memory block.
@@ -205,24 +409,294 @@ void EQtutAudioProcessor::setStateInformation (const void* data, int sizeInBytes
     auto tree = juce::ValueTree::readFromData(data, sizeInBytes);
     if (tree.isValid())
     {
+        beginStateRestore();
         apvts.replaceState(tree);
-        updateFilters();
+        endStateRestore();
+
+        const auto quality = (int)apvts.state.getProperty(offlineQualityID, (int)OfflineQuality::High);
+        offlineQuality.store((OfflineQuality)juce::jlimit((int)OfflineQuality::Realtime, (int)OfflineQuality::Maximum, quality));
+
+        setMultirateLowCut((bool)apvts.state.getProperty(multirateLowCutID, false));
+    }
+}
+
+void EQtutAudioProcessor::setOfflineQuality(OfflineQuality quality)
+{
+    offlineQuality.store(quality);
+    apvts.state.setProperty(offlineQualityID, (int)quality, nullptr);
+}
+
+void EQtutAudioProcessor::setMultirateLowCut(bool shouldBeEnabled)
+{
+    multirateLowCutEnabled.store(shouldBeEnabled);
+    apvts.state.setProperty(multirateLowCutID, shouldBeEnabled, nullptr);
+
+    // reported straight away, the audio thread switches over on its next block
+    setLatencySamples(shouldBeEnabled ? MultirateLowCut::getLatencySamples(getSampleRate()) : 0);
+}
+
+void EQtutAudioProcessor::beginStateRestore()
+{
+    stateRestoreGeneration.fetch_add(1, std::memory_order_acq_rel);
+}
+
+void EQtutAudioProcessor::endStateRestore()
+{
+    // design the restored chain here and hand it to the audio thread in one piece
+    const auto sampleRate = getSampleRate();
+    if (sampleRate > 0)
+    {
+        restoredCoefficients.getWriteSlot() = makeChainCoefficients(getChainSettings(parameters.load()), sampleRate);
+        restoredCoefficients.publish();
     }
+
+    updateMorphTable();
+
+    stateRestoreGeneration.fetch_add(1, std::memory_order_acq_rel);
+}
+
+//==============================================================================
+static const juce::Identifier morphSnapshotsType{ "MorphSnapshots" };
+
+static juce::Identifier getMorphSlotType(MorphSlot slot)
+{
+    return slot == MorphA ? "A" : "B";
+}
+
+static juce::ValueTree chainSettingsToValueTree(const ChainSettings& settings, const juce::Identifier& type)
+{
+    juce::ValueTree tree(type);
+    tree.setProperty("peakFreq", settings.peakFreq, nullptr);
+    tree.setProperty("peakGainDB", settings.peakGainDB, nullptr);
+    tree.setProperty("peakQ", settings.peakQ, nullptr);
+    tree.setProperty("lowCutFreq", settings.lowCutFreq, nullptr);
+    tree.setProperty("lowCutSlope", int(settings.lowCutSlope), nullptr);
+    tree.setProperty("lowCutType", int(settings.lowCutType), nullptr);
+    tree.setProperty("highCutFreq", settings.highCutFreq, nullptr);
+    tree.setProperty("highCutSlope", int(settings.highCutSlope), nullptr);
+    tree.setProperty("highCutType", int(settings.highCutType), nullptr);
+    tree.setProperty("lowCutEnabled", settings.lowCutEnabled, nullptr);
+    tree.setProperty("peakEnabled", settings.peakEnabled, nullptr);
+    tree.setProperty("highCutEnabled", settings.highCutEnabled, nullptr);
+    return tree;
 }
 
-ChainSettings getChainSettings(juce::AudioProcessorValueTreeState& apvts)
+static ChainSettings chainSettingsFromValueTree(const juce::ValueTree& tree)
 {
     ChainSettings settings;
+    settings.peakFreq = tree.getProperty("peakFreq", 750.f);
+    settings.peakGainDB = tree.getProperty("peakGainDB", 0.f);
+    settings.peakQ = tree.getProperty("peakQ", 1.f);
+    settings.lowCutFreq = tree.getProperty("lowCutFreq", 20.f);
+    settings.lowCutSlope = static_cast<Slope>(juce::jlimit(0, numSlopes - 1, int(tree.getProperty("lowCutSlope", 0))));
+    settings.lowCutType = static_cast<CutType>(juce::jlimit(0, NumCutTypes - 1, int(tree.getProperty("lowCutType", 0))));
+    settings.highCutFreq = tree.getProperty("highCutFreq", 20000.f);
+    settings.highCutSlope = static_cast<Slope>(juce::jlimit(0, numSlopes - 1, int(tree.getProperty("highCutSlope", 0))));
+    settings.highCutType = static_cast<CutType>(juce::jlimit(0, NumCutTypes - 1, int(tree.getProperty("highCutType", 0))));
+    settings.lowCutEnabled = tree.getProperty("lowCutEnabled", true);
+    settings.peakEnabled = tree.getProperty("peakEnabled", true);
+    settings.highCutEnabled = tree.getProperty("highCutEnabled", true);
+    return settings;
+}
+
+void EQtutAudioProcessor::storeMorphSnapshot(MorphSlot slot)
+{
+    auto snapshots = apvts.state.getOrCreateChildWithName(morphSnapshotsType, nullptr);
+    const auto type = getMorphSlotType(slot);
+
+    snapshots.removeChild(snapshots.getChildWithName(type), nullptr);
+    snapshots.appendChild(chainSettingsToValueTree(getChainSettings(parameters.load()), type), nullptr);
 
-    settings.peakFreq = apvts.getRawParameterValue("Peak Freq")->load();
-    settings.peakGainDB = apvts.getRawParameterValue("Peak Gain")->load();
-    settings.peakQ = apvts.getRawParameterValue("Peak Q")->load();
+    updateMorphTable();
+}
+
+bool EQtutAudioProcessor::hasMorphSnapshots() const
+{
+    auto snapshots = apvts.state.getChildWithName(morphSnapshotsType);
+    return snapshots.getChildWithName(getMorphSlotType(MorphA)).isValid()
+        && snapshots.getChildWithName(getMorphSlotType(MorphB)).isValid();
+}
+
+ChainSettings EQtutAudioProcessor::getCurrentChainSettings()
+{
+    const auto snapshot = parameters.load();
+    if (snapshot[Param::MorphEnabled] < 0.5f || !hasMorphSnapshots())
+        return getChainSettings(snapshot);
+
+    // the audio thread runs the nearest cached position, show the same
+    auto snapshots = apvts.state.getChildWithName(morphSnapshotsType);
+    auto index = MorphTable::getIndex(snapshot[Param::Morph]);
+
+    return interpolateChainSettings(
+        chainSettingsFromValueTree(snapshots.getChildWithName(getMorphSlotType(MorphA))),
+        chainSettingsFromValueTree(snapshots.getChildWithName(getMorphSlotType(MorphB))),
+        MorphTable::getPosition(index));
+}
+
+void EQtutAudioProcessor::setChainSettings(const ChainSettings& chainSettings)
+{
+    auto set = [this](Param param, float value)
+        {
+            auto& parameter = parameters.getParameter(param);
+            parameter.beginChangeGesture();
+            parameter.setValueNotifyingHost(parameter.convertTo0to1(value));
+            parameter.endChangeGesture();
+        };
+
+    beginStateRestore();
+
+    set(Param::PeakFreq, chainSettings.peakFreq);
+    set(Param::PeakGain, chainSettings.peakGainDB);
+    set(Param::PeakQ, chainSettings.peakQ);
+    set(Param::LowCutFreq, chainSettings.lowCutFreq);
+    set(Param::LowCutSlope, float(chainSettings.lowCutSlope));
+    set(Param::LowCutType, float(chainSettings.lowCutType));
+    set(Param::HighCutFreq, chainSettings.highCutFreq);
+    set(Param::HighCutSlope, float(chainSettings.highCutSlope));
+    set(Param::HighCutType, float(chainSettings.highCutType));
+    set(Param::LowCutEnabled, chainSettings.lowCutEnabled ? 1.f : 0.f);
+    set(Param::PeakEnabled, chainSettings.peakEnabled ? 1.f : 0.f);
+    set(Param::HighCutEnabled, chainSettings.highCutEnabled ? 1.f : 0.f);
+
+    endStateRestore();
+}
+
+void EQtutAudioProcessor::updateMorphTable()
+{
+    // prepareToPlay and the message thread can both get here, the table has room for one writer
+    const juce::ScopedLock lock(morphTableWriteLock);
+
+    const auto sampleRate = getSampleRate();
+    const auto usable = hasMorphSnapshots() && sampleRate > 0;
+
+    ChainSettings a, b;
+    if (usable)
+    {
+        auto snapshots = apvts.state.getChildWithName(morphSnapshotsType);
+        a = chainSettingsFromValueTree(snapshots.getChildWithName(getMorphSlotType(MorphA)));
+        b = chainSettingsFromValueTree(snapshots.getChildWithName(getMorphSlotType(MorphB)));
+    }
+
+    // a program change or restore that leaves the snapshots alone keeps the published table
+    const auto tableSampleRate = usable ? sampleRate : 0.0;
+    if (tableSampleRate == morphTableSampleRate && a == morphTableA && b == morphTableB)
+        return;
+
+    auto& table = morphTables.getWriteSlot();
+    if (usable)
+        buildMorphTable(table, a, b, sampleRate);
+    else
+        table.sampleRate = 0;
+
+    morphTables.publish();
+
+    morphTableA = a;
+    morphTableB = b;
+    morphTableSampleRate = tableSampleRate;
+}
+
+const char* getParameterID(Param param)
+{
+    static constexpr const char* ids[] =
+    {
+        "LowCut Freq",
+        "HighCut Freq",
+        "Peak Freq",
+        "Peak Gain",
+        "Peak Q",
+        "LowCut Slope",
+        "HighCut Slope",
+        "Morph",
+        "Morph Enabled",
+        "Auto Gain",
+        "Crossover Bands",
+        "Crossover 1 Freq", "Crossover 2 Freq", "Crossover 3 Freq", "Crossover 4 Freq",
+        "Band 1 Gain", "Band 2 Gain", "Band 3 Gain", "Band 4 Gain", "Band 5 Gain",
+        "Band 1 Mute", "Band 2 Mute", "Band 3 Mute", "Band 4 Mute", "Band 5 Mute",
+        "Band 1 Solo", "Band 2 Solo", "Band 3 Solo", "Band 4 Solo", "Band 5 Solo",
+        "LowCut Enabled",
+        "Peak Enabled",
+        "HighCut Enabled",
+        "Bypass",
+        "LowCut Type",
+        "HighCut Type"
+    };
+    static_assert(std::size(ids) == numParams, "every Param needs an ID");
+
+    return ids[static_cast<size_t>(param)];
+}
+
+juce::StringArray getPresetParameterIDs()
+{
+    juce::StringArray ids;
+    for (auto param : { Param::LowCutFreq, Param::LowCutSlope, Param::LowCutType, Param::LowCutEnabled,
+                        Param::PeakFreq, Param::PeakGain, Param::PeakQ, Param::PeakEnabled,
+                        Param::HighCutFreq, Param::HighCutSlope, Param::HighCutType, Param::HighCutEnabled })
+        ids.add(getParameterID(param));
+
+    return ids;
+}
+
+ParameterRegistry::ParameterRegistry(juce::AudioProcessorValueTreeState& apvts)
+{
+    for (size_t i = 0; i < numParams; ++i)
+    {
+        auto id = getParameterID(static_cast<Param>(i));
+        values[i] = apvts.getRawParameterValue(id);
+        parameters[i] = apvts.getParameter(id);
+        jassert(values[i] != nullptr && parameters[i] != nullptr);
+    }
+}
+
+ParameterSnapshot ParameterRegistry::load() const
+{
+    ParameterSnapshot snapshot;
+    for (size_t i = 0; i < numParams; ++i)
+        snapshot.values[i] = values[i]->load(std::memory_order_acquire);
+
+    return snapshot;
+}
+
+ChainSettings getChainSettings(const ParameterSnapshot& parameters)
+{
+    ChainSettings settings;
+
+    settings.peakFreq = parameters[Param::PeakFreq];
+    settings.peakGainDB = parameters[Param::PeakGain];
+    settings.peakQ = parameters[Param::PeakQ];
     
-    settings.lowCutFreq = apvts.getRawParameterValue("LowCut Freq")->load();
-    settings.lowCutSlope = static_cast<Slope>(apvts.getRawParameterValue("LowCut Slope")->load());
+    settings.lowCutFreq = parameters[Param::LowCutFreq];
+    settings.lowCutSlope = static_cast<Slope>(parameters[Param::LowCutSlope]);
+    settings.lowCutType = static_cast<CutType>(parameters[Param::LowCutType]);
     
-    settings.highCutFreq = apvts.getRawParameterValue("HighCut Freq")->load();
-    settings.highCutSlope = static_cast<Slope>(apvts.getRawParameterValue("HighCut Slope")->load());
+    settings.highCutFreq = parameters[Param::HighCutFreq];
+    settings.highCutSlope = static_cast<Slope>(parameters[Param::HighCutSlope]);
+    settings.highCutType = static_cast<CutType>(parameters[Param::HighCutType]);
+
+    settings.lowCutEnabled = parameters[Param::LowCutEnabled] > 0.5f;
+    settings.peakEnabled = parameters[Param::PeakEnabled] > 0.5f;
+    settings.highCutEnabled = parameters[Param::HighCutEnabled] > 0.5f;
+
+    return settings;
+}
+
+CrossoverSettings getCrossoverSettings(const ParameterSnapshot& parameters)
+{
+    CrossoverSettings settings;
+
+    // choice 0 is "Off", then 2 - 5 bands
+    const auto choice = (int)parameters[Param::CrossoverBands];
+    settings.numBands = choice > 0 ? choice + 1 : 0;
+
+    for (int i = 0; i < CrossoverSettings::maxBands - 1; ++i)
+        settings.frequencies[(size_t)i] = parameters[getParam(Param::CrossoverFreq1, i)];
+
+    for (int band = 0; band < CrossoverSettings::maxBands; ++band)
+    {
+        settings.gainsDB[(size_t)band] = parameters[getParam(Param::BandGain1, band)];
+        settings.mute[(size_t)band] = parameters[getParam(Param::BandMute1, band)] > 0.5f;
+        settings.solo[(size_t)band] = parameters[getParam(Param::BandSolo1, band)] > 0.5f;
+    }
 
     return settings;
 }
@@ -237,47 +711,589 @@ Coefficients makePeakFilter(const ChainSettings& chainSettings, double sampleRat
     );
 }
 
+CutCoefficients makeCutCoefficients(bool highPass, float frequency, double sampleRate, Slope slope, CutType type)
+{
+    std::array<BiquadCoefficients, CutPrototype::maxSections> sections;
+    const auto numSections = slope + 1;
+    designCut(sections.data(), numSections, type, highPass, frequency, sampleRate);
+
+    CutCoefficients coefficients;
+    for (int i = 0; i < numSections; ++i)
+    {
+        const auto& s = sections[(size_t)i];
+        coefficients.add(new juce::dsp::IIR::Coefficients<float>(s.b0, s.b1, s.b2, 1.f, s.a1, s.a2));
+    }
+
+    return coefficients;
+}
+
 void updateCoefficients(Coefficients& old, const Coefficients& replacements)
 {
     *old = *replacements;
 }
 
-void EQtutAudioProcessor::updatePeakFilter(const ChainSettings &chainSettings)
+void updateCutFilter(CutFilter& filter, const CutCoefficients& coefficients)
+{
+    filter.numSections = juce::jmin(coefficients.size(), CutFilter::maxSections);
+
+    for (int i = 0; i < filter.numSections; ++i)
+        updateCoefficients(filter.filters[(size_t)i].coefficients, coefficients[i]);
+}
+
+ChainCoefficients makeChainCoefficients(const ChainSettings& chainSettings, double sampleRate)
+{
+    ChainCoefficients chainCoefficients;
+    chainCoefficients.settings = chainSettings;
+    chainCoefficients.sampleRate = sampleRate;
+
+    chainCoefficients.peak = makePeakFilter(chainSettings, sampleRate);
+    chainCoefficients.lowCut = makeLowCutFilter(chainSettings, sampleRate);
+    chainCoefficients.highCut = makeHighCutFilter(chainSettings, sampleRate);
+
+    return chainCoefficients;
+}
+
+void applyChainCoefficients(MonoChain& chain, const ChainCoefficients& chainCoefficients)
 {
-    auto peakCoefficients = makePeakFilter(chainSettings, getSampleRate());
-    updateCoefficients(leftChain.get<ChainPositions::Peak>().coefficients, peakCoefficients);
-    updateCoefficients(rightChain.get<ChainPositions::Peak>().coefficients, peakCoefficients);
+    const auto& settings = chainCoefficients.settings;
+
+    updateCutFilter(chain.get<ChainPositions::LowCut>(), chainCoefficients.lowCut);
+    updateCoefficients(chain.get<ChainPositions::Peak>().coefficients, chainCoefficients.peak);
+    updateCutFilter(chain.get<ChainPositions::HighCut>(), chainCoefficients.highCut);
+
+    chain.setBypassed<ChainPositions::LowCut>(!settings.lowCutEnabled);
+    chain.setBypassed<ChainPositions::Peak>(!settings.peakEnabled);
+    chain.setBypassed<ChainPositions::HighCut>(!settings.highCutEnabled);
 }
 
-void EQtutAudioProcessor::updateLowCutFilters(const ChainSettings& chainSettings)
+double getMagnitudeForFrequency(const ChainCoefficients& chainCoefficients, double frequency)
 {
-    auto lowCutCoefficients = makeLowCutFilter(chainSettings, getSampleRate());
+    const auto sampleRate = chainCoefficients.sampleRate;
+    const auto& settings = chainCoefficients.settings;
+
+    double mag = 1.0;
 
-    auto& leftLowCut = leftChain.get<ChainPositions::LowCut>();
-    updateCutFilter(leftLowCut, lowCutCoefficients, chainSettings.lowCutSlope);
+    if (settings.peakEnabled)
+        mag *= chainCoefficients.peak->getMagnitudeForFrequency(frequency, sampleRate);
 
-    auto& rightLowCut = rightChain.get<ChainPositions::LowCut>();
-    updateCutFilter(rightLowCut, lowCutCoefficients, chainSettings.lowCutSlope);
+    if (settings.lowCutEnabled)
+        for (int i = 0; i <= settings.lowCutSlope; ++i)
+            mag *= chainCoefficients.lowCut[i]->getMagnitudeForFrequency(frequency, sampleRate);
+
+    if (settings.highCutEnabled)
+        for (int i = 0; i <= settings.highCutSlope; ++i)
+            mag *= chainCoefficients.highCut[i]->getMagnitudeForFrequency(frequency, sampleRate);
+
+    return mag;
 }
 
-void EQtutAudioProcessor::updateHighCutFilters(const ChainSettings& chainSettings)
+double getPinkNoisePowerGain(const ChainCoefficients& chainCoefficients)
 {
-    auto highCutCoefficients = makeHighCutFilter(chainSettings, getSampleRate());
+    // pink noise has equal power per octave, so on a log-spaced grid every point weighs the same
+    constexpr int numPoints = 64;
+    const auto maxFrequency = juce::jmin(20000.0, chainCoefficients.sampleRate * 0.5 * 0.99);
 
-    auto& leftHighCut = leftChain.get<ChainPositions::HighCut>();
-    updateCutFilter(leftHighCut, highCutCoefficients, chainSettings.highCutSlope);
+    double sum = 0;
+    for (int i = 0; i < numPoints; ++i)
+    {
+        auto frequency = juce::mapToLog10(double(i) / double(numPoints - 1), 20.0, maxFrequency);
+        auto mag = getMagnitudeForFrequency(chainCoefficients, frequency);
+        sum += mag * mag;
+    }
 
-    auto& rightHighCut = rightChain.get<ChainPositions::HighCut>();
-    updateCutFilter(rightHighCut, highCutCoefficients, chainSettings.highCutSlope);
-} 
+    return juce::jmax(1.0e-6, sum / double(numPoints));
+}
 
-void EQtutAudioProcessor::updateFilters()
+ChainSettings interpolateChainSettings(const ChainSettings& from, const ChainSettings& to, float position)
 {
-    auto chainSettings = getChainSettings(apvts);
+    auto logLerp = [position](float a, float b)
+        {
+            return std::exp(juce::jmap(position, std::log(a), std::log(b)));
+        };
+
+    ChainSettings settings;
+    settings.peakFreq = logLerp(from.peakFreq, to.peakFreq);
+    settings.peakGainDB = juce::jmap(position, from.peakGainDB, to.peakGainDB);
+    settings.peakQ = logLerp(from.peakQ, to.peakQ);
+
+    settings.lowCutFreq = logLerp(from.lowCutFreq, to.lowCutFreq);
+    settings.lowCutSlope = position < 0.5f ? from.lowCutSlope : to.lowCutSlope;
+    settings.lowCutType = position < 0.5f ? from.lowCutType : to.lowCutType;
+
+    settings.highCutFreq = logLerp(from.highCutFreq, to.highCutFreq);
+    settings.highCutSlope = position < 0.5f ? from.highCutSlope : to.highCutSlope;
+    settings.highCutType = position < 0.5f ? from.highCutType : to.highCutType;
 
-    updateLowCutFilters(chainSettings);
-    updateHighCutFilters(chainSettings);
-    updatePeakFilter(chainSettings);
+    settings.lowCutEnabled = position < 0.5f ? from.lowCutEnabled : to.lowCutEnabled;
+    settings.peakEnabled = position < 0.5f ? from.peakEnabled : to.peakEnabled;
+    settings.highCutEnabled = position < 0.5f ? from.highCutEnabled : to.highCutEnabled;
+
+    return settings;
+}
+
+void buildMorphTable(MorphTable& table, const ChainSettings& from, const ChainSettings& to, double sampleRate)
+{
+    const bool lowCutMoves = from.lowCutFreq != to.lowCutFreq || from.lowCutSlope != to.lowCutSlope || from.lowCutType != to.lowCutType;
+    const bool peakMoves = from.peakFreq != to.peakFreq || from.peakGainDB != to.peakGainDB || from.peakQ != to.peakQ;
+    const bool highCutMoves = from.highCutFreq != to.highCutFreq || from.highCutSlope != to.highCutSlope || from.highCutType != to.highCutType;
+
+    const auto fixed = makeChainCoefficients(from, sampleRate);
+
+    table.sampleRate = sampleRate;
+    for (int i = 0; i < MorphTable::numPositions; ++i)
+    {
+        auto settings = interpolateChainSettings(from, to, MorphTable::getPosition(i));
+
+        auto& entry = table.positions[i];
+        entry.settings = settings;
+        entry.sampleRate = sampleRate;
+
+        entry.peak = peakMoves ? makePeakFilter(settings, sampleRate) : fixed.peak;
+        entry.lowCut = lowCutMoves ? makeLowCutFilter(settings, sampleRate) : fixed.lowCut;
+        entry.highCut = highCutMoves ? makeHighCutFilter(settings, sampleRate) : fixed.highCut;
+    }
+}
+
+void EQtutAudioProcessor::updateFilters(const BlockParameters& blockParameters)
+{
+    if (auto* table = morphTables.pull())
+    {
+        morphTable = table;
+        morphIndex = -1;
+    }
+
+    // a freshly restored state was designed off the audio thread, just swap it in
+    if (auto* restored = restoredCoefficients.pull())
+    {
+        if (restored->sampleRate == getSampleRate())
+        {
+            applyToFilters(*restored);
+            morphIndex = -1;
+            return;
+        }
+    }
+
+    // keep the current coefficients while a restore is rewriting the parameters
+    if (blockParameters.restoring)
+        return;
+
+    const auto& snapshot = blockParameters.values;
+
+    // morphing only swaps in designs cached at quantized positions
+    if (snapshot[Param::MorphEnabled] > 0.5f && morphTable != nullptr && morphTable->isValidFor(getSampleRate()))
+    {
+        const auto index = MorphTable::getIndex(snapshot[Param::Morph]);
+        if (index != morphIndex)
+        {
+            applyToFilters(morphTable->positions[index]);
+            morphIndex = index;
+        }
+        return;
+    }
+
+    morphIndex = -1;
+
+    auto chainSettings = getChainSettings(snapshot);
+    if (chainSettings != appliedSettings || appliedSampleRate != getSampleRate())
+        designFilters(chainSettings);
+}
+
+void EQtutAudioProcessor::setRenderingOffline(bool shouldRenderOffline)
+{
+    renderingOffline = shouldRenderOffline;
+
+    if (renderingOffline)
+    {
+        // continue from exactly what the realtime kernel was running
+        offlineSettings = appliedSettings;
+
+        DoubleKernelCoefficients designed;
+        designDoubleKernel(designed, offlineSettings, getSampleRate());
+        offlineKernel.setCoefficients(designed);
+        offlineKernel.takeStateFrom(filterKernel);
+        kernelLowCutType = offlineSettings.lowCutType;
+        kernelHighCutType = offlineSettings.highCutType;
+
+        // sections the realtime kernel skipped, a decimated low cut's for one, start from silence
+        if (const auto* running = filterKernel.getCoefficients())
+            offlineKernel.resetSections(designed.activeMask & ~running->getProcessedMask());
+
+        // the double kernel fades its own changes from here on, a realtime fade ends here
+        fadeSamplesRemaining = 0;
+        switchPending = false;
+
+        // and it runs the low cut at the full rate, only the delay keeps going
+        multirateLowCut.disengage();
+    }
+    else
+    {
+        // the realtime kernel picks up the state and redesigns from the parameters in this block
+        offlineKernel.giveStateTo(filterKernel);
+        fadeSamplesRemaining = 0;
+        switchPending = false;
+        appliedSampleRate = 0;
+        morphIndex = -1;
+    }
+}
+
+void EQtutAudioProcessor::renderOffline(juce::AudioBuffer<float>& buffer, OfflineQuality quality, const BlockParameters& blockParameters)
+{
+    const auto sampleRate = getSampleRate();
+
+    if (auto* table = morphTables.pull())
+    {
+        morphTable = table;
+        morphIndex = -1;
+    }
+
+    // the same sources updateFilters() reads, but the morph isn't quantized to the table
+    auto from = offlineSettings;
+    auto to = from;
+
+    if (auto* restored = restoredCoefficients.pull(); restored != nullptr && restored->sampleRate == sampleRate)
+    {
+        // a restore is a jump, not a move
+        from = to = restored->settings;
+    }
+    else if (!blockParameters.restoring)
+    {
+        const auto& snapshot = blockParameters.values;
+
+        if (snapshot[Param::MorphEnabled] > 0.5f && morphTable != nullptr && morphTable->isValidFor(sampleRate))
+            to = interpolateChainSettings(morphTable->positions.front().settings, morphTable->positions.back().settings,
+                                          juce::jlimit(0.f, 1.f, snapshot[Param::Morph]));
+        else
+            to = getChainSettings(snapshot);
+    }
+
+    const auto numSamples = buffer.getNumSamples();
+    const auto numChannels = juce::jmin(buffer.getNumChannels(), offlineKernel.getNumChannels());
+    auto* const* channels = buffer.getArrayOfWritePointers();
+
+    if (to == offlineSettings)
+    {
+        processOfflineFilters(channels, numChannels, 0, numSamples);
+        return;
+    }
+
+    DoubleKernelCoefficients designed;
+
+    if (from == to || numSamples == 0)
+    {
+        designDoubleKernel(designed, to, sampleRate);
+        switchOfflineCoefficients(designed, to);
+        processOfflineFilters(channels, numChannels, 0, numSamples);
+    }
+    else
+    {
+        // a new design every sub-block, following the move from the last block's settings to this one's
+        const auto subBlockSize = juce::jmax(1, getOfflineSubBlockSize(quality));
+
+        for (int start = 0; start < numSamples; start += subBlockSize)
+        {
+            const auto length = juce::jmin(subBlockSize, numSamples - start);
+            const auto end = start + length;
+
+            const auto settings = end == numSamples ? to : interpolateChainSettings(from, to, float(end) / float(numSamples));
+            designDoubleKernel(designed, settings, sampleRate);
+            switchOfflineCoefficients(designed, settings);
+            processOfflineFilters(channels, numChannels, start, length);
+        }
+    }
+
+    offlineSettings = to;
+
+    auto compensation = 1.0 / std::sqrt(getPinkNoisePowerGain(designed, sampleRate));
+    autoGainCompensation = float(juce::jlimit(0.0625, 16.0, compensation));
+}
+
+void EQtutAudioProcessor::applyToFilters(const ChainCoefficients& chainCoefficients)
+{
+    KernelCoefficients designed;
+    makeKernelCoefficients(designed, chainCoefficients);
+    routeLowCut(designed, chainCoefficients.settings);
+    switchCoefficients(designed, chainCoefficients.settings);
+
+    appliedSettings = chainCoefficients.settings;
+    appliedSampleRate = chainCoefficients.sampleRate;
+
+    auto compensation = 1.0 / std::sqrt(getPinkNoisePowerGain(chainCoefficients));
+    autoGainCompensation = float(juce::jlimit(0.0625, 16.0, compensation));
+}
+
+void EQtutAudioProcessor::designFilters(const ChainSettings& chainSettings)
+{
+    // designed on the stack, nothing allocates on the audio thread
+    KernelCoefficients designed;
+    designKernelCoefficients(designed, chainSettings, getSampleRate());
+
+    // before the low cut is routed away, auto gain hears it wherever it runs
+    auto compensation = 1.0 / std::sqrt(getPinkNoisePowerGain(designed, getSampleRate()));
+    autoGainCompensation = float(juce::jlimit(0.0625, 16.0, compensation));
+
+    routeLowCut(designed, chainSettings);
+    switchCoefficients(designed, chainSettings);
+
+    appliedSettings = chainSettings;
+    appliedSampleRate = getSampleRate();
+}
+
+void EQtutAudioProcessor::routeLowCut(KernelCoefficients& designed, const ChainSettings& chainSettings)
+{
+    // fades under the same condition as switchCoefficients(), whose crossfade hands the cut over
+    const auto fade = appliedSampleRate == getSampleRate();
+    const auto numSections = chainSettings.lowCutEnabled ? chainSettings.lowCutSlope + 1 : 0;
+
+    if (multirateLowCut.setCut(numSections, chainSettings.lowCutType, chainSettings.lowCutFreq, fade))
+        designed.activeMask &= ~KernelCoefficients::lowCutMask;
+}
+
+juce::uint32 EQtutAudioProcessor::getRetypedSections(const ChainSettings& chainSettings) const
+{
+    // a cut of another family at the same slope runs the same sections, but their state means nothing to the new ones
+    juce::uint32 retypedMask = 0;
+    if (chainSettings.lowCutType != kernelLowCutType)
+        retypedMask |= KernelCoefficients::lowCutMask;
+    if (chainSettings.highCutType != kernelHighCutType)
+        retypedMask |= KernelCoefficients::highCutMask;
+
+    return retypedMask;
+}
+
+void EQtutAudioProcessor::switchCoefficients(const KernelCoefficients& designed, const ChainSettings& chainSettings)
+{
+    const auto* running = filterKernel.getCoefficients();
+    if (running == nullptr)
+        return;
+
+    const auto previousMask = running->getProcessedMask();
+    const auto designedMask = designed.getProcessedMask();
+
+    const auto retypedMask = getRetypedSections(chainSettings) & designedMask;
+
+    // nothing is running yet after prepareToPlay, a sample rate change or an offline render
+    const auto fade = appliedSampleRate == getSampleRate() && (designedMask != previousMask || retypedMask != 0);
+
+    // one that arrives during a fade waits for it to end, restarting from the new cascade would jump out of the mix.
+    // processFilters() switches to the latest one waiting as soon as the fade is over
+    if (fade && fadeSamplesRemaining > 0)
+    {
+        pendingCoefficients = designed;
+        pendingSettings = chainSettings;
+        switchPending = true;
+        return;
+    }
+
+    switchPending = false;
+    kernelLowCutType = chainSettings.lowCutType;
+    kernelHighCutType = chainSettings.highCutType;
+
+    if (fade)
+    {
+        fadingKernel.copyFrom(filterKernel);
+        fadeSamplesRemaining = fadeLength;
+    }
+
+    filterKernel.setCoefficients(designed);
+
+    // sections coming back in, or switching family, start from silence rather than whatever they held
+    if (fade)
+        filterKernel.resetSections((designedMask & ~previousMask) | retypedMask);
+}
+
+// both cascades run over the fade, a chunk at a time so the old one's output fits on the stack
+template<typename Kernel>
+static void processCrossfade(Kernel& kernel, Kernel& fading, float* samples, int numSamples, int channel, int fadePosition, int fadeLength)
+{
+    constexpr int chunkSize = 64;
+
+    for (int start = 0; start < numSamples; start += chunkSize)
+    {
+        const auto length = juce::jmin(chunkSize, numSamples - start);
+        float previous[chunkSize];
+        std::copy(samples + start, samples + start + length, previous);
+
+        fading.process(previous, length, channel);
+        kernel.process(samples + start, length, channel);
+
+        for (int i = 0; i < length; ++i)
+        {
+            const auto gain = float(fadePosition + start + i + 1) / float(fadeLength);
+            samples[start + i] = previous[i] + gain * (samples[start + i] - previous[i]);
+        }
+    }
+}
+
+void EQtutAudioProcessor::processFilters(juce::AudioBuffer<float>& buffer)
+{
+    const auto numChannels = juce::jmin(buffer.getNumChannels(), filterKernel.getNumChannels());
+    const auto numSamples = buffer.getNumSamples();
+
+    // a decimated low cut goes first, it ramps its own band in and out
+    multirateLowCut.subtractLowBand(buffer);
+
+    if (fadeSamplesRemaining == 0)
+    {
+        for (int ch = 0; ch < numChannels; ++ch)
+            filterKernel.process(buffer.getWritePointer(ch), numSamples, ch);
+        return;
+    }
+
+    const auto fadeSamples = juce::jmin(numSamples, fadeSamplesRemaining);
+    const auto fadePosition = fadeLength - fadeSamplesRemaining;
+
+    for (int ch = 0; ch < numChannels; ++ch)
+    {
+        auto* samples = buffer.getWritePointer(ch);
+        processCrossfade(filterKernel, fadingKernel, samples, fadeSamples, ch, fadePosition, fadeLength);
+        filterKernel.process(samples + fadeSamples, numSamples - fadeSamples, ch);
+    }
+
+    fadeSamplesRemaining -= fadeSamples;
+
+    if (fadeSamplesRemaining == 0 && switchPending)
+        switchCoefficients(pendingCoefficients, pendingSettings);
+}
+
+void EQtutAudioProcessor::switchOfflineCoefficients(const DoubleKernelCoefficients& designed, const ChainSettings& chainSettings)
+{
+    const auto* running = offlineKernel.getCoefficients();
+    if (running == nullptr)
+        return;
+
+    // the same handover as switchCoefficients(), so a bounce doesn't click where playback doesn't
+    const auto previousMask = running->activeMask;
+    const auto retypedMask = getRetypedSections(chainSettings) & designed.activeMask;
+    const auto fade = designed.activeMask != previousMask || retypedMask != 0;
+
+    // redesigned from the settings once the running fade is over
+    if (fade && fadeSamplesRemaining > 0)
+    {
+        pendingSettings = chainSettings;
+        switchPending = true;
+        return;
+    }
+
+    switchPending = false;
+    kernelLowCutType = chainSettings.lowCutType;
+    kernelHighCutType = chainSettings.highCutType;
+
+    if (fade)
+    {
+        fadingOfflineKernel.copyFrom(offlineKernel);
+        fadeSamplesRemaining = fadeLength;
+    }
+
+    offlineKernel.setCoefficients(designed);
+
+    if (fade)
+        offlineKernel.resetSections((designed.activeMask & ~previousMask) | retypedMask);
+}
+
+void EQtutAudioProcessor::processOfflineFilters(float* const* channels, int numChannels, int start, int numSamples)
+{
+    const auto fadeSamples = juce::jmin(numSamples, fadeSamplesRemaining);
+    const auto fadePosition = fadeLength - fadeSamplesRemaining;
+
+    for (int ch = 0; ch < numChannels; ++ch)
+    {
+        auto* samples = channels[ch] + start;
+
+        if (fadeSamples > 0)
+            processCrossfade(offlineKernel, fadingOfflineKernel, samples, fadeSamples, ch, fadePosition, fadeLength);
+
+        offlineKernel.process(samples + fadeSamples, numSamples - fadeSamples, ch);
+    }
+
+    fadeSamplesRemaining -= fadeSamples;
+
+    if (fadeSamples > 0 && fadeSamplesRemaining == 0 && switchPending)
+    {
+        DoubleKernelCoefficients designed;
+        designDoubleKernel(designed, pendingSettings, getSampleRate());
+        switchOfflineCoefficients(designed, pendingSettings);
+    }
+}
+
+void EQtutAudioProcessor::setAnalyzerActive(bool shouldBeActive)
+{
+    analyzerActive = shouldBeActive;
+    prepareAnalyzer();
+}
+
+void EQtutAudioProcessor::prepareAnalyzer()
+{
+    if (analyzerActive && analyzerBufferSize > 0)
+    {
+        leftChannelFifo.prepare(analyzerBufferSize);
+        rightChannelFifo.prepare(analyzerBufferSize);
+    }
+    else
+    {
+        leftChannelFifo.release();
+        rightChannelFifo.release();
+    }
+}
+
+juce::StringArray EQtutAudioProcessor::getMemoryReport() const
+{
+    auto kilobytes = [](size_t bytes) { return juce::String(double(bytes) / 1024.0, 1) + " KB"; };
+
+    // heap objects of a designed chain: one Coefficients per section, each with its own array
+    constexpr size_t sectionBytes = sizeof(juce::dsp::IIR::Coefficients<float>) + 5 * sizeof(float);
+    constexpr size_t designBytes = KernelCoefficients::maxSections * sectionBytes;
+
+    const auto processorBytes = sizeof(*this);
+    const auto arenaBytes = arena.getCapacity();
+    const auto analyzerBytes = leftChannelFifo.getMemoryUsage() + rightChannelFifo.getMemoryUsage();
+    const auto loudnessBytes = loudnessMeter.getMemoryUsage();
+    const auto morphBytes = 3 * (sizeof(MorphTable) + MorphTable::numPositions * designBytes);
+    const auto parameterBytes = (size_t)getParameters().size() * sizeof(juce::AudioParameterFloat);
+
+    juce::StringArray lines;
+    lines.add("processor      " + kilobytes(processorBytes));
+    lines.add("dsp arena      " + kilobytes(arenaBytes) + " (" + juce::String((int)arena.getBytesUsed()) + " bytes used)");
+    lines.add("analyzer fifos " + kilobytes(analyzerBytes));
+    lines.add("loudness meter " + kilobytes(loudnessBytes));
+    lines.add("morph designs  " + kilobytes(morphBytes) + " (upper bound)");
+    lines.add("parameters     " + kilobytes(parameterBytes));
+    lines.add("total          " + kilobytes(processorBytes + arenaBytes + analyzerBytes + loudnessBytes + morphBytes + parameterBytes));
+    return lines;
+}
+
+void EQtutAudioProcessor::applyCrossover(juce::AudioBuffer<float>& buffer, const BlockParameters& blockParameters)
+{
+    // like the filters, the split holds still while a restore is rewriting the parameters
+    if (!blockParameters.restoring)
+        crossover.setSettings(getCrossoverSettings(blockParameters.values));
+
+    EQTUT_TRACE_SCOPE("crossover");
+    crossover.process(buffer);
+}
+
+void EQtutAudioProcessor::applyOutputGain(juce::AudioBuffer<float>& buffer, const BlockParameters& blockParameters)
+{
+    outputGain.setTargetValue(blockParameters.values[Param::AutoGain] > 0.5f ? autoGainCompensation : 1.f);
+
+    const auto numSamples = buffer.getNumSamples();
+    const auto numChannels = buffer.getNumChannels();
+
+    if (!outputGain.isSmoothing())
+    {
+        const auto gain = outputGain.getTargetValue();
+        if (gain != 1.f)
+            buffer.applyGain(gain);
+        return;
+    }
+
+    // one pass over the block, the ramp is shared by every channel
+    auto* const* channels = buffer.getArrayOfWritePointers();
+    for (int i = 0; i < numSamples; ++i)
+    {
+        const auto gain = outputGain.getNextValue();
+        for (int ch = 0; ch < numChannels; ++ch)
+            channels[ch][i] *= gain;
+    }
 }
 
 juce::AudioProcessorValueTreeState::ParameterLayout
@@ -289,31 +1305,31 @@ juce::AudioProcessorValueTreeState::ParameterLayout
 
     // low cut frequency slider
     auto lowFreqRange = juce::NormalisableRange<float>(20.f, 20000.f, 1.f, 0.3f);
-    layout.add(std::make_unique<juce::AudioParameterFloat>("LowCut Freq", "LowCut Freq", lowFreqRange, 20.f));
+    layout.add(std::make_unique<juce::AudioParameterFloat>(getParameterID(Param::LowCutFreq), getParameterID(Param::LowCutFreq), lowFreqRange, 20.f));
 
     // high cut frequency slider
     auto highFreqRange = juce::NormalisableRange<float>(20.f, 20000.f, 1.f, 1.f);
-    layout.add(std::make_unique<juce::AudioParameterFloat>("HighCut Freq", "HighCut Freq", highFreqRange, 20000.f));
+    layout.add(std::make_unique<juce::AudioParameterFloat>(getParameterID(Param::HighCutFreq), getParameterID(Param::HighCutFreq), highFreqRange, 20000.f));
 
     //--- PEAK FREQ, GAIN, Q SELECTOR ---
 
     // peak frequency slider
     auto peakFreqRange = juce::NormalisableRange<float>(20.f, 20000.f, 1.f, 0.3f);
-    layout.add(std::make_unique<juce::AudioParameterFloat>("Peak Freq", "Peak Freq", peakFreqRange, 750.f));
+    layout.add(std::make_unique<juce::AudioParameterFloat>(getParameterID(Param::PeakFreq), getParameterID(Param::PeakFreq), peakFreqRange, 750.f));
 
     // peak gain slider
     auto peakGainRange = juce::NormalisableRange<float>(-24.f, 24.f, 0.5f, 1.f);
-    layout.add(std::make_unique<juce::AudioParameterFloat>("Peak Gain", "Peak Gain", peakGainRange, 0.0f));
+    layout.add(std::make_unique<juce::AudioParameterFloat>(getParameterID(Param::PeakGain), getParameterID(Param::PeakGain), peakGainRange, 0.0f));
 
     // peak q slider
     auto peakQRange = juce::NormalisableRange<float>(0.1f, 10.f, 0.05f, 1.f);
-    layout.add(std::make_unique<juce::AudioParameterFloat>("Peak Q", "Peak Q", peakQRange, 1.f));
+    layout.add(std::make_unique<juce::AudioParameterFloat>(getParameterID(Param::PeakQ), getParameterID(Param::PeakQ), peakQRange, 1.f));
 
     //--- CUT SLOPE SELECTORS ---
     
     // define cut slope choices
     juce::StringArray stringArray;
-    for (int i = 0; i < 4; ++i)
+    for (int i = 0; i < numSlopes; ++i)
     {
         juce::String str;
         str << (12 + i * 12);
@@ -322,10 +1338,77 @@ juce::AudioProcessorValueTreeState::ParameterLayout
     }
 
     // add low cut slope selector
-    layout.add(std::make_unique<juce::AudioParameterChoice>("LowCut Slope", "LowCut Slope", stringArray, 0));
+    layout.add(std::make_unique<juce::AudioParameterChoice>(getParameterID(Param::LowCutSlope), getParameterID(Param::LowCutSlope), stringArray, 0));
 
     // add high cut slope selector
-    layout.add(std::make_unique<juce::AudioParameterChoice>("HighCut Slope", "HighCut Slope", stringArray, 0));
+    layout.add(std::make_unique<juce::AudioParameterChoice>(getParameterID(Param::HighCutSlope), getParameterID(Param::HighCutSlope), stringArray, 0));
+
+    //--- PRESET MORPH ---
+
+    // position between snapshot A and B
+    layout.add(std::make_unique<juce::AudioParameterFloat>(getParameterID(Param::Morph), getParameterID(Param::Morph), juce::NormalisableRange<float>(0.f, 1.f, 0.001f, 1.f), 0.f));
+
+    // run the morphed snapshots instead of the knobs
+    layout.add(std::make_unique<juce::AudioParameterBool>(getParameterID(Param::MorphEnabled), getParameterID(Param::MorphEnabled), false));
+
+    //--- AUTO GAIN ---
+
+    // compensate the loudness change of the current response
+    layout.add(std::make_unique<juce::AudioParameterBool>(getParameterID(Param::AutoGain), getParameterID(Param::AutoGain), false));
+
+    //--- CROSSOVER ---
+
+    juce::StringArray bandChoices{ "Off" };
+    for (int bands = 2; bands <= CrossoverSettings::maxBands; ++bands)
+        bandChoices.add(juce::String(bands) + " Bands");
+
+    layout.add(std::make_unique<juce::AudioParameterChoice>(getParameterID(Param::CrossoverBands), getParameterID(Param::CrossoverBands), bandChoices, 0));
+
+    // split points, spread over the spectrum by default
+    const float defaultPoints[] = { 120.f, 600.f, 2500.f, 8000.f };
+    for (int i = 0; i < CrossoverSettings::maxBands - 1; ++i)
+    {
+        auto id = getParameterID(getParam(Param::CrossoverFreq1, i));
+        layout.add(std::make_unique<juce::AudioParameterFloat>(id, id, juce::NormalisableRange<float>(20.f, 20000.f, 1.f, 0.3f), defaultPoints[i]));
+    }
+
+    // per band level, mute and solo
+    for (int band = 0; band < CrossoverSettings::maxBands; ++band)
+    {
+        auto id = getParameterID(getParam(Param::BandGain1, band));
+        layout.add(std::make_unique<juce::AudioParameterFloat>(id, id, juce::NormalisableRange<float>(-24.f, 24.f, 0.5f, 1.f), 0.f));
+    }
+
+    for (int band = 0; band < CrossoverSettings::maxBands; ++band)
+    {
+        auto id = getParameterID(getParam(Param::BandMute1, band));
+        layout.add(std::make_unique<juce::AudioParameterBool>(id, id, false));
+    }
+
+    for (int band = 0; band < CrossoverSettings::maxBands; ++band)
+    {
+        auto id = getParameterID(getParam(Param::BandSolo1, band));
+        layout.add(std::make_unique<juce::AudioParameterBool>(id, id, false));
+    }
+
+    //--- BAND ENABLES AND BYPASS ---
+
+    // a disabled band is taken out of the processing, not just set flat
+    for (auto param : { Param::LowCutEnabled, Param::PeakEnabled, Param::HighCutEnabled })
+        layout.add(std::make_unique<juce::AudioParameterBool>(getParameterID(param), getParameterID(param), true));
+
+    // also what getBypassParameter() hands the host
+    layout.add(std::make_unique<juce::AudioParameterBool>(getParameterID(Param::Bypass), getParameterID(Param::Bypass), false));
+
+    //--- CUT TYPES ---
+
+    // the response family of each cut, every one of them at every slope
+    juce::StringArray cutTypes;
+    for (int type = 0; type < NumCutTypes; ++type)
+        cutTypes.add(getCutTypeName(static_cast<CutType>(type)));
+
+    for (auto param : { Param::LowCutType, Param::HighCutType })
+        layout.add(std::make_unique<juce::AudioParameterChoice>(getParameterID(param), getParameterID(param), cutTypes, 0));
 
     return layout;
 }
@@ -9,69 +9,241 @@
 #pragma once
 
 #include <JuceHeader.h>
+#include "PresetBank.h"
+#include "LoudnessMeter.h"
+#include "AnalyzerStats.h"
+#include "FilterKernel.h"
+#include "CutDesign.h"
+#include "OfflineRender.h"
+#include "Crossover.h"
+#include "MultirateLowCut.h"
 #include <array> // req. to implement Fifo class
+#include <atomic>
+#include <thread>
 
-template<typename T>
+enum class FifoPolicy
+{
+    DropNewest,         // a push into a full fifo fails
+    OverwriteOldest,    // a push into a full fifo discards the oldest element
+    LatestOnly          // like OverwriteOldest, and pull() skips straight to the newest element
+};
+
+/**
+ single-producer / single-consumer ring of preallocated slots. elements are handed over
+ by swapping, never copied: push() puts the caller's object into a slot and hands back
+ the object that was there, pull() does the same on the way out. the caller's object
+ goes back into the ring, so after prepare() it must keep the same shape (buffer size)
+ as the slots, then nothing allocates.
+
+ every slot has its own sequence number, so the producer can take the oldest slot away
+ from the consumer when the policy allows it, without ever touching a slot the consumer
+ is still swapping.
+ */
+template<typename T, int Capacity = 30, FifoPolicy Policy = FifoPolicy::DropNewest>
 struct Fifo
 {
+    static_assert(Capacity > 1, "a Fifo needs at least two slots");
+
+    Fifo() { reset(); }
+
     void prepare(int numChannels, int numSamples)
     {
         static_assert(std::is_same_v<T, juce::AudioBuffer<float>>,
             "prepare(numChannels, numSamples) should only be used when the Fifo is holding juce::AudioBuffer<float>");
-        for (auto& buffer : buffers)
+        for (auto& slot : slots)
         {
-            buffer.setSize(numChannels,
+            slot.value.setSize(numChannels,
                 numSamples,
                 false,   //keep existing content?
                 true,    //clear extra space?
                 true);   //avoid reallocating?
-            buffer.clear();
+            slot.value.clear();
         }
+        reset();
     }
 
     void prepare(size_t numElements)
     {
         static_assert(std::is_same_v<T, std::vector<float>>,
             "prepare(numElements) should only be used when the Fifo is holding std::vector<float>");
-        for (auto& buffer : buffers)
+        for (auto& slot : slots)
         {
-            buffer.clear();
-            buffer.resize(numElements, 0);
+            slot.value.clear();
+            slot.value.resize(numElements, 0);
         }
+        reset();
+    }
+
+    // prepares every slot with prepareSlot(T&), e.g. to reserve storage up front
+    template<typename Function>
+    void prepareSlots(Function&& prepareSlot)
+    {
+        for (auto& slot : slots)
+            prepareSlot(slot.value);
+        reset();
     }
 
-    bool push(const T& t)
+    // producer: swaps t into the fifo, t comes back holding a recycled slot
+    bool push(T& t, juce::int64 ticks = 0)
     {
-        auto write = fifo.write(1);
-        if (write.blockSize1 > 0)
+        const auto pos = writePos.load(std::memory_order_relaxed);
+        auto& slot = slots[pos % Capacity];
+
+        if (slot.sequence.load(std::memory_order_acquire) != pos)
         {
-            buffers[write.startIndex1] = t;
-            return true;
+            // full: the slot still holds the element from the previous lap
+            overflows.fetch_add(1, std::memory_order_relaxed);
+
+            if constexpr (Policy == FifoPolicy::DropNewest)
+            {
+                return false;
+            }
+            else
+            {
+                // take the oldest element away from the consumer, unless it has just claimed it
+                auto oldest = pos - Capacity;
+                if (!readPos.compare_exchange_strong(oldest, oldest + 1, std::memory_order_acq_rel)
+                    && slot.sequence.load(std::memory_order_acquire) != pos)
+                {
+                    // the consumer is still swapping that slot out, the new element loses
+                    return false;
+                }
+            }
         }
 
-        return false;
+        std::swap(slot.value, t);
+        slot.ticks = ticks;
+        slot.sequence.store(pos + 1, std::memory_order_release);
+        writePos.store(pos + 1, std::memory_order_release);
+        return true;
     }
 
+    // consumer: swaps the oldest element (newest for LatestOnly) into t, t's old contents go back into the ring
     bool pull(T& t)
     {
-        auto read = fifo.read(1);
-        if (read.blockSize1 > 0)
+        juce::int64 ticks;
+        return pull(t, ticks);
+    }
+
+    // ticks is the timestamp the element was pushed with
+    bool pull(T& t, juce::int64& ticks)
+    {
+        if constexpr (Policy == FifoPolicy::LatestOnly)
         {
-            t = buffers[read.startIndex1];
-            return true;
+            while (getNumAvailableForReading() > 1)
+            {
+                if (auto* slot = claim())
+                {
+                    release(*slot);
+                    overflows.fetch_add(1, std::memory_order_relaxed);
+                }
+            }
         }
 
-        return false;
+        auto* slot = claim();
+        if (slot == nullptr)
+            return false;
+
+        std::swap(slot->value, t);
+        ticks = slot->ticks;
+        release(*slot);
+        return true;
     }
 
     int getNumAvailableForReading() const
     {
-        return fifo.getNumReady();
+        // the consumer can claim an element just before writePos moves past it
+        const auto available = (std::ptrdiff_t)(writePos.load(std::memory_order_acquire) - readPos.load(std::memory_order_acquire));
+        return (int)juce::jlimit<std::ptrdiff_t>(0, Capacity, available);
+    }
+
+    // elements that never reached the consumer, since the last prepare()
+    int getNumOverflows() const { return overflows.load(std::memory_order_relaxed); }
+
+    static constexpr int getCapacity() { return Capacity; }
+
+private:
+    struct Slot
+    {
+        T value;
+        juce::int64 ticks = 0;
+        std::atomic<size_t> sequence{ 0 };
+        size_t claimedPosition = 0;
+    };
+
+    std::array<Slot, Capacity> slots;
+    std::atomic<size_t> writePos{ 0 }, readPos{ 0 };
+    std::atomic<int> overflows{ 0 };
+
+    // not thread safe, only while neither side is running
+    void reset()
+    {
+        for (size_t i = 0; i < slots.size(); ++i)
+            slots[i].sequence.store(i, std::memory_order_relaxed);
+
+        writePos.store(0);
+        readPos.store(0);
+        overflows.store(0);
+    }
+
+    Slot* claim()
+    {
+        auto pos = readPos.load(std::memory_order_relaxed);
+        for (;;)
+        {
+            auto& slot = slots[pos % Capacity];
+            if (slot.sequence.load(std::memory_order_acquire) != pos + 1)
+                return nullptr;
+
+            // only fails if the producer has just taken this element, then the next one is tried
+            if (readPos.compare_exchange_weak(pos, pos + 1, std::memory_order_acq_rel))
+            {
+                slot.claimedPosition = pos;
+                return &slot;
+            }
+        }
+    }
+
+    void release(Slot& slot)
+    {
+        slot.sequence.store(slot.claimedPosition + Capacity, std::memory_order_release);
+    }
+};
+
+/**
+ single-producer / single-consumer handoff of the most recent value (triple buffer).
+ the writer fills its private slot and publishes it with one atomic exchange, the
+ reader swaps in the newest published slot. neither side ever blocks or allocates.
+ */
+template<typename T>
+struct LatestValue
+{
+    // writer side: fill this slot, then call publish()
+    T& getWriteSlot() { return slots[writeIndex]; }
+
+    void publish()
+    {
+        writeIndex = state.exchange(writeIndex | newDataFlag, std::memory_order_acq_rel) & indexMask;
     }
+
+    // reader side: returns nullptr if nothing was published since the last pull
+    const T* pull()
+    {
+        if ((state.load(std::memory_order_acquire) & newDataFlag) == 0)
+            return nullptr;
+
+        readIndex = state.exchange(readIndex, std::memory_order_acq_rel) & indexMask;
+        return &slots[readIndex];
+    }
+
 private:
-    static constexpr int Capacity = 30;
-    std::array<T, Capacity> buffers;
-    juce::AbstractFifo fifo{ Capacity };
+    static constexpr int indexMask = 3;
+    static constexpr int newDataFlag = 4;
+
+    std::array<T, 3> slots;
+    int writeIndex = 0;
+    int readIndex = 1;
+    std::atomic<int> state{ 2 };
 };
 
 enum Channel
@@ -84,26 +256,36 @@ template<typename BlockType>
 struct SingleChannelSampleFifo
 {
 public:
-    SingleChannelSampleFifo(Channel ch) : channelToUse(ch)
+    SingleChannelSampleFifo(Channel ch, AnalyzerStats* statsToUse = nullptr) :
+        channelToUse(ch),
+        stats(statsToUse)
     {
         prepared.set(false);
     }
 
+    // does nothing while the buffers are released, i.e. while no editor is open
     void update(const BlockType& buffer)
     {
-        jassert(prepared.get());
-        jassert(buffer.getNumChannels() > channelToUse);
-        auto* channelPtr = buffer.getReadPointer(channelToUse);
+        // prepare() and release() wait for this flag, so the buffers can't vanish mid-block
+        updating.set(true);
 
-        for (int i = 0; i < buffer.getNumSamples(); ++i)
+        if (prepared.get() && buffer.getNumChannels() > channelToUse)
         {
-            pushNextSampleIntoFifo(channelPtr[i]);
+            auto* channelPtr = buffer.getReadPointer(channelToUse);
+
+            for (int i = 0; i < buffer.getNumSamples(); ++i)
+            {
+                pushNextSampleIntoFifo(channelPtr[i]);
+            }
         }
+
+        updating.set(false);
     }
 
+    // safe to call while update() is running on another thread
     void prepare(int bufferSize)
     {
-        prepared.set(false);
+        stopUpdates();
         size.set(bufferSize);
 
 
@@ -117,31 +299,93 @@ public:
         
         audioBufferFifo.prepare(1, bufferSize);
         fifoIndex = 0;
+        lastBufferTicks = 0;
         prepared.set(true);
     }
 
+    // frees every buffer, update() ignores its input until the next prepare()
+    void release()
+    {
+        stopUpdates();
+        size.set(0);
+
+        bufferToFill = BlockType();
+        audioBufferFifo.prepareSlots([](BlockType& slot) { slot = BlockType(); });
+        fifoIndex = 0;
+    }
+
 
 
     int getNumCompleteBuffersAvailable() const { return audioBufferFifo.getNumAvailableForReading(); }
     bool isPrepared() const { return prepared.get(); }
-    int getSize() const { return size.get; }
-    bool getAudioBuffer(BlockType& buf) { return audioBufferFifo.pull(buf); }
+    int getSize() const { return size.get(); }
+    // buffers are swapped out, buf must already be getSize() samples long
+    bool getAudioBuffer(BlockType& buf)
+    {
+        juce::int64 ticks;
+        return getAudioBuffer(buf, ticks);
+    }
+
+    // ticks is when the buffer was completed on the audio thread
+    bool getAudioBuffer(BlockType& buf, juce::int64& ticks)
+    {
+        // like update(), so prepare() and release() can run while the reader is on another thread
+        reading.set(true);
+        auto ok = prepared.get() && buf.getNumSamples() == size.get() && audioBufferFifo.pull(buf, ticks);
+        reading.set(false);
+        return ok;
+    }
+
+    int getNumOverflows() const { return audioBufferFifo.getNumOverflows(); }
+
+    // the ring's buffers plus the one being filled
+    size_t getMemoryUsage() const
+    {
+        return sizeof(*this) + size_t(decltype(audioBufferFifo)::getCapacity() + 1) * (size_t)size.get() * sizeof(float);
+    }
+
+    AnalyzerStats* getStats() const { return stats; }
 
 private:
 
     Channel channelToUse;
     int fifoIndex = 0;
-    Fifo<BlockType> audioBufferFifo;
+
+    // the editor drains the ring every frame, prepare() sizes the buffers so this covers a few frames
+    Fifo<BlockType, 16> audioBufferFifo;
     BlockType bufferToFill;
     juce::Atomic<bool> prepared = false;
+    juce::Atomic<bool> updating = false;
+    juce::Atomic<bool> reading = false;
     juce::Atomic<int> size = 0;
 
+    void stopUpdates()
+    {
+        prepared.set(false);
+
+        // update() is at most one block away from noticing, a reader one pull
+        while (updating.get() || reading.get())
+            std::this_thread::yield();
+    }
+
+    AnalyzerStats* stats;
+    juce::int64 lastBufferTicks = 0;
+
     void pushNextSampleIntoFifo(float sample)
     {
         if (fifoIndex == bufferToFill.getNumSamples())
         {
-            auto ok = audioBufferFifo.push(bufferToFill);
-            juce::ignoreUnused(ok);
+            const auto ticks = AnalyzerStats::now();
+            auto ok = audioBufferFifo.push(bufferToFill, ticks);
+            jassert(bufferToFill.getNumSamples() == size.get()); // a consumer handed back a buffer of the wrong size
+
+            if (stats != nullptr)
+            {
+                stats->recordPush(AnalyzerStats::SampleQueue, ok);
+                stats->record(AnalyzerStats::AudioBlock, lastBufferTicks, ticks);
+            }
+
+            lastBufferTicks = ticks;
             fifoIndex = 0;
         }
         bufferToFill.setSample(0, fifoIndex, sample);
@@ -154,9 +398,17 @@ enum Slope
     Slope_12,
     Slope_24,
     Slope_36,
-    Slope_48
+    Slope_48,
+    Slope_60,
+    Slope_72,
+    Slope_84,
+    Slope_96
 };
 
+// one cut section per 12 dB/oct, whatever the cut's type
+constexpr int numSlopes = Slope_96 + 1;
+static_assert(numSlopes == CutPrototype::maxSections, "every slope needs its prototypes");
+
 // contains parameters for peak, low cut, and high cut filters
 struct ChainSettings
 {
@@ -168,11 +420,91 @@ struct ChainSettings
     // low cut parameters
     float lowCutFreq{ 0 };
     Slope lowCutSlope{ Slope::Slope_12 };
-    
+    CutType lowCutType{ CutType_Butterworth };
 
     // high cut parameters
     float highCutFreq{ 0 };
     Slope highCutSlope{ Slope::Slope_12 };
+    CutType highCutType{ CutType_Butterworth };
+
+    // disabled bands aren't designed or run at all
+    bool lowCutEnabled{ true };
+    bool peakEnabled{ true };
+    bool highCutEnabled{ true };
+};
+
+inline bool operator==(const ChainSettings& a, const ChainSettings& b)
+{
+    return a.peakFreq == b.peakFreq && a.peakGainDB == b.peakGainDB && a.peakQ == b.peakQ
+        && a.lowCutFreq == b.lowCutFreq && a.lowCutSlope == b.lowCutSlope && a.lowCutType == b.lowCutType
+        && a.highCutFreq == b.highCutFreq && a.highCutSlope == b.highCutSlope && a.highCutType == b.highCutType
+        && a.lowCutEnabled == b.lowCutEnabled && a.peakEnabled == b.peakEnabled && a.highCutEnabled == b.highCutEnabled;
+}
+
+inline bool operator!=(const ChainSettings& a, const ChainSettings& b) { return !(a == b); }
+
+// every automatable parameter, in layout order
+enum class Param
+{
+    LowCutFreq,
+    HighCutFreq,
+    PeakFreq,
+    PeakGain,
+    PeakQ,
+    LowCutSlope,
+    HighCutSlope,
+    Morph,
+    MorphEnabled,
+    AutoGain,
+    CrossoverBands,
+    CrossoverFreq1, CrossoverFreq2, CrossoverFreq3, CrossoverFreq4,
+    BandGain1, BandGain2, BandGain3, BandGain4, BandGain5,
+    BandMute1, BandMute2, BandMute3, BandMute4, BandMute5,
+    BandSolo1, BandSolo2, BandSolo3, BandSolo4, BandSolo5,
+    LowCutEnabled,
+    PeakEnabled,
+    HighCutEnabled,
+    Bypass,
+    LowCutType,
+    HighCutType,
+    NumParams
+};
+
+constexpr size_t numParams = static_cast<size_t>(Param::NumParams);
+
+// the index'th of a run of numbered parameters, e.g. getParam(Param::BandGain1, 2) is BandGain3
+constexpr Param getParam(Param first, int index) { return static_cast<Param>(static_cast<int>(first) + index); }
+
+// the one place parameter ID strings live
+const char* getParameterID(Param param);
+
+// what a preset stores and recalls: the three bands. bypass, morph, crossover and auto gain stay where they are
+juce::StringArray getPresetParameterIDs();
+
+// plain parameter values captured in one pass, indexed by Param
+struct ParameterSnapshot
+{
+    std::array<float, numParams> values{};
+
+    float operator[](Param param) const { return values[static_cast<size_t>(param)]; }
+};
+
+/**
+ resolves every parameter's atomic value once, at construction, so nothing on the
+ audio thread or in the editor looks a parameter up by its string ID again.
+ */
+struct ParameterRegistry
+{
+    explicit ParameterRegistry(juce::AudioProcessorValueTreeState& apvts);
+
+    ParameterSnapshot load() const;
+    float load(Param param) const { return values[static_cast<size_t>(param)]->load(std::memory_order_acquire); }
+
+    juce::RangedAudioParameter& getParameter(Param param) const { return *parameters[static_cast<size_t>(param)]; }
+
+private:
+    std::array<std::atomic<float>*, numParams> values{};
+    std::array<juce::RangedAudioParameter*, numParams> parameters{};
 };
 
 enum ChainPositions
@@ -182,71 +514,125 @@ enum ChainPositions
     HighCut
 };
 
-ChainSettings getChainSettings(juce::AudioProcessorValueTreeState& apvts);
+ChainSettings getChainSettings(const ParameterSnapshot& parameters);
+CrossoverSettings getCrossoverSettings(const ParameterSnapshot& parameters);
 
 // float filter alias
    // filter types in IIR use 12 db/Oct cutoff for lowpass / highpass by default
 using Filter = juce::dsp::IIR::Filter<float>;
 
-// chained float filters
-// 1 - 4 filters, results in 12 - 48 db/Oct cutoff for lowpass / highpass
-using CutFilter = juce::dsp::ProcessorChain<Filter, Filter, Filter, Filter>;
+/**
+ 1 - 8 filters, results in 12 - 96 db/Oct cutoff for lowpass / highpass. the sections
+ run in a plain loop over an array rather than as a ProcessorChain of one template
+ slot each, so a steeper cut only costs its extra sections.
+ */
+struct CutFilter
+{
+    static constexpr int maxSections = CutPrototype::maxSections;
+
+    std::array<Filter, maxSections> filters;
+    int numSections = 0;
+
+    void prepare(const juce::dsp::ProcessSpec& spec)
+    {
+        for (auto& filter : filters)
+            filter.prepare(spec);
+    }
+
+    void reset()
+    {
+        for (auto& filter : filters)
+            filter.reset();
+    }
+
+    template<typename ProcessContext>
+    void process(const ProcessContext& context)
+    {
+        if (numSections == 0 || context.isBypassed)
+        {
+            if (context.usesSeparateInputAndOutputBlocks())
+                context.getOutputBlock().copyFrom(context.getInputBlock());
+            return;
+        }
+
+        // like ProcessorChain: the first section reads the input, the rest work in place
+        filters[0].process(context);
+
+        juce::dsp::ProcessContextReplacing<float> replacing(context.getOutputBlock());
+        for (int i = 1; i < numSections; ++i)
+            filters[(size_t)i].process(replacing);
+    }
+};
 
 // declare 2 mono chains to represent full stereo signal
 using MonoChain = juce::dsp::ProcessorChain<CutFilter, Filter, CutFilter>;
 
 using Coefficients = Filter::CoefficientsPtr;
+using CutCoefficients = juce::ReferenceCountedArray<juce::dsp::IIR::Coefficients<float>>;
 void updateCoefficients(Coefficients& old, const Coefficients& replacements);
 
 Coefficients makePeakFilter(const ChainSettings& chainSettings, double sampleRate);
 
-template<int Index, typename ChainType, typename CoefficientType>
-void updateFilter(ChainType& chain, const CoefficientType& coefficients)
-{
-    updateCoefficients(chain.template get<Index>().coefficients, coefficients[Index]);
-    chain.template setBypassed<Index>(false);
-}
+// runs one section per designed coefficient set, sections past the slope are left alone
+void updateCutFilter(CutFilter& filter, const CutCoefficients& coefficients);
 
-template<typename ChainType, typename CoefficientType>
-void updateCutFilter(ChainType& filter, const CoefficientType& coefficients, const Slope& slope)
-{
-    filter.template setBypassed<0>(true);
-    filter.template setBypassed<1>(true);
-    filter.template setBypassed<2>(true);
-    filter.template setBypassed<3>(true);
-
-    if (slope >= Slope_12) {
-        updateFilter<0>(filter, coefficients);
-    }
-    if (slope >= Slope_24) {
-        updateFilter<1>(filter, coefficients);
-    }
-    if (slope >= Slope_36) {
-        updateFilter<2>(filter, coefficients);
-    }
-    if (slope >= Slope_48) {
-        updateFilter<3>(filter, coefficients);
-    }
-}
+// a cut of order (slope + 1) * 2 of the given type, see CutDesign.h
+CutCoefficients makeCutCoefficients(bool highPass, float frequency, double sampleRate, Slope slope, CutType type);
 
 inline auto makeLowCutFilter(const ChainSettings& chainSettings, double sampleRate)
 {
-    return juce::dsp::FilterDesign<float>::designIIRHighpassHighOrderButterworthMethod(
-        chainSettings.lowCutFreq,
-        sampleRate,
-        (chainSettings.lowCutSlope + 1) * 2
-    );
+    return makeCutCoefficients(true, chainSettings.lowCutFreq, sampleRate, chainSettings.lowCutSlope, chainSettings.lowCutType);
 }
 
 inline auto makeHighCutFilter(const ChainSettings& chainSettings, double sampleRate)
 {
-    return juce::dsp::FilterDesign<float>::designIIRLowpassHighOrderButterworthMethod(
-        chainSettings.highCutFreq,
-        sampleRate,
-        (chainSettings.highCutSlope + 1) * 2
-    );
+    return makeCutCoefficients(false, chainSettings.highCutFreq, sampleRate, chainSettings.highCutSlope, chainSettings.highCutType);
 }
 
+// complete set of designed coefficients for one MonoChain
+struct ChainCoefficients
+{
+    ChainSettings settings;
+    double sampleRate{ 0 };
+
+    Coefficients peak;
+    CutCoefficients lowCut, highCut;
+};
+
+ChainCoefficients makeChainCoefficients(const ChainSettings& chainSettings, double sampleRate);
+void applyChainCoefficients(MonoChain& chain, const ChainCoefficients& chainCoefficients);
+
+double getMagnitudeForFrequency(const ChainCoefficients& chainCoefficients, double frequency);
+
+// broadband power gain for pink noise: |H(f)|^2 averaged over a fixed log-frequency grid
+double getPinkNoisePowerGain(const ChainCoefficients& chainCoefficients);
+
+// interpolates in log-frequency, dB and log-Q, slopes and cut types switch over halfway
+ChainSettings interpolateChainSettings(const ChainSettings& from, const ChainSettings& to, float position);
+
+// designs for evenly spaced morph positions between two snapshots
+struct MorphTable
+{
+    static constexpr int numPositions = 129;
+
+    double sampleRate{ 0 };
+    std::array<ChainCoefficients, numPositions> positions;
+
+    bool isValidFor(double rate) const { return sampleRate > 0 && sampleRate == rate; }
+
+    static int getIndex(float morph) { return juce::roundToInt(juce::jlimit(0.f, 1.f, morph) * float(numPositions - 1)); }
+    static float getPosition(int index) { return float(index) / float(numPositions - 1); }
+};
+
+// only bands that differ between the snapshots are designed per position, the rest share one design
+void buildMorphTable(MorphTable& table, const ChainSettings& from, const ChainSettings& to, double sampleRate);
+
+enum MorphSlot
+{
+    MorphA,
+    MorphB
+};
+
 
 //==============================================================================
 /**
@@ -267,6 +653,10 @@ public:
    #endif
 
     void processBlock (juce::AudioBuffer<float>&, juce::MidiBuffer&) override;
+    void processBlockBypassed (juce::AudioBuffer<float>&, juce::MidiBuffer&) override;
+
+    // hosts that bypass through the parameter and the ones that call processBlockBypassed end up in the same fade
+    juce::AudioProcessorParameter* getBypassParameter() const override { return &parameters.getParameter(Param::Bypass); }
 
     //==============================================================================
     juce::AudioProcessorEditor* createEditor() override;
@@ -293,19 +683,155 @@ public:
 
     static juce::AudioProcessorValueTreeState::ParameterLayout createParameterLayout();
     juce::AudioProcessorValueTreeState apvts{*this, nullptr, "Parameters", createParameterLayout()};
+    const ParameterRegistry parameters{ apvts };
+
+    // presets are exposed to the host as programs. the bank is opened by the first call that
+    // needs it, so instances that never touch presets never map (or create) the user's file
+    PresetBank& getPresetBank();
+    int savePreset(const juce::String& name);
+
+    // another bank file, e.g. a temporary one in the harness. message thread, like every preset call
+    void setPresetBankFile(const juce::File& file);
+
+    // snapshots live in the plugin state, the "Morph" parameter crossfades between them
+    void storeMorphSnapshot(MorphSlot slot);
+    bool hasMorphSnapshots() const;
+
+    // what the filters are currently running: the morphed settings when morphing, the parameters otherwise
+    ChainSettings getCurrentChainSettings();
+
+    // writes every band parameter at once, e.g. from a match EQ fit
+    void setChainSettings(const ChainSettings& chainSettings);
+
+    // output loudness and true peak, for the editor and for automated delivery checks
+    LoudnessMeter::Readings getLoudnessReadings() const { return loudnessMeter.getReadings(); }
+    void resetLoudnessMeter() { loudnessMeter.reset(); }
+
+    // staleness and frame loss of the analyzer, from the audio block to the painted path
+    AnalyzerStats analyzerStats;
+
+    // what this instance holds in memory, one line per part
+    juce::StringArray getMemoryReport() const;
+
+    // the analyzer fifos only hold buffers while an editor is open to read them
+    void setAnalyzerActive(bool shouldBeActive);
+
+    // how bounces render when the host flags them non-realtime, stored with the plugin state
+    void setOfflineQuality(OfflineQuality quality);
+    OfflineQuality getOfflineQuality() const { return offlineQuality.load(); }
+
+    // runs very low cuts at 44.1 / 48 kHz when the host runs faster, for a few hundred samples of latency.
+    // stored with the plugin state
+    void setMultirateLowCut(bool shouldBeEnabled);
+    bool getMultirateLowCut() const { return multirateLowCutEnabled.load(); }
 
     using BlockType = juce::AudioBuffer<float>;
-    SingleChannelSampleFifo<BlockType> leftChannelFifo{ Channel::Left };
-    SingleChannelSampleFifo<BlockType> rightChannelFifo{ Channel::Right }; 
+    SingleChannelSampleFifo<BlockType> leftChannelFifo{ Channel::Left, &analyzerStats };
+    SingleChannelSampleFifo<BlockType> rightChannelFifo{ Channel::Right, &analyzerStats }; 
 
 private:
 
-    MonoChain leftChain, rightChain;
-
-    void updatePeakFilter(const ChainSettings& chainSettings);
-    void updateLowCutFilters(const ChainSettings& chainSettings);
-    void updateHighCutFilters(const ChainSettings& chainSettings);
-    void updateFilters();
+    // every parameter read in one acquire pass per block, so the filters, the crossover and the output gain
+    // all see the same values. restoring is set while a state restore is rewriting them
+    struct BlockParameters
+    {
+        ParameterSnapshot values;
+        bool restoring = false;
+    };
+    BlockParameters loadBlockParameters() const;
+
+    bool analyzerActive = false;
+    int analyzerBufferSize = 0;
+    void prepareAnalyzer();
+
+    // the filters' coefficients and state, in one block sized by prepareToPlay
+    DSPArena arena;
+    FilterKernel filterKernel;
+
+    // non-realtime renders switch to this kernel, it takes over filterKernel's state and hands it back.
+    // it hands its own changes over like filterKernel does, with the same fade and pending switch
+    DoubleFilterKernel offlineKernel, fadingOfflineKernel;
+    std::atomic<OfflineQuality> offlineQuality{ OfflineQuality::High };
+    bool renderingOffline = false;
+    ChainSettings offlineSettings;
+    void setRenderingOffline(bool shouldRenderOffline);
+    void renderOffline(juce::AudioBuffer<float>& buffer, OfflineQuality quality, const BlockParameters& blockParameters);
+    void switchOfflineCoefficients(const DoubleKernelCoefficients& designed, const ChainSettings& chainSettings);
+    void processOfflineFilters(float* const* channels, int numChannels, int start, int numSamples);
+
+    // takes the low cut off the kernel while it runs decimated, the audio thread picks up a toggle
+    MultirateLowCut multirateLowCut;
+    std::atomic<bool> multirateLowCutEnabled{ false };
+
+    juce::File presetBankFile{ PresetBank::getDefaultFile() };
+    std::unique_ptr<PresetBank> presetBank;
+    void routeLowCut(KernelCoefficients& designed, const ChainSettings& chainSettings);
+
+    // splits the filtered signal into bands after the EQ and sums them back with their gains
+    Crossover crossover;
+    void applyCrossover(juce::AudioBuffer<float>& buffer, const BlockParameters& blockParameters);
+
+    LoudnessMeter loudnessMeter;
+
+    // coefficients designed on the message thread by a state restore, picked up by the audio thread
+    LatestValue<ChainCoefficients> restoredCoefficients;
+
+    // odd while apvts.replaceState() is running, so the audio thread never designs from a half-restored state
+    std::atomic<int> stateRestoreGeneration{ 0 };
+
+    // wrap anything that rewrites several parameters at once from outside the audio thread
+    void beginStateRestore();
+    void endStateRestore();
+
+    int currentProgram = 0;
+
+    // designed whenever a snapshot, the state or the sample rate changes. that's the message thread, or
+    // whichever thread the host prepares on, so the write side is locked. the audio thread never takes it
+    LatestValue<MorphTable> morphTables;
+    juce::CriticalSection morphTableWriteLock;
+    const MorphTable* morphTable = nullptr;
+    int morphIndex = -1;
+    void updateMorphTable();
+
+    // what the last published table was built from, -1 before the first one
+    ChainSettings morphTableA, morphTableB;
+    double morphTableSampleRate = -1;
+
+    // what the filters are currently running, so unchanged parameters skip the redesign
+    ChainSettings appliedSettings;
+    double appliedSampleRate = 0;
+    void applyToFilters(const ChainCoefficients& chainCoefficients);
+    void designFilters(const ChainSettings& chainSettings);
+
+    // a slope change, a band switched on or off, a section turning transparent or back, or a cut
+    // switching family changes what the sections run, so the cascade as it was keeps running in
+    // fadingKernel and the output crossfades to the new one. costs a second cascade only while fading
+    FilterKernel fadingKernel;
+    int fadeLength = 0;
+    int fadeSamplesRemaining = 0;
+    CutType kernelLowCutType = CutType_Butterworth, kernelHighCutType = CutType_Butterworth;
+    // a change that arrived during a fade, switched to once it is over. the offline kernel redesigns from the settings
+    KernelCoefficients pendingCoefficients;
+    ChainSettings pendingSettings;
+    bool switchPending = false;
+    juce::uint32 getRetypedSections(const ChainSettings& chainSettings) const;
+    void switchCoefficients(const KernelCoefficients& designed, const ChainSettings& chainSettings);
+    void processFilters(juce::AudioBuffer<float>& buffer);
+
+    // auto gain: the inverse of the chain's pink noise power gain, recomputed only when coefficients change
+    float autoGainCompensation = 1.f;
+    juce::SmoothedValue<float, juce::ValueSmoothingTypes::Multiplicative> outputGain;
+    void applyOutputGain(juce::AudioBuffer<float>& buffer, const BlockParameters& blockParameters);
+
+    void updateFilters(const BlockParameters& blockParameters);
+
+    // bypass fades to the dry input, then nothing runs until it's switched off again
+    juce::SmoothedValue<float> wetGain;
+    juce::AudioBuffer<float> dryBuffer;
+    bool bypassed = false;
+    void processAudio(juce::AudioBuffer<float>& buffer, bool hostBypassed);
+    void processEffect(juce::AudioBuffer<float>& buffer, const BlockParameters& blockParameters);
+    void resumeFromBypass();
 
     //==============================================================================
     JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (EQtutAudioProcessor)
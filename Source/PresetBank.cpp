@@ -0,0 +1,290 @@
+/*
+  ==============================================================================
+
+    PresetBank.cpp
+    A preset library stored as one memory-mapped file of fixed-size records.
+
+  ==============================================================================
+*/
+
+#include "PresetBank.h"
+#include <numeric>
+
+namespace
+{
+    // file header: magic, version, number of stored parameters, record size (all uint32, little endian)
+    constexpr juce::uint32 bankMagic = 0x42505145; // "EQPB"
+    constexpr juce::uint32 bankVersion = 1;
+    constexpr int headerSize = 16;
+
+    juce::uint32 readHeaderField(const char* data, int field)
+    {
+        return juce::ByteOrder::littleEndianInt(data + field * 4);
+    }
+
+    // clamps a name so it fits in a record with its null terminator, without splitting a character
+    juce::String fitName(const juce::String& name)
+    {
+        auto fitted = name.trim();
+        while (fitted.getNumBytesAsUTF8() >= (size_t)PresetBank::nameLength)
+            fitted = fitted.dropLastCharacters(1);
+
+        return fitted;
+    }
+
+    void writeName(juce::OutputStream& out, const juce::String& name)
+    {
+        char buffer[PresetBank::nameLength] = {};
+        fitName(name).copyToUTF8(buffer, sizeof(buffer));
+        out.write(buffer, sizeof(buffer));
+    }
+}
+
+PresetBank::PresetBank(juce::AudioProcessorValueTreeState& apvtsToUse, const juce::File& bankFile, const juce::StringArray& parameterIDs) :
+    apvts(apvtsToUse),
+    file(bankFile),
+    presetParameterIDs(parameterIDs)
+{
+    reload();
+}
+
+juce::File PresetBank::getDefaultFile()
+{
+    return juce::File::getSpecialLocation(juce::File::userApplicationDataDirectory)
+        .getChildFile(JucePlugin_Name)
+        .getChildFile("Presets.eqbank");
+}
+
+void PresetBank::reload()
+{
+    mapping.reset();
+    records = nullptr;
+    numPresets = 0;
+    recordSize = 0;
+    storedParameters.clear();
+    nameIndexValid = false;
+
+    if (!file.existsAsFile() && !createFile())
+        return;
+
+    mapping = std::make_unique<juce::MemoryMappedFile>(file, juce::MemoryMappedFile::readOnly);
+    auto* data = static_cast<const char*>(mapping->getData());
+    const auto size = (juce::int64)mapping->getSize();
+
+    if (data == nullptr || size < headerSize
+        || readHeaderField(data, 0) != bankMagic
+        || readHeaderField(data, 1) != bankVersion)
+    {
+        mapping.reset();
+        return;
+    }
+
+    const auto numStoredParameters = (int)readHeaderField(data, 2);
+    recordSize = (int)readHeaderField(data, 3);
+    dataOffset = headerSize + (juce::int64)numStoredParameters * parameterIDLength;
+
+    if (recordSize != nameLength + numStoredParameters * (int)sizeof(float) || size < dataOffset)
+    {
+        mapping.reset();
+        recordSize = 0;
+        return;
+    }
+
+    // resolve the stored parameter IDs once, so recall is just a loop over values. older banks stored every
+    // parameter, the host bypass among them, and those slots are skipped rather than recalled
+    for (int i = 0; i < numStoredParameters; ++i)
+    {
+        auto* id = data + headerSize + i * parameterIDLength;
+        auto paramID = juce::String::fromUTF8(id, (int)(std::find(id, id + parameterIDLength, '\0') - id));
+        storedParameters.push_back(presetParameterIDs.contains(paramID) ? apvts.getParameter(paramID) : nullptr);
+    }
+
+    records = data + dataOffset;
+    numPresets = (int)((size - dataOffset) / recordSize);
+}
+
+bool PresetBank::createFile()
+{
+    if (!file.getParentDirectory().createDirectory())
+        return false;
+
+    juce::Array<juce::RangedAudioParameter*> params;
+    for (auto* p : apvts.processor.getParameters())
+        if (auto* rap = dynamic_cast<juce::RangedAudioParameter*>(p); rap != nullptr && presetParameterIDs.contains(rap->getParameterID()))
+            params.add(rap);
+
+    juce::FileOutputStream out(file);
+    if (out.failedToOpen())
+        return false;
+
+    out.writeInt((int)bankMagic);
+    out.writeInt((int)bankVersion);
+    out.writeInt(params.size());
+    out.writeInt(nameLength + params.size() * (int)sizeof(float));
+
+    for (auto* param : params)
+    {
+        char id[parameterIDLength] = {};
+        param->getParameterID().copyToUTF8(id, sizeof(id));
+        out.write(id, sizeof(id));
+    }
+
+    out.flush();
+    return out.getStatus().wasOk();
+}
+
+juce::String PresetBank::getName(int index) const
+{
+    if (!juce::isPositiveAndBelow(index, numPresets))
+        return {};
+
+    auto* name = getNamePointer(index);
+    auto length = (int)(std::find(name, name + nameLength, '\0') - name);
+    return juce::String::fromUTF8(name, length);
+}
+
+bool PresetBank::recall(int index)
+{
+    if (!juce::isPositiveAndBelow(index, numPresets))
+        return false;
+
+    auto* values = getValues(index);
+    for (size_t i = 0; i < storedParameters.size(); ++i)
+    {
+        if (auto* param = storedParameters[i])
+        {
+            param->beginChangeGesture();
+            param->setValueNotifyingHost(param->convertTo0to1(values[i]));
+            param->endChangeGesture();
+        }
+    }
+
+    return true;
+}
+
+juce::int64 PresetBank::getRecordOffset(int index) const
+{
+    return dataOffset + (juce::int64)index * recordSize;
+}
+
+int PresetBank::save(const juce::String& name)
+{
+    if (recordSize == 0)
+        return -1;
+
+    // the values are gathered before the mapping goes away, some platforms won't grow a mapped file
+    std::vector<float> values;
+    for (auto* param : storedParameters)
+        values.push_back(param != nullptr ? param->convertFrom0to1(param->getValue()) : 0.f);
+
+    const auto newIndex = numPresets;
+    mapping.reset();
+
+    {
+        juce::FileOutputStream out(file);
+        if (out.failedToOpen())
+        {
+            reload();
+            return -1;
+        }
+
+        out.setPosition(getRecordOffset(newIndex));
+        writeName(out, name);
+        out.write(values.data(), values.size() * sizeof(float));
+        out.flush();
+    }
+
+    reload();
+    return newIndex < numPresets ? newIndex : -1;
+}
+
+bool PresetBank::rename(int index, const juce::String& newName)
+{
+    if (!juce::isPositiveAndBelow(index, numPresets))
+        return false;
+
+    mapping.reset();
+
+    {
+        juce::FileOutputStream out(file);
+        if (!out.failedToOpen())
+        {
+            out.setPosition(getRecordOffset(index));
+            writeName(out, newName);
+            out.flush();
+        }
+    }
+
+    reload();
+    return true;
+}
+
+void PresetBank::buildNameIndex() const
+{
+    if (nameIndexValid)
+        return;
+
+    nameIndex.resize((size_t)numPresets);
+    std::iota(nameIndex.begin(), nameIndex.end(), 0);
+
+    std::sort(nameIndex.begin(), nameIndex.end(), [this](int a, int b)
+        {
+            return juce::CharPointer_UTF8(getNamePointer(a)).compareIgnoreCase(juce::CharPointer_UTF8(getNamePointer(b))) < 0;
+        });
+
+    nameIndexValid = true;
+}
+
+juce::Array<int> PresetBank::search(const juce::String& text, int maxResults) const
+{
+    juce::Array<int> results;
+    if (numPresets == 0 || maxResults <= 0)
+        return results;
+
+    buildNameIndex();
+
+    if (text.isEmpty())
+    {
+        for (auto index : nameIndex)
+        {
+            if (results.size() >= maxResults)
+                break;
+            results.add(index);
+        }
+        return results;
+    }
+
+    auto query = text.toUTF8();
+    const auto queryLength = text.length();
+
+    auto comparePrefix = [this, query, queryLength](int index)
+        {
+            return juce::CharPointer_UTF8(getNamePointer(index)).compareIgnoreCaseUpTo(query, queryLength);
+        };
+
+    // prefix matches are a contiguous run of the sorted index
+    auto first = std::partition_point(nameIndex.begin(), nameIndex.end(), [&comparePrefix](int index)
+        {
+            return comparePrefix(index) < 0;
+        });
+
+    for (auto it = first; it != nameIndex.end() && results.size() < maxResults; ++it)
+    {
+        if (comparePrefix(*it) != 0)
+            break;
+        results.add(*it);
+    }
+
+    // then names that contain the text further in
+    for (auto index : nameIndex)
+    {
+        if (results.size() >= maxResults)
+            break;
+
+        juce::CharPointer_UTF8 name(getNamePointer(index));
+        if (comparePrefix(index) != 0 && juce::CharacterFunctions::indexOfIgnoreCase(name, query) > 0)
+            results.add(index);
+    }
+
+    return results;
+}
@@ -0,0 +1,76 @@
+/*
+  ==============================================================================
+
+    PresetBank.h
+    A preset library stored as one memory-mapped file of fixed-size records.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+
+/**
+ the bank file is a small header, the IDs of the parameters it stores, then one
+ fixed-size record per preset: a null padded name followed by the plain value of
+ every stored parameter. recalling preset n is a pointer offset into the mapping,
+ nothing is parsed. the name index used by search() is built lazily, so instances
+ that never open the browser never pay for it.
+ */
+class PresetBank
+{
+public:
+    static constexpr int nameLength = 48;
+    static constexpr int parameterIDLength = 32;
+
+    // only the parameters in presetParameterIDs are stored and recalled
+    PresetBank(juce::AudioProcessorValueTreeState& apvts, const juce::File& bankFile, const juce::StringArray& presetParameterIDs);
+
+    static juce::File getDefaultFile();
+
+    int getNumPresets() const { return numPresets; }
+    juce::String getName(int index) const;
+
+    // writes the stored values into the parameters, call from the message thread
+    bool recall(int index);
+
+    // appends the current parameter values, returns the new preset's index or -1
+    int save(const juce::String& name);
+    bool rename(int index, const juce::String& newName);
+
+    // indices of presets whose names start with or contain text, prefix matches first
+    juce::Array<int> search(const juce::String& text, int maxResults) const;
+
+    // re-maps the file, e.g. after another instance appended to it
+    void reload();
+
+private:
+    juce::AudioProcessorValueTreeState& apvts;
+    juce::File file;
+    juce::StringArray presetParameterIDs;
+
+    std::unique_ptr<juce::MemoryMappedFile> mapping;
+    const char* records = nullptr;
+    int numPresets = 0;
+    int recordSize = 0;
+
+    // stored parameter slot -> live parameter (nullptr if the plugin no longer has it, or presets no longer recall it)
+    std::vector<juce::RangedAudioParameter*> storedParameters;
+
+    // record indices sorted by name, case-insensitive
+    mutable std::vector<int> nameIndex;
+    mutable bool nameIndexValid = false;
+
+    const char* getRecord(int index) const { return records + (size_t)index * (size_t)recordSize; }
+    const char* getNamePointer(int index) const { return getRecord(index); }
+    const float* getValues(int index) const { return reinterpret_cast<const float*>(getRecord(index) + nameLength); }
+
+    bool createFile();
+    void buildNameIndex() const;
+    juce::int64 getRecordOffset(int index) const;
+
+    juce::int64 dataOffset = 0;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(PresetBank)
+};
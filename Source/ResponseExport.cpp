@@ -0,0 +1,228 @@
+/*
+  ==============================================================================
+
+    ResponseExport.cpp
+    Exports the EQ as an impulse response or a magnitude/phase table.
+
+  ==============================================================================
+*/
+
+#include "ResponseExport.h"
+#include <complex>
+
+namespace
+{
+    constexpr juce::uint32 tableMagic = 0x54525145; // "EQRT"
+    constexpr juce::uint32 tableVersion = 1;
+    constexpr int chunkSize = 8192;
+
+    // splits [0, numItems) into chunks and runs them on every core, returns once all are done
+    void parallelForChunks(int numItems, const std::function<void(int start, int end)>& work)
+    {
+        const auto numChunks = (numItems + chunkSize - 1) / chunkSize;
+        if (numChunks <= 1)
+        {
+            work(0, numItems);
+            return;
+        }
+
+        const auto numThreads = juce::jlimit(1, numChunks, juce::SystemStats::getNumCpus());
+        juce::ThreadPool pool(numThreads);
+        juce::WaitableEvent finished;
+        std::atomic<int> nextChunk{ 0 }, remaining{ numThreads };
+
+        // each job keeps taking chunks, so uneven chunks don't leave cores idle
+        for (int t = 0; t < numThreads; ++t)
+        {
+            pool.addJob([&]
+                {
+                    for (int chunk = nextChunk++; chunk < numChunks; chunk = nextChunk++)
+                        work(chunk * chunkSize, juce::jmin(numItems, (chunk + 1) * chunkSize));
+
+                    if (--remaining == 0)
+                        finished.signal();
+                });
+        }
+
+        finished.wait();
+    }
+
+    struct Section
+    {
+        // b[0..order], a[1..order], a0 normalised to 1
+        std::array<double, 3> b{};
+        std::array<double, 3> a{};
+        int order = 0;
+    };
+
+    void addSection(std::vector<Section>& sections, const juce::dsp::IIR::Coefficients<float>& coefficients)
+    {
+        const auto& raw = coefficients.coefficients;
+        const auto order = (raw.size() - 1) / 2;
+
+        Section section;
+        section.order = order;
+        for (int i = 0; i <= order; ++i)
+            section.b[(size_t)i] = raw[i];
+        for (int i = 1; i <= order; ++i)
+            section.a[(size_t)i] = raw[order + i];
+
+        sections.push_back(section);
+    }
+
+    std::vector<Section> getSections(const ChainCoefficients& chainCoefficients)
+    {
+        const auto& settings = chainCoefficients.settings;
+
+        std::vector<Section> sections;
+        if (settings.lowCutEnabled)
+            for (int i = 0; i <= settings.lowCutSlope; ++i)
+                addSection(sections, *chainCoefficients.lowCut[i]);
+
+        if (settings.peakEnabled)
+            addSection(sections, *chainCoefficients.peak);
+
+        if (settings.highCutEnabled)
+            for (int i = 0; i <= settings.highCutSlope; ++i)
+                addSection(sections, *chainCoefficients.highCut[i]);
+
+        return sections;
+    }
+}
+
+std::vector<ResponsePoint> computeResponseTable(const ChainCoefficients& chainCoefficients, int numPoints,
+                                                double minFrequency, double maxFrequency)
+{
+    std::vector<ResponsePoint> table((size_t)juce::jmax(0, numPoints));
+    if (numPoints <= 0)
+        return table;
+
+    const auto sampleRate = chainCoefficients.sampleRate;
+    maxFrequency = juce::jmin(maxFrequency, sampleRate * 0.5 * 0.999);
+    minFrequency = juce::jlimit(1.0e-3, maxFrequency, minFrequency);
+
+    const auto sections = getSections(chainCoefficients);
+    const auto step = numPoints > 1 ? std::log(maxFrequency / minFrequency) / double(numPoints - 1) : 0.0;
+
+    parallelForChunks(numPoints, [&](int start, int end)
+        {
+            for (int i = start; i < end; ++i)
+            {
+                const auto frequency = minFrequency * std::exp(step * double(i));
+                const auto w = juce::MathConstants<double>::twoPi * frequency / sampleRate;
+                const std::complex<double> z1 = std::polar(1.0, -w), z2 = z1 * z1;
+
+                std::complex<double> response(1.0);
+                for (const auto& section : sections)
+                {
+                    auto numerator = section.b[0] + section.b[1] * z1 + section.b[2] * z2;
+                    auto denominator = 1.0 + section.a[1] * z1 + section.a[2] * z2;
+                    response *= numerator / denominator;
+                }
+
+                table[(size_t)i] = { frequency,
+                                     juce::Decibels::gainToDecibels(std::abs(response), -300.0),
+                                     juce::radiansToDegrees(std::arg(response)) };
+            }
+        });
+
+    return table;
+}
+
+juce::AudioBuffer<float> renderImpulseResponse(const ChainSettings& chainSettings, double sampleRate, int length)
+{
+    juce::AudioBuffer<float> impulse(1, juce::jmax(1, length));
+    impulse.clear();
+    impulse.setSample(0, 0, 1.f);
+
+    constexpr int blockSize = 4096;
+
+    juce::dsp::ProcessSpec spec;
+    spec.sampleRate = sampleRate;
+    spec.maximumBlockSize = blockSize;
+    spec.numChannels = 1;
+
+    MonoChain chain;
+    chain.prepare(spec);
+    applyChainCoefficients(chain, makeChainCoefficients(chainSettings, sampleRate));
+
+    juce::dsp::AudioBlock<float> block(impulse);
+    for (size_t start = 0; start < block.getNumSamples(); start += blockSize)
+    {
+        auto subBlock = block.getSubBlock(start, juce::jmin((size_t)blockSize, block.getNumSamples() - start));
+        chain.process(juce::dsp::ProcessContextReplacing<float>(subBlock));
+    }
+
+    return impulse;
+}
+
+bool writeImpulseResponse(const juce::File& file, const ChainSettings& chainSettings, const ResponseExportOptions& options)
+{
+    auto impulse = renderImpulseResponse(chainSettings, options.sampleRate, options.impulseLength);
+
+    file.deleteFile();
+    std::unique_ptr<juce::OutputStream> out = file.createOutputStream();
+    if (out == nullptr)
+        return false;
+
+    juce::WavAudioFormat wav;
+    std::unique_ptr<juce::AudioFormatWriter> writer(wav.createWriterFor(out.get(), options.sampleRate,
+                                                                        1, 32, {}, 0));
+    if (writer == nullptr)
+        return false;
+
+    // the writer owns the stream from here
+    out.release();
+    return writer->writeFromAudioSampleBuffer(impulse, 0, impulse.getNumSamples());
+}
+
+bool writeResponseTable(const juce::File& file, const ChainSettings& chainSettings, const ResponseExportOptions& options,
+                        ResponseTableFormat format)
+{
+    const auto table = computeResponseTable(makeChainCoefficients(chainSettings, options.sampleRate), options.tableSize,
+                                            options.minFrequency, options.maxFrequency);
+
+    file.deleteFile();
+    juce::FileOutputStream out(file);
+    if (out.failedToOpen())
+        return false;
+
+    if (format == ResponseTableFormat::Binary)
+    {
+        out.writeInt((int)tableMagic);
+        out.writeInt((int)tableVersion);
+        out.writeInt((int)table.size());
+
+        for (const auto& point : table)
+        {
+            out.writeDouble(point.frequency);
+            out.writeDouble(point.magnitudeDB);
+            out.writeDouble(point.phaseDegrees);
+        }
+    }
+    else
+    {
+        // formatting dominates for large tables, so the lines are built in parallel chunks too
+        const auto numChunks = ((int)table.size() + chunkSize - 1) / chunkSize;
+        std::vector<juce::MemoryOutputStream> text((size_t)numChunks);
+
+        parallelForChunks((int)table.size(), [&](int start, int end)
+            {
+                auto& chunk = text[(size_t)(start / chunkSize)];
+                for (int i = start; i < end; ++i)
+                {
+                    const auto& point = table[(size_t)i];
+                    chunk << juce::String(point.frequency, 4) << ","
+                          << juce::String(point.magnitudeDB, 4) << ","
+                          << juce::String(point.phaseDegrees, 4) << "\n";
+                }
+            });
+
+        out << "frequency,magnitude_db,phase_deg\n";
+        for (auto& chunk : text)
+            out.write(chunk.getData(), chunk.getDataSize());
+    }
+
+    out.flush();
+    return out.getStatus().wasOk();
+}
@@ -0,0 +1,50 @@
+/*
+  ==============================================================================
+
+    ResponseExport.h
+    Exports the EQ as an impulse response or a magnitude/phase table.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include "PluginProcessor.h"
+
+struct ResponsePoint
+{
+    double frequency;
+    double magnitudeDB;
+    double phaseDegrees;    // wrapped to -180..180
+};
+
+enum class ResponseTableFormat
+{
+    CSV,        // "frequency,magnitude_db,phase_deg" per line
+    Binary      // "EQRT", version, count (uint32), then count * 3 float64, all little endian
+};
+
+struct ResponseExportOptions
+{
+    double sampleRate = 48000;
+    int impulseLength = 16384;
+    int tableSize = 4096;
+    double minFrequency = 20;
+    double maxFrequency = 20000;   // clamped below nyquist
+};
+
+/**
+ complex response of every section at log-spaced points, evaluated in parallel chunks.
+ the sections are read straight from the designed coefficients, so the table is the
+ exact response MonoChain has at that sample rate.
+ */
+std::vector<ResponsePoint> computeResponseTable(const ChainCoefficients& chainCoefficients, int numPoints,
+                                                double minFrequency, double maxFrequency);
+
+// runs a unit impulse through a MonoChain prepared at the export sample rate
+juce::AudioBuffer<float> renderImpulseResponse(const ChainSettings& chainSettings, double sampleRate, int length);
+
+bool writeImpulseResponse(const juce::File& file, const ChainSettings& chainSettings, const ResponseExportOptions& options);
+bool writeResponseTable(const juce::File& file, const ChainSettings& chainSettings, const ResponseExportOptions& options,
+                        ResponseTableFormat format);
@@ -0,0 +1,220 @@
+/*
+  ==============================================================================
+
+    Trace.cpp
+    Scoped trace markers in per-thread rings, dumped as a Chrome trace.
+
+  ==============================================================================
+*/
+
+#include "Trace.h"
+
+// hands a finished thread's ring back for reuse
+struct TraceLog::ThreadSlot
+{
+    ~ThreadSlot()
+    {
+        if (ring != nullptr)
+            TraceLog::getInstance().releaseRing(*ring);
+    }
+
+    ThreadRing* ring = nullptr;
+    bool acquired = false;
+};
+
+TraceLog::TraceLog()
+{
+    // every ring up front, a marker must never allocate
+    rings.reserve((size_t)maxThreads);
+    for (int i = 0; i < maxThreads; ++i)
+    {
+        rings.push_back(std::make_unique<ThreadRing>());
+        rings.back()->threadIndex = i + 1;
+    }
+}
+
+TraceLog& TraceLog::getInstance()
+{
+    static TraceLog log;
+    return log;
+}
+
+TraceLog::ThreadRing* TraceLog::getCurrentThreadRing()
+{
+    // a thread that found no free ring doesn't look again
+    static thread_local ThreadSlot slot;
+    if (!slot.acquired)
+    {
+        slot.acquired = true;
+        slot.ring = acquireRing();
+    }
+
+    return slot.ring;
+}
+
+TraceLog::ThreadRing* TraceLog::acquireRing()
+{
+    for (auto& candidate : rings)
+    {
+        auto expected = false;
+        if (!candidate->inUse.compare_exchange_strong(expected, true))
+            continue;
+
+        auto& ring = *candidate;
+
+        // the previous owner's events would show up on the new thread's track
+        ring.clearedIndex.store(ring.writeIndex.load());
+        ring.name.store(nullptr);
+
+        // the name is only for the trace, it's left out rather than waiting for a writer
+        const juce::ScopedTryLock lock(ringLock);
+        if (lock.isLocked())
+        {
+            auto* messageManager = juce::MessageManager::getInstanceWithoutCreating();
+            if (messageManager != nullptr && messageManager->isThisTheMessageThread())
+                ring.fallbackName = messageThreadName;
+            else if (auto* thread = juce::Thread::getCurrentThread())
+                ring.fallbackName = thread->getThreadName();
+        }
+
+        ring.claimed.store(true);
+        return &ring;
+    }
+
+    numUntracedThreads.fetch_add(1, std::memory_order_relaxed);
+    return nullptr;
+}
+
+void TraceLog::releaseRing(ThreadRing& ring)
+{
+    // dropped here, on the finishing thread, so the next owner never frees it
+    {
+        const juce::ScopedLock lock(ringLock);
+        ring.fallbackName = {};
+    }
+
+    ring.inUse.store(false);
+}
+
+void TraceLog::record(const char* name, juce::int64 startTicks, juce::int64 endTicks)
+{
+    auto* ringPtr = getCurrentThreadRing();
+    if (ringPtr == nullptr)
+        return;
+
+    auto& ring = *ringPtr;
+    const auto index = ring.writeIndex.load(std::memory_order_relaxed);
+    auto& event = ring.events[(size_t)(index % eventsPerThread)];
+    event.name.store(name, std::memory_order_relaxed);
+    event.start.store(startTicks, std::memory_order_relaxed);
+    event.end.store(endTicks, std::memory_order_relaxed);
+
+    ring.writeIndex.store(index + 1, std::memory_order_release);
+}
+
+void TraceLog::setCurrentThreadName(const char* name)
+{
+    auto* ring = getCurrentThreadRing();
+    if (ring != nullptr && ring->name.load(std::memory_order_relaxed) == nullptr)
+        ring->name.store(name, std::memory_order_relaxed);
+}
+
+void TraceLog::clear()
+{
+    const juce::ScopedLock lock(ringLock);
+    for (auto& ring : rings)
+        ring->clearedIndex.store(ring->writeIndex.load());
+}
+
+int TraceLog::getNumThreads() const
+{
+    return (int)std::count_if(rings.begin(), rings.end(), [](const auto& ring) { return ring->claimed.load(); });
+}
+
+bool TraceLog::writeChromeTrace(const juce::File& file) const
+{
+    juce::FileOutputStream out(file);
+    if (out.failedToOpen())
+        return false;
+
+    out.setPosition(0);
+    out.truncate();
+    writeChromeTrace(out);
+    out.flush();
+
+    return out.getStatus().wasOk();
+}
+
+void TraceLog::writeChromeTrace(juce::OutputStream& out) const
+{
+    struct Copy
+    {
+        const char* name;
+        juce::int64 start, end;
+    };
+
+    auto toMicros = [this](juce::int64 ticks)
+        {
+            return juce::String(juce::Time::highResolutionTicksToSeconds(ticks - originTicks) * 1.0e6, 3);
+        };
+
+    const juce::ScopedLock lock(ringLock);
+
+    out << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[";
+    bool first = true;
+
+    auto beginEvent = [&out, &first]()
+        {
+            out << (first ? "\n" : ",\n");
+            first = false;
+        };
+
+    constexpr juce::uint64 capacity = eventsPerThread;
+    std::vector<Copy> copies;
+    copies.reserve(capacity);
+
+    for (const auto& ring : rings)
+    {
+        if (!ring->claimed.load())
+            continue;
+
+        // copy the newest events, then drop the ones the writer lapped while we copied
+        const auto written = ring->writeIndex.load(std::memory_order_acquire);
+        const auto begin = juce::jmax(ring->clearedIndex.load(), written > capacity ? written - capacity : 0);
+
+        copies.clear();
+        for (auto index = begin; index < written; ++index)
+        {
+            const auto& event = ring->events[(size_t)(index % capacity)];
+            copies.push_back({ event.name.load(std::memory_order_relaxed),
+                               event.start.load(std::memory_order_relaxed),
+                               event.end.load(std::memory_order_relaxed) });
+        }
+
+        std::atomic_thread_fence(std::memory_order_acquire);
+        const auto writtenAfter = ring->writeIndex.load(std::memory_order_relaxed);
+        // the writer may be halfway through event writtenAfter, which shares a slot with writtenAfter - capacity
+        const auto firstIntact = writtenAfter + 1 > capacity ? writtenAfter + 1 - capacity : 0;
+        const auto skip = (size_t)juce::jmin<juce::uint64>(copies.size(), firstIntact > begin ? firstIntact - begin : 0);
+
+        const auto tid = juce::String(ring->threadIndex);
+        auto threadName = ring->fallbackName.isNotEmpty() ? ring->fallbackName : "Thread " + tid;
+        if (auto* name = ring->name.load(std::memory_order_relaxed))
+            threadName = name;
+
+        beginEvent();
+        out << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":" << tid
+            << ",\"args\":{\"name\":" << juce::JSON::toString(threadName) << "}}";
+
+        for (auto i = skip; i < copies.size(); ++i)
+        {
+            const auto& copy = copies[i];
+            beginEvent();
+            out << "{\"name\":\"" << copy.name << "\",\"ph\":\"X\",\"pid\":1,\"tid\":" << tid
+                << ",\"ts\":" << toMicros(copy.start)
+                << ",\"dur\":" << juce::String(juce::Time::highResolutionTicksToSeconds(copy.end - copy.start) * 1.0e6, 3) << "}";
+        }
+    }
+
+    out << "\n]}\n";
+}
@@ -0,0 +1,126 @@
+/*
+  ==============================================================================
+
+    Trace.h
+    Scoped trace markers in per-thread rings, dumped as a Chrome trace.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include <atomic>
+
+// set to 0 in the project's preprocessor definitions to compile every marker out
+#ifndef EQTUT_TRACING
+ #define EQTUT_TRACING 1
+#endif
+
+/**
+ every thread that records gets its own ring of the most recent events, so a marker
+ is two tick reads and a few relaxed stores. the rings are allocated up front with the
+ log, a thread's first marker claims a free one with a compare-exchange and never locks
+ or allocates, so the log must be created off the audio thread (the processor does it).
+ the rings are shared by every instance in the process and only read when a trace is
+ written, as Chrome trace JSON (chrome://tracing, Perfetto). a ring left behind by a
+ finished thread is reused by the next new one, threads beyond maxThreads aren't traced.
+ */
+class TraceLog
+{
+public:
+    static constexpr int eventsPerThread = 4096;
+    static constexpr int maxThreads = 16;
+
+    static TraceLog& getInstance();
+
+    // recording is on unless switched off here, markers then cost one relaxed load
+    void setEnabled(bool shouldBeEnabled) { enabled.store(shouldBeEnabled, std::memory_order_relaxed); }
+    bool isEnabled() const { return enabled.load(std::memory_order_relaxed); }
+
+    // name must be a string literal, only the pointer is kept
+    void record(const char* name, juce::int64 startTicks, juce::int64 endTicks);
+
+    // names the calling thread in the trace, the first name given sticks
+    void setCurrentThreadName(const char* name);
+
+    // the events currently in the rings, oldest first per thread
+    bool writeChromeTrace(const juce::File& file) const;
+    void writeChromeTrace(juce::OutputStream& out) const;
+
+    // drops everything recorded so far
+    void clear();
+
+    // threads that have claimed a ring so far, and the ones that found none left
+    int getNumThreads() const;
+    int getNumUntracedThreads() const { return numUntracedThreads.load(std::memory_order_relaxed); }
+
+private:
+    struct Event
+    {
+        std::atomic<const char*> name{ nullptr };
+        std::atomic<juce::int64> start{ 0 }, end{ 0 };
+    };
+
+    struct ThreadRing
+    {
+        std::array<Event, eventsPerThread> events;
+        std::atomic<juce::uint64> writeIndex{ 0 };
+        std::atomic<juce::uint64> clearedIndex{ 0 };
+        std::atomic<bool> inUse{ false }, claimed{ false };
+        std::atomic<const char*> name{ nullptr };
+        juce::String fallbackName;   // only touched under ringLock
+        int threadIndex = 0;
+    };
+
+    struct ThreadSlot;
+
+    TraceLog();
+
+    ThreadRing* getCurrentThreadRing();
+    ThreadRing* acquireRing();
+    void releaseRing(ThreadRing& ring);
+
+    std::atomic<bool> enabled{ true };
+
+    // guards the fallback names and the readers, never taken by a marker
+    juce::CriticalSection ringLock;
+    std::vector<std::unique_ptr<ThreadRing>> rings;
+    std::atomic<int> numUntracedThreads{ 0 };
+    const juce::String messageThreadName{ "Message Thread" };
+
+    const juce::int64 originTicks = juce::Time::getHighResolutionTicks();
+
+    JUCE_DECLARE_NON_COPYABLE(TraceLog)
+};
+
+/** records the time from construction to destruction under a literal name */
+class TraceScope
+{
+public:
+    explicit TraceScope(const char* scopeName) :
+        name(scopeName),
+        start(TraceLog::getInstance().isEnabled() ? juce::Time::getHighResolutionTicks() : 0)
+    {
+    }
+
+    ~TraceScope()
+    {
+        if (start != 0)
+            TraceLog::getInstance().record(name, start, juce::Time::getHighResolutionTicks());
+    }
+
+private:
+    const char* name;
+    const juce::int64 start;
+
+    JUCE_DECLARE_NON_COPYABLE(TraceScope)
+};
+
+#if EQTUT_TRACING
+ #define EQTUT_TRACE_SCOPE(name)        TraceScope JUCE_JOIN_MACRO(traceScope, __LINE__)(name)
+ #define EQTUT_TRACE_THREAD_NAME(name)  TraceLog::getInstance().setCurrentThreadName(name)
+#else
+ #define EQTUT_TRACE_SCOPE(name)
+ #define EQTUT_TRACE_THREAD_NAME(name)
+#endif